@@ -0,0 +1,53 @@
+#version 430
+
+// Builds the list of 16x16 tiles to step this generation: a tile is active if
+// it or one of its eight neighbours (wrapping toroidally) changed last
+// generation. The list header doubles as the glDispatchComputeIndirect command.
+
+layout(local_size_x = 64) in;
+
+layout(std430, binding = 0) readonly buffer Changed_Tiles {
+     uint changed_tiles[];
+};
+
+layout(std430, binding = 1) writeonly buffer Next_Changed_Tiles {
+     uint next_changed_tiles[];
+};
+
+layout(std430, binding = 2) buffer Active_Tiles {
+     uint num_groups_x;
+     uint num_groups_y;
+     uint num_groups_z;
+     uint active_tile_steps_lo;
+     uint active_tile_steps_hi;
+     uint tiles[];
+};
+
+uniform ivec2 tile_count;
+
+void main() {
+     int index = int(gl_GlobalInvocationID.x);
+
+     if (index >= tile_count.x * tile_count.y) {
+        return;
+     }
+
+     next_changed_tiles[index] = 0u;
+
+     ivec2 tile = ivec2(index % tile_count.x, index / tile_count.x);
+     bool is_active = false;
+     for (int dy = -1; dy <= 1; dy++) {
+         for (int dx = -1; dx <= 1; dx++) {
+             ivec2 neighbor = (tile + ivec2(dx, dy) + tile_count) % tile_count;
+             is_active = is_active || changed_tiles[neighbor.y * tile_count.x + neighbor.x] != 0u;
+         }
+     }
+
+     if (is_active) {
+         uint slot = atomicAdd(num_groups_x, 1u);
+         tiles[slot] = uint(index);
+         if (atomicAdd(active_tile_steps_lo, 1u) == 0xFFFFFFFFu) {
+             atomicAdd(active_tile_steps_hi, 1u);
+         }
+     }
+}
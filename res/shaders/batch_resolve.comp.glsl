@@ -0,0 +1,49 @@
+#version 430
+
+// Runs after each batch_step.comp.glsl dispatch, one invocation per universe:
+// advances the status of those still stepping from the accumulated counts and
+// clears the accumulators for the next generation.
+
+layout(local_size_x = 64) in;
+
+// Mirrors Gpu_Universe_Status in gl_batch_engine.c.
+struct Universe_Status {
+     uint generation;
+     uint population;
+     uint period;
+     uint finished;
+     uint next_population;
+     uint changed;
+     uint changed_since_previous;
+     uint pad;
+};
+
+layout(std430, binding = 2) buffer Batch_Status {
+     Universe_Status universes[];
+};
+
+uniform int universe_count;
+// Zero means no limit.
+uniform uint max_generations;
+
+void main() {
+     int layer = int(gl_GlobalInvocationID.x);
+     if (layer >= universe_count) {
+          return;
+     }
+
+     Universe_Status status = universes[layer];
+     if (status.finished == 0u) {
+          status.generation++;
+          status.population = status.next_population;
+          status.period = status.changed == 0u ? 1u : status.changed_since_previous == 0u ? 2u : 0u;
+          bool out_of_generations = max_generations != 0u && status.generation >= max_generations;
+          status.finished = status.period != 0u || out_of_generations ? 1u : 0u;
+     } else if (status.finished == 1u) {
+          status.finished = 2u;
+     }
+     status.next_population = 0u;
+     status.changed = 0u;
+     status.changed_since_previous = 0u;
+     universes[layer] = status;
+}
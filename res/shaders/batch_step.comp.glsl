@@ -0,0 +1,99 @@
+#version 430
+
+// One generation of every universe in a batch: layer z of the array textures
+// is universe z, one invocation per cell. Besides the next cells, each
+// workgroup adds its live cells and whether any cell changed (against this
+// generation, and against the previous one still in output_grids) to the
+// universe's accumulators; batch_resolve.comp.glsl turns those into status.
+// The rule comes from rule.glsl; batches only run two-state rules.
+
+layout(local_size_x = 16, local_size_y = 16) in;
+
+layout(binding = 0, r8) uniform readonly image2DArray input_grids;
+layout(binding = 1, r8) uniform image2DArray output_grids;
+
+// Mirrors Gpu_Universe_Status in gl_batch_engine.c.
+struct Universe_Status {
+     uint generation;
+     uint population;
+     uint period;
+     // 0 while stepping, 1 for the generation that copies the final cells
+     // into the other texture, 2 once both hold them.
+     uint finished;
+     uint next_population;
+     uint changed;
+     uint changed_since_previous;
+     uint pad;
+};
+
+layout(std430, binding = 2) buffer Batch_Status {
+     Universe_Status universes[];
+};
+
+uniform ivec2 grid_size;
+
+shared uint group_population;
+shared uint group_changed;
+shared uint group_changed_since_previous;
+
+void main() {
+     ivec2 cell = ivec2(gl_GlobalInvocationID.xy);
+     int layer = int(gl_GlobalInvocationID.z);
+     uint finished = universes[layer].finished;
+     if (finished == 2u) {
+          return;
+     }
+     bool in_grid = cell.x < grid_size.x && cell.y < grid_size.y;
+     if (finished == 1u) {
+          if (in_grid) {
+               imageStore(output_grids, ivec3(cell, layer), imageLoad(input_grids, ivec3(cell, layer)));
+          }
+          return;
+     }
+
+     if (gl_LocalInvocationIndex == 0u) {
+          group_population = 0u;
+          group_changed = 0u;
+          group_changed_since_previous = 0u;
+     }
+     barrier();
+
+     if (in_grid) {
+          uint alive_neighbors = 0u;
+          for (int dy = -1; dy <= 1; dy++) {
+               for (int dx = -1; dx <= 1; dx++) {
+                    if (dx == 0 && dy == 0) continue;
+                    ivec2 neighbor = (cell + ivec2(dx, dy) + grid_size) % grid_size;
+                    alive_neighbors += uint(decode_state(imageLoad(input_grids, ivec3(neighbor, layer)).r) == 1u);
+               }
+          }
+
+          uint current_state = decode_state(imageLoad(input_grids, ivec3(cell, layer)).r);
+          uint previous_state = decode_state(imageLoad(output_grids, ivec3(cell, layer)).r);
+          uint next = next_state(current_state, alive_neighbors);
+          imageStore(output_grids, ivec3(cell, layer), vec4(encode_state(next), 0.0, 0.0, 1.0));
+
+          if (next == 1u) {
+               atomicAdd(group_population, 1u);
+          }
+          if (next != current_state) {
+               group_changed = 1u;
+          }
+          if (next != previous_state) {
+               group_changed_since_previous = 1u;
+          }
+     }
+     barrier();
+
+     if (gl_LocalInvocationIndex == 0u) {
+          if (group_population != 0u) {
+               atomicAdd(universes[layer].next_population, group_population);
+          }
+          if (group_changed != 0u) {
+               universes[layer].changed = 1u;
+          }
+          if (group_changed_since_previous != 0u) {
+               universes[layer].changed_since_previous = 1u;
+          }
+     }
+}
@@ -1,12 +1,9 @@
 #version 430 core
 
-layout (location = 0) in vec2 aPos;
-
-out vec2 FragPos;
-
-uniform mat4 projection;
+// A quad covering the window, generated from gl_VertexID; the fragment
+// shader works from gl_FragCoord.
 
 void main() {
-    gl_Position = projection * vec4(aPos, 0.0, 1.0);
-    FragPos = aPos;
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
 }
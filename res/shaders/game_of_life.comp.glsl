@@ -1,5 +1,7 @@
 #version 430
 
+// One generation, one invocation per cell. The rule comes from rule.glsl.
+
 layout(local_size_x = 16, local_size_y = 16) in;
 
 layout(binding = 0, r8) uniform image2D input_grid;
@@ -14,7 +16,7 @@ void main() {
         return;
      }
 
-     int alive_neighbors = 0;
+     uint alive_neighbors = 0u;
      for (int dy = -1; dy <= 1; dy++) {
          for (int dx = -1; dx <= 1; dx++) {
              if (dx == 0 && dy == 0) continue;
@@ -22,16 +24,12 @@ void main() {
 
              neighbor = (neighbor + grid_size) % grid_size;
 
-             alive_neighbors += int(imageLoad(input_grid, neighbor).r > 0.5);
+             alive_neighbors += uint(decode_state(imageLoad(input_grid, neighbor).r) == 1u);
          }
      }
 
-     int current_state = int(imageLoad(input_grid, cell).r > 0.5);
-     int next_state = 0;
-     if ((current_state == 1 && (alive_neighbors == 2 || alive_neighbors == 3)) ||
-         (current_state == 0 && alive_neighbors == 3)) {
-         next_state = 1;
-     }
+     uint current_state = decode_state(imageLoad(input_grid, cell).r);
+     uint next = next_state(current_state, alive_neighbors);
 
-     imageStore(output_grid, cell, vec4(next_state, 0.0, 0.0, 1.0));
+     imageStore(output_grid, cell, vec4(encode_state(next), 0.0, 0.0, 1.0));
 }
@@ -0,0 +1,56 @@
+#version 430
+
+// game_of_life.comp.glsl, dispatched indirectly over the active tile list
+// built by active_tiles.comp.glsl. Flags every tile in which a cell changed.
+
+layout(local_size_x = 16, local_size_y = 16) in;
+
+layout(binding = 0, r8) uniform image2D input_grid;
+layout(binding = 1, r8) uniform image2D output_grid;
+
+layout(std430, binding = 1) writeonly buffer Next_Changed_Tiles {
+     uint next_changed_tiles[];
+};
+
+layout(std430, binding = 2) readonly buffer Active_Tiles {
+     uint num_groups_x;
+     uint num_groups_y;
+     uint num_groups_z;
+     uint active_tile_steps_lo;
+     uint active_tile_steps_hi;
+     uint tiles[];
+};
+
+uniform ivec2 grid_size;
+uniform ivec2 tile_count;
+
+void main() {
+     uint tile_index = tiles[gl_WorkGroupID.x];
+     ivec2 tile = ivec2(int(tile_index) % tile_count.x, int(tile_index) / tile_count.x);
+     ivec2 cell = tile * 16 + ivec2(gl_LocalInvocationID.xy);
+
+     if (cell.x >= grid_size.x || cell.y >= grid_size.y) {
+        return;
+     }
+
+     uint alive_neighbors = 0u;
+     for (int dy = -1; dy <= 1; dy++) {
+         for (int dx = -1; dx <= 1; dx++) {
+             if (dx == 0 && dy == 0) continue;
+             ivec2 neighbor = cell + ivec2(dx, dy);
+
+             neighbor = (neighbor + grid_size) % grid_size;
+
+             alive_neighbors += uint(decode_state(imageLoad(input_grid, neighbor).r) == 1u);
+         }
+     }
+
+     uint current_state = decode_state(imageLoad(input_grid, cell).r);
+     uint next = next_state(current_state, alive_neighbors);
+
+     imageStore(output_grid, cell, vec4(encode_state(next), 0.0, 0.0, 1.0));
+
+     if (next != current_state) {
+         next_changed_tiles[tile_index] = 1u;
+     }
+}
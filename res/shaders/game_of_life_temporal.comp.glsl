@@ -0,0 +1,75 @@
+#version 430
+
+// game_of_life.comp.glsl with temporal blocking: each work group loads a
+// 32x32 output tile plus a BLOCK_GENERATIONS-cell halo into shared memory and
+// advances it BLOCK_GENERATIONS generations there. The valid region shrinks by
+// one cell per generation, so only the tile itself is written back.
+// BLOCK_GENERATIONS is injected by the engine.
+
+#ifndef BLOCK_GENERATIONS
+#define BLOCK_GENERATIONS 4
+#endif
+
+#define OUT_TILE 32
+#define SHARED_SIZE (OUT_TILE + 2 * BLOCK_GENERATIONS)
+#define SHARED_CELLS (SHARED_SIZE * SHARED_SIZE)
+#define GROUP_INVOCATIONS 256
+
+layout(local_size_x = 16, local_size_y = 16) in;
+
+layout(binding = 0, r8) uniform image2D input_grid;
+layout(binding = 1, r8) uniform image2D output_grid;
+
+uniform ivec2 grid_size;
+
+// Two generations of the shared tile, ping-ponged.
+shared uint cells[2 * SHARED_CELLS];
+
+void main() {
+     ivec2 origin = ivec2(gl_WorkGroupID.xy) * OUT_TILE - BLOCK_GENERATIONS;
+     // Keeps the wrapped coordinates non-negative even on grids smaller than the halo.
+     ivec2 wrap_offset = grid_size * ((BLOCK_GENERATIONS + grid_size - 1) / grid_size);
+
+     for (uint i = gl_LocalInvocationIndex; i < SHARED_CELLS; i += GROUP_INVOCATIONS) {
+          ivec2 local = ivec2(i % SHARED_SIZE, i / SHARED_SIZE);
+          ivec2 cell = (origin + local + wrap_offset) % grid_size;
+          cells[i] = decode_state(imageLoad(input_grid, cell).r);
+     }
+     memoryBarrierShared();
+     barrier();
+
+     uint src = 0;
+     for (int generation = 1; generation <= BLOCK_GENERATIONS; generation++) {
+          uint dst = SHARED_CELLS - src;
+          for (uint i = gl_LocalInvocationIndex; i < SHARED_CELLS; i += GROUP_INVOCATIONS) {
+               ivec2 local = ivec2(i % SHARED_SIZE, i / SHARED_SIZE);
+               if (any(lessThan(local, ivec2(generation))) ||
+                   any(greaterThanEqual(local, ivec2(SHARED_SIZE - generation)))) {
+                    continue;
+               }
+
+               uint alive_neighbors = 0;
+               for (int dy = -1; dy <= 1; dy++) {
+                    for (int dx = -1; dx <= 1; dx++) {
+                         if (dx == 0 && dy == 0) continue;
+                         alive_neighbors += uint(cells[src + uint((local.y + dy) * SHARED_SIZE + local.x + dx)] == 1u);
+                    }
+               }
+
+               cells[dst + i] = next_state(cells[src + i], alive_neighbors);
+          }
+          memoryBarrierShared();
+          barrier();
+          src = dst;
+     }
+
+     for (uint i = gl_LocalInvocationIndex; i < OUT_TILE * OUT_TILE; i += GROUP_INVOCATIONS) {
+          ivec2 local = ivec2(i % OUT_TILE, i / OUT_TILE);
+          ivec2 cell = origin + BLOCK_GENERATIONS + local;
+          if (cell.x >= grid_size.x || cell.y >= grid_size.y) {
+               continue;
+          }
+          uint state = cells[src + uint((local.y + BLOCK_GENERATIONS) * SHARED_SIZE + local.x + BLOCK_GENERATIONS)];
+          imageStore(output_grid, cell, vec4(encode_state(state), 0.0, 0.0, 1.0));
+     }
+}
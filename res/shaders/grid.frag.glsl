@@ -1,25 +1,45 @@
 #version 430 core
 
-layout(location = 0) in vec2 FragPos;
+// The visible part of the grid, one texel per block of 2^level cells. Texel
+// coordinates are relative to the texture's first texel: texel_origin is the
+// window's top-left corner and grid_rect the grid's extent.
 
 out vec4 FragColor;
 
-uniform float canvas_w;
-uniform float canvas_h;
-uniform int grid_w;
-uniform int grid_h;
+uniform vec2 window_size;
+uniform int level;
+uniform vec2 texel_origin;
+uniform float texels_per_pixel;
+uniform vec4 grid_rect;
 
-layout(binding = 0) uniform sampler2D computed_grid_texture;
+// At level 0 a cell state (see rule.glsl); above it the fraction of the
+// block alive, rounded up from zero for any live cell.
+layout(binding = 0) uniform sampler2D view_texture;
 
-void main() {
-     float x = FragPos.x / canvas_w;
-     float y = FragPos.y / canvas_h;
+const vec4 OFF_GRID = vec4(0.09, 0.07, 0.07, 1.0);
+const vec4 DEAD = vec4(0.15, 0.13, 0.13, 1.0);
+const vec4 DYING = vec4(0.45, 0.3, 0.3, 1.0);
+const vec4 ALIVE = vec4(0.8, 0.7, 0.7, 1.0);
 
-     float s = texture(computed_grid_texture, vec2(x, y)).r;
+void main() {
+     vec2 pixel = vec2(gl_FragCoord.x, window_size.y - gl_FragCoord.y);
+     vec2 texel = texel_origin + pixel * texels_per_pixel;
+     if (any(lessThan(texel, grid_rect.xy)) || any(greaterThanEqual(texel, grid_rect.zw))) {
+          FragColor = OFF_GRID;
+          return;
+     }
 
-     if (s > 0.5) {
-          FragColor = vec4(0.8, 0.7, 0.7, 1.0);
+     float s = texelFetch(view_texture, ivec2(floor(texel)), 0).r;
+     if (level > 0) {
+          // Sparse blocks still show; the square root spreads out the low end.
+          FragColor = s > 0.0 ? mix(DYING, ALIVE, sqrt(s)) : DEAD;
+     } else if (s > 0.998) {
+          // Alive is 1.0; dying states of Generations rules are smaller nonzero
+          // values and are drawn dimmer.
+          FragColor = ALIVE;
+     } else if (s > 0.0) {
+          FragColor = DYING;
      } else {
-          FragColor = vec4(0.15, 0.13, 0.13, 1.0);
+          FragColor = DEAD;
      }
 }
@@ -0,0 +1,82 @@
+#version 430
+
+// Larger than Life, counting each cell's (2r+1)^2 window from a summed-area
+// table of the live cells. The engine compiles this file once per pass, with
+// PASS set to:
+//   1: one invocation per row of the grid padded by RADIUS cells of wrapped
+//      neighbours on each side; writes that row's running sums.
+//   2: one invocation per column; adds the row sums up the column.
+//   3: one invocation per cell; reads its window count from four entries and
+//      applies the rule.
+// The table is (w + 2r + 1) x (h + 2r + 1) with a zero first row and column.
+// Unsigned wraparound keeps the window differences exact even if the totals
+// overflow. rule.glsl supplies the state encoding and dying states.
+
+#if PASS == 3
+layout(local_size_x = 16, local_size_y = 16) in;
+#else
+layout(local_size_x = 64) in;
+#endif
+
+layout(binding = 0, r8) uniform image2D input_grid;
+layout(binding = 1, r8) uniform image2D output_grid;
+
+layout(std430, binding = 0) buffer Window_Sums {
+     uint sums[];
+};
+
+uniform ivec2 grid_size;
+
+void main() {
+     ivec2 padded_size = grid_size + 2 * RADIUS;
+     int sums_w = padded_size.x + 1;
+
+#if PASS == 1
+     int row = int(gl_GlobalInvocationID.x);
+     if (row >= padded_size.y) {
+          return;
+     }
+     int y = (row - RADIUS + grid_size.y) % grid_size.y;
+     uint row_sum = 0u;
+     for (int column = 0; column < padded_size.x; column++) {
+          int x = (column - RADIUS + grid_size.x) % grid_size.x;
+          row_sum += uint(decode_state(imageLoad(input_grid, ivec2(x, y)).r) == 1u);
+          sums[(row + 1) * sums_w + column + 1] = row_sum;
+     }
+#elif PASS == 2
+     int column = int(gl_GlobalInvocationID.x) + 1;
+     if (column > padded_size.x) {
+          return;
+     }
+     uint column_sum = 0u;
+     for (int row = 1; row <= padded_size.y; row++) {
+          column_sum += sums[row * sums_w + column];
+          sums[row * sums_w + column] = column_sum;
+     }
+#else
+     ivec2 cell = ivec2(gl_GlobalInvocationID.xy);
+     if (cell.x >= grid_size.x || cell.y >= grid_size.y) {
+          return;
+     }
+
+     int side = 2 * RADIUS + 1;
+     int top = cell.y * sums_w;
+     int bottom = (cell.y + side) * sums_w;
+     uint count = sums[bottom + cell.x + side] - sums[bottom + cell.x] - sums[top + cell.x + side] + sums[top + cell.x];
+
+     uint state = decode_state(imageLoad(input_grid, cell).r);
+     if (state == 1u && INCLUDE_CENTER == 0) {
+          count--;
+     }
+
+     uint next;
+     if (state == 0u) {
+          next = uint(count >= uint(BIRTH_MIN) && count <= uint(BIRTH_MAX));
+     } else if (state == 1u && count >= uint(SURVIVAL_MIN) && count <= uint(SURVIVAL_MAX)) {
+          next = 1u;
+     } else {
+          next = next_dying_state(state);
+     }
+     imageStore(output_grid, cell, vec4(encode_state(next), 0.0, 0.0, 1.0));
+#endif
+}
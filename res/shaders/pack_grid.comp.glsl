@@ -0,0 +1,34 @@
+#version 430
+
+// Packs the R8 grid texture into Bit_Grid layout as 32-bit words (cell x of a
+// row in bit x % 32 of word x / 32), so readback moves one bit per cell.
+// Only live cells (1.0, see rule.glsl) are set; dying ones read as dead.
+
+layout(local_size_x = 16, local_size_y = 4) in;
+
+layout(binding = 0, r8) uniform readonly image2D input_grid;
+
+layout(std430, binding = 1) writeonly buffer Packed_Grid {
+     uint words[];
+};
+
+uniform ivec2 grid_size;
+uniform int words_per_row;
+
+void main() {
+     int word_x = int(gl_GlobalInvocationID.x);
+     int y = int(gl_GlobalInvocationID.y);
+     if (word_x >= words_per_row || y >= grid_size.y) {
+          return;
+     }
+
+     uint word = 0u;
+     int x_begin = word_x * 32;
+     int x_end = min(x_begin + 32, grid_size.x);
+     for (int x = x_begin; x < x_end; x++) {
+          if (imageLoad(input_grid, ivec2(x, y)).r > 0.998) {
+               word |= 1u << uint(x - x_begin);
+          }
+     }
+     words[y * words_per_row + word_x] = word;
+}
@@ -0,0 +1,41 @@
+// The rule, shared by every stepping shader. The GL engine inserts this file
+// after #version together with the defines that pick the rule:
+//   BIRTH_MASK, SURVIVAL_MASK: bit n set if n live neighbours bring a dead cell
+//     to life or keep a live one alive.
+//   STATES: 2, or more for Generations-style dying states.
+
+#ifndef BIRTH_MASK
+#define BIRTH_MASK 8u
+#endif
+#ifndef SURVIVAL_MASK
+#define SURVIVAL_MASK 12u
+#endif
+#ifndef STATES
+#define STATES 2
+#endif
+
+// Texels hold dead as 0, alive as 1.0 (byte 255) and dying state k as byte k,
+// so anything drawing or packing the grid only needs "== 1.0" for alive.
+uint decode_state(float value) {
+     uint byte_value = uint(value * 255.0 + 0.5);
+     return byte_value == 255u ? 1u : byte_value;
+}
+
+float encode_state(uint state) {
+     return state == 1u ? 1.0 : float(state) / 255.0;
+}
+
+uint next_dying_state(uint state) {
+     return state + 1u < uint(STATES) ? state + 1u : 0u;
+}
+
+// Only live (state 1) cells count as neighbours.
+uint next_state(uint state, uint alive_neighbors) {
+     if (state == 0u) {
+          return (uint(BIRTH_MASK) >> alive_neighbors) & 1u;
+     }
+     if (state == 1u && ((uint(SURVIVAL_MASK) >> alive_neighbors) & 1u) != 0u) {
+          return 1u;
+     }
+     return next_dying_state(state);
+}
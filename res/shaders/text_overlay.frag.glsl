@@ -0,0 +1,14 @@
+#version 430 core
+
+// Light glyphs on a translucent dark panel, blended over the grid.
+
+layout(location = 0) in vec2 TexCoord;
+
+out vec4 FragColor;
+
+layout(binding = 0) uniform sampler2D text_texture;
+
+void main() {
+     float glyph = texture(text_texture, TexCoord).r;
+     FragColor = mix(vec4(0.0, 0.0, 0.0, 0.6), vec4(0.95, 0.9, 0.85, 1.0), glyph);
+}
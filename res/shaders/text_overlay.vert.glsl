@@ -0,0 +1,14 @@
+#version 430 core
+
+// The overlay quad, generated from gl_VertexID: rect is its corner and size
+// in normalised device coordinates.
+
+layout (location = 0) out vec2 TexCoord;
+
+uniform vec4 rect;
+
+void main() {
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    gl_Position = vec4(rect.xy + corner * rect.zw, 0.0, 1.0);
+    TexCoord = vec2(corner.x, 1.0 - corner.y);
+}
@@ -0,0 +1,31 @@
+#version 430
+
+// Expands a Bit_Grid uploaded as 32-bit words (cell x of a row in bit x % 32
+// of word x / 32) into the R8 grid texture.
+
+layout(local_size_x = 16, local_size_y = 4) in;
+
+layout(binding = 1, r8) uniform writeonly image2D output_grid;
+
+layout(std430, binding = 0) readonly buffer Packed_Grid {
+     uint words[];
+};
+
+uniform ivec2 grid_size;
+uniform int words_per_row;
+
+void main() {
+     int word_x = int(gl_GlobalInvocationID.x);
+     int y = int(gl_GlobalInvocationID.y);
+     if (word_x >= words_per_row || y >= grid_size.y) {
+          return;
+     }
+
+     uint word = words[y * words_per_row + word_x];
+     int x_begin = word_x * 32;
+     int x_end = min(x_begin + 32, grid_size.x);
+     for (int x = x_begin; x < x_end; x++) {
+          float alive = float((word >> uint(x - x_begin)) & 1u);
+          imageStore(output_grid, ivec2(x, y), vec4(alive, 0.0, 0.0, 1.0));
+     }
+}
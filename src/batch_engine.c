@@ -0,0 +1,85 @@
+#include "batch_engine.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+
+static const Batch_Engine_Api *g_batch_engine_apis[] = {
+    &g_bitpacked_batch_engine_api,
+    &g_gl_batch_engine_api,
+};
+
+enum { BATCH_ENGINE_API_COUNT = sizeof(g_batch_engine_apis) / sizeof(g_batch_engine_apis[0]) };
+
+const Batch_Engine_Api *find_batch_engine_api(const char *name) {
+    for (int i = 0; i < BATCH_ENGINE_API_COUNT; i++) {
+        if (strcmp(g_batch_engine_apis[i]->name, name) == 0) {
+            return g_batch_engine_apis[i];
+        }
+    }
+    return NULL;
+}
+
+void list_batch_engine_names(char *buffer, int buffer_size) {
+    int offset = 0;
+    buffer[0] = '\0';
+    for (int i = 0; i < BATCH_ENGINE_API_COUNT && offset < buffer_size; i++) {
+        offset += snprintf(buffer + offset, buffer_size - offset, "%s%s",
+                           i > 0 ? ", " : "", g_batch_engine_apis[i]->name);
+    }
+}
+
+Batch_Engine *create_batch_engine(const Batch_Engine_Api *api, int universe_count, int grid_w, int grid_h,
+                                  const Batch_Options *options) {
+    Batch_Engine *batch = xcalloc(1, sizeof(Batch_Engine));
+    batch->api = api;
+    batch->universe_count = universe_count;
+    batch->grid_w = grid_w;
+    batch->grid_h = grid_h;
+    if (options) {
+        batch->options = *options;
+    }
+    batch->rule = options && options->rule ? *options->rule : get_conway_rule();
+    batch->options.rule = &batch->rule;
+
+    if (batch->rule.family != RULE_FAMILY_LIFE || (batch->rule.birth & 1)) {
+        trace_log("Batched engines only run Life-like rules without B0, not %s", batch->rule.name);
+        free(batch);
+        return NULL;
+    }
+    if (!api->init(batch)) {
+        free(batch);
+        return NULL;
+    }
+    return batch;
+}
+
+void destroy_batch_engine(Batch_Engine *batch) {
+    if (!batch) {
+        return;
+    }
+    batch->api->destroy(batch);
+    free(batch);
+}
+
+void seed_batch_universe(Batch_Engine *batch, int universe, const Bit_Grid *grid) {
+    batch->api->seed_universe(batch, universe, grid);
+}
+
+void step_batch_engine(Batch_Engine *batch, uint64_t generations) {
+    batch->api->step(batch, generations);
+}
+
+void read_batch_universe(Batch_Engine *batch, int universe, Bit_Grid *grid) {
+    batch->api->read_universe(batch, universe, grid);
+}
+
+void read_batch_status(Batch_Engine *batch, Universe_Status *status) {
+    batch->api->read_status(batch, status);
+}
+
+size_t get_batch_engine_memory_usage(Batch_Engine *batch) {
+    return batch->api->memory_usage ? batch->api->memory_usage(batch) : 0;
+}
@@ -0,0 +1,91 @@
+#ifndef BATCH_ENGINE_H
+#define BATCH_ENGINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "bit_grid.h"
+#include "rule.h"
+
+// Steps many small independent universes together, for workloads (soup
+// searches, parameter sweeps) where one engine per board would spend most of
+// its time on per-board overhead. All universes share a size and a rule, and
+// live side by side in one structure-of-arrays buffer, so a step is a single
+// parallel loop or dispatch over all of them.
+//
+// Each universe tracks its own generation and population, and finishes when
+// it settles (it equals the previous generation, or the one before that) or
+// reaches Batch_Options.max_generations. A finished universe is frozen while
+// the rest keep stepping, until seed_batch_universe reseeds it in place.
+// Longer periods than 2 run until the generation limit; cycle_detector.h
+// finds those on a single engine.
+//
+// Universes are toroidal and seeded live or dead, like Gol_Engine grids. Only
+// Life-like rules without B0 run batched.
+
+typedef struct Batch_Engine Batch_Engine;
+
+typedef struct {
+    // Worker threads for CPU batches; zero means one per CPU.
+    int thread_count;
+    // Generations after which a universe finishes unsettled; zero means never.
+    uint64_t max_generations;
+    // NULL means B3/S23. Copied into the engine, so it needn't outlive it.
+    const Rule *rule;
+} Batch_Options;
+
+typedef struct {
+    // Generations since the universe was seeded.
+    uint64_t generation;
+    uint64_t population;
+    // 1 once it stopped changing (dying out included), 2 once it repeats
+    // every other generation, 0 while running or if it hit the limit.
+    uint64_t period;
+    bool finished;
+} Universe_Status;
+
+typedef struct {
+    const char *name;
+    // Allocates universe_count universes of grid_w x grid_h, all empty.
+    // Returns false if the engine can't run here (e.g. no GL context).
+    bool (*init)(Batch_Engine *batch);
+    void (*destroy)(Batch_Engine *batch);
+    // Replaces one universe and resets its status; the others are untouched.
+    void (*seed_universe)(Batch_Engine *batch, int universe, const Bit_Grid *grid);
+    void (*step)(Batch_Engine *batch, uint64_t generations);
+    void (*read_universe)(Batch_Engine *batch, int universe, Bit_Grid *grid);
+    // Fills one status per universe.
+    void (*read_status)(Batch_Engine *batch, Universe_Status *status);
+    size_t (*memory_usage)(Batch_Engine *batch);
+} Batch_Engine_Api;
+
+struct Batch_Engine {
+    const Batch_Engine_Api *api;
+    int universe_count;
+    int grid_w;
+    int grid_h;
+    Batch_Options options;
+    Rule rule;
+    void *impl;
+};
+
+extern const Batch_Engine_Api g_bitpacked_batch_engine_api;
+extern const Batch_Engine_Api g_gl_batch_engine_api;
+
+const Batch_Engine_Api *find_batch_engine_api(const char *name);
+void list_batch_engine_names(char *buffer, int buffer_size);
+
+// Returns NULL (and logs why) if the rule isn't batchable or the engine
+// failed to initialize. options may be NULL.
+Batch_Engine *create_batch_engine(const Batch_Engine_Api *api, int universe_count, int grid_w, int grid_h,
+                                  const Batch_Options *options);
+void destroy_batch_engine(Batch_Engine *batch);
+void seed_batch_universe(Batch_Engine *batch, int universe, const Bit_Grid *grid);
+void step_batch_engine(Batch_Engine *batch, uint64_t generations);
+void read_batch_universe(Batch_Engine *batch, int universe, Bit_Grid *grid);
+// On the GPU this waits for the queued steps.
+void read_batch_status(Batch_Engine *batch, Universe_Status *status);
+size_t get_batch_engine_memory_usage(Batch_Engine *batch);
+
+#endif
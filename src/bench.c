@@ -0,0 +1,549 @@
+// Benchmark harness: steps each engine over a matrix of grid sizes, initial
+// densities and generation counts, and writes the timings as JSON so runs
+// from different builds can be diffed for regressions.
+//
+// Every repetition creates a fresh engine and seeds it with the same grid, so
+// repetitions measure the same work and memoizing engines (HashLife) can't
+// answer later repetitions from the cache filled by earlier ones. Only the
+// step itself (plus finish_engine for asynchronous engines) is timed.
+//
+// With --verify, each case's final grid is also checked against the cpu
+// engine stepped from the same seed, and the run fails if any differ. With
+// --unbounded the cpu engine runs on a torus padded so nothing wraps.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "bit_grid.h"
+#include "common.h"
+#include "engine.h"
+#include "gl_util.h"
+#include "life_kernel.h"
+#include "rule.h"
+#include "thread_pool.h"
+
+enum {
+    MAX_LIST_ITEMS = 16,
+    MAX_SAMPLES = 1024,
+
+    DEFAULT_WARMUP_REPS = 1,
+    DEFAULT_REPS = 5,
+    DEFAULT_MAX_REP_SECONDS = 30,
+    DEFAULT_SEED = 1
+};
+
+#define DEFAULT_ENGINES "cpu,bitpacked,hashlife,gl"
+#define DEFAULT_SIZES "1024,4096,16384,65536"
+#define DEFAULT_DENSITIES "0.1,0.5"
+#define DEFAULT_GENERATIONS "16,128"
+#define DEFAULT_OUTPUT "bench.json"
+
+typedef struct {
+    int w, h;
+} Bench_Size;
+
+typedef struct {
+    const char *engine_names[MAX_LIST_ITEMS];
+    int engine_count;
+    Bench_Size sizes[MAX_LIST_ITEMS];
+    int size_count;
+    double densities[MAX_LIST_ITEMS];
+    int density_count;
+    uint64_t generations[MAX_LIST_ITEMS];
+    int generation_count;
+
+    int warmup_reps;
+    int reps;
+    bool verify;
+    double max_rep_seconds;
+    size_t memory_budget_mb;
+    uint64_t seed;
+    const char *kernel_name;
+    const char *output_path;
+    Rule rule;
+    Engine_Options engine_options;
+} Bench_Options;
+
+typedef struct {
+    const Gol_Engine_Api *api;
+    Bench_Size size;
+    double density;
+    uint64_t generations;
+} Bench_Case;
+
+Bench_Options parse_bench_options(int argc, char **argv);
+void print_bench_usage(const char *program);
+int split_list(char *list, char **items, int max_items);
+size_t estimate_case_bytes(const Bench_Case *bench_case);
+size_t get_physical_memory_mb();
+uint64_t get_peak_rss_bytes();
+bool run_bench_case(FILE *out, const Bench_Options *options, const Bench_Case *bench_case);
+void write_skipped_case(FILE *out, const Bench_Case *bench_case, const char *reason);
+
+int main(int argc, char **argv) {
+    Bench_Options options = parse_bench_options(argc, argv);
+
+    if (options.kernel_name && !select_life_kernel(options.kernel_name)) {
+        exit_with_error("Kernel '%s' is unknown or unsupported on this CPU", options.kernel_name);
+    }
+    init_life_kernel();
+    options.engine_options.rule = &options.rule;
+
+    const Gol_Engine_Api *apis[MAX_LIST_ITEMS];
+    for (int i = 0; i < options.engine_count; i++) {
+        apis[i] = find_engine_api(options.engine_names[i]);
+        if (!apis[i]) {
+            char engine_names[256];
+            list_engine_names(engine_names, sizeof(engine_names));
+            exit_with_error("Unknown engine '%s' (available: %s)", options.engine_names[i], engine_names);
+        }
+        if (apis[i] == &g_gl_engine_api && !init_offscreen_gl_context()) {
+            trace_log("No GL 4.3 context available; the gl engine will be skipped");
+        }
+    }
+
+    // Not stdout: progress goes there through trace_log.
+    FILE *out = fopen(options.output_path, "w");
+    if (!out) {
+        exit_with_error("Failed to open '%s' for writing", options.output_path);
+    }
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"kernel\": \"%s\",\n", get_life_kernel_name());
+    fprintf(out, "  \"rule\": \"%s\",\n", options.rule.name);
+    fprintf(out, "  \"cpu_count\": %d,\n", get_online_cpu_count());
+    fprintf(out, "  \"threads\": %d,\n", options.engine_options.thread_count);
+    fprintf(out, "  \"warmup_reps\": %d,\n", options.warmup_reps);
+    fprintf(out, "  \"reps\": %d,\n", options.reps);
+    fprintf(out, "  \"seed\": %llu,\n", (unsigned long long)options.seed);
+    fprintf(out, "  \"results\": [");
+
+    bool first = true;
+    int mismatch_count = 0;
+    for (int e = 0; e < options.engine_count; e++) {
+        for (int s = 0; s < options.size_count; s++) {
+            for (int d = 0; d < options.density_count; d++) {
+                for (int g = 0; g < options.generation_count; g++) {
+                    Bench_Case bench_case = { apis[e], options.sizes[s], options.densities[d], options.generations[g] };
+                    fprintf(out, first ? "\n" : ",\n");
+                    first = false;
+                    mismatch_count += !run_bench_case(out, &options, &bench_case);
+                    fflush(out);
+                }
+            }
+        }
+    }
+
+    fprintf(out, "\n  ]\n}\n");
+    fclose(out);
+    trace_log("Wrote %s", options.output_path);
+
+    destroy_offscreen_gl_context();
+    if (mismatch_count > 0) {
+        exit_with_error("%d case(s) differ from the cpu engine", mismatch_count);
+    }
+    return 0;
+}
+
+Bench_Options parse_bench_options(int argc, char **argv) {
+    Bench_Options options = {0};
+    options.warmup_reps = DEFAULT_WARMUP_REPS;
+    options.reps = DEFAULT_REPS;
+    options.max_rep_seconds = DEFAULT_MAX_REP_SECONDS;
+    options.seed = DEFAULT_SEED;
+    options.rule = get_conway_rule();
+    options.output_path = DEFAULT_OUTPUT;
+
+    // The lists point into these copies, so they have to outlive parsing.
+    static char engines[256] = DEFAULT_ENGINES;
+    static char sizes[256] = DEFAULT_SIZES;
+    static char densities[256] = DEFAULT_DENSITIES;
+    static char generations[256] = DEFAULT_GENERATIONS;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (strcmp(arg, "--engines") == 0 && has_value) {
+            snprintf(engines, sizeof(engines), "%s", argv[++i]);
+        } else if (strcmp(arg, "--sizes") == 0 && has_value) {
+            snprintf(sizes, sizeof(sizes), "%s", argv[++i]);
+        } else if (strcmp(arg, "--densities") == 0 && has_value) {
+            snprintf(densities, sizeof(densities), "%s", argv[++i]);
+        } else if (strcmp(arg, "--generations") == 0 && has_value) {
+            snprintf(generations, sizeof(generations), "%s", argv[++i]);
+        } else if (strcmp(arg, "--warmup") == 0 && has_value) {
+            options.warmup_reps = atoi(argv[++i]);
+        } else if (strcmp(arg, "--reps") == 0 && has_value) {
+            options.reps = atoi(argv[++i]);
+        } else if (strcmp(arg, "--max-rep-seconds") == 0 && has_value) {
+            options.max_rep_seconds = atof(argv[++i]);
+        } else if (strcmp(arg, "--verify") == 0) {
+            options.verify = true;
+        } else if (strcmp(arg, "--budget-mb") == 0 && has_value) {
+            options.memory_budget_mb = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--seed") == 0 && has_value) {
+            options.seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--rule") == 0 && has_value) {
+            if (!parse_rule(argv[++i], &options.rule)) {
+                exit_with_error("Rule '%s' is not supported", argv[i]);
+            }
+        } else if (strcmp(arg, "--kernel") == 0 && has_value) {
+            options.kernel_name = argv[++i];
+        } else if (strcmp(arg, "--output") == 0 && has_value) {
+            options.output_path = argv[++i];
+        } else if (strcmp(arg, "--threads") == 0 && has_value) {
+            options.engine_options.thread_count = atoi(argv[++i]);
+        } else if (strcmp(arg, "--memory-mb") == 0 && has_value) {
+            options.engine_options.memory_limit_mb = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--unbounded") == 0) {
+            options.engine_options.unbounded = true;
+        } else if (strcmp(arg, "--dense") == 0) {
+            options.engine_options.dense = true;
+        } else if (strcmp(arg, "--temporal-block") == 0 && has_value) {
+            options.engine_options.temporal_block_generations = atoi(argv[++i]);
+        } else if (strcmp(arg, "--processes") == 0 && has_value) {
+            options.engine_options.process_count = atoi(argv[++i]);
+        } else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            print_bench_usage(argv[0]);
+            exit(0);
+        } else {
+            print_bench_usage(argv[0]);
+            exit_with_error("Unknown or incomplete argument '%s'", arg);
+        }
+    }
+
+    char *items[MAX_LIST_ITEMS];
+
+    options.engine_count = split_list(engines, items, MAX_LIST_ITEMS);
+    for (int i = 0; i < options.engine_count; i++) {
+        options.engine_names[i] = items[i];
+    }
+
+    options.size_count = split_list(sizes, items, MAX_LIST_ITEMS);
+    for (int i = 0; i < options.size_count; i++) {
+        Bench_Size *size = &options.sizes[i];
+        int fields = sscanf(items[i], "%dx%d", &size->w, &size->h);
+        if (fields == 1) {
+            size->h = size->w;
+        }
+        if (fields < 1 || size->w <= 0 || size->h <= 0) {
+            exit_with_error("Invalid size '%s', expected N or WxH", items[i]);
+        }
+    }
+
+    options.density_count = split_list(densities, items, MAX_LIST_ITEMS);
+    for (int i = 0; i < options.density_count; i++) {
+        options.densities[i] = atof(items[i]);
+        if (options.densities[i] < 0.0 || options.densities[i] > 1.0) {
+            exit_with_error("Invalid density '%s', expected a value in [0, 1]", items[i]);
+        }
+    }
+
+    options.generation_count = split_list(generations, items, MAX_LIST_ITEMS);
+    for (int i = 0; i < options.generation_count; i++) {
+        options.generations[i] = strtoull(items[i], NULL, 10);
+        if (options.generations[i] == 0) {
+            exit_with_error("Invalid generation count '%s'", items[i]);
+        }
+    }
+
+    if (options.reps < 1 || options.reps > MAX_SAMPLES || options.warmup_reps < 0) {
+        exit_with_error("Expected 1..%d reps and a non-negative warmup", MAX_SAMPLES);
+    }
+    if (options.memory_budget_mb == 0) {
+        options.memory_budget_mb = get_physical_memory_mb() / 2;
+    }
+
+    return options;
+}
+
+void print_bench_usage(const char *program) {
+    char engine_names[256];
+    list_engine_names(engine_names, sizeof(engine_names));
+
+    printf("Usage: %s [options]\n", program);
+    printf("Lists are comma-separated; every combination is measured.\n");
+    printf("  --engines LIST         Engines to run (default %s; available: %s)\n", DEFAULT_ENGINES, engine_names);
+    printf("  --sizes LIST           Grid sizes, N or WxH (default %s)\n", DEFAULT_SIZES);
+    printf("  --densities LIST       Initial live-cell fractions (default %s)\n", DEFAULT_DENSITIES);
+    printf("  --generations LIST     Generations per timed rep (default %s)\n", DEFAULT_GENERATIONS);
+    printf("  --warmup N             Untimed reps before measuring (default %d)\n", DEFAULT_WARMUP_REPS);
+    printf("  --reps N               Timed reps per case (default %d)\n", DEFAULT_REPS);
+    printf("  --max-rep-seconds S    Stop repeating a case once a rep takes longer (default %d)\n",
+           DEFAULT_MAX_REP_SECONDS);
+    printf("  --verify               Check every final grid against the cpu engine's; fail if any differ\n");
+    printf("  --budget-mb N          Skip cases expected to need more memory (default: half of RAM)\n");
+    printf("  --seed N               Seed for the initial grids (default %d)\n", DEFAULT_SEED);
+    printf("  --output PATH          JSON destination (default %s)\n", DEFAULT_OUTPUT);
+    printf("  --rule RULE            Rule to step (default B3/S23)\n");
+    printf("  --kernel NAME          Packed CPU kernel: scalar, sse2 or avx2\n");
+    printf("  --threads N            Worker threads for tiled CPU engines\n");
+    printf("  --memory-mb N          Soft memory cap for caching engines (HashLife)\n");
+    printf("  --unbounded            Run engines that support it on an infinite plane\n");
+    printf("  --dense                Step every tile, disabling active-tile tracking\n");
+    printf("  --temporal-block K     Advance K generations per pass over each tile\n");
+    printf("  --processes N          Worker processes for the distributed engine\n");
+}
+
+int split_list(char *list, char **items, int max_items) {
+    int count = 0;
+    for (char *item = strtok(list, ","); item; item = strtok(NULL, ",")) {
+        if (count == max_items) {
+            exit_with_error("Too many list items (at most %d)", max_items);
+        }
+        items[count++] = item;
+    }
+    if (count == 0) {
+        exit_with_error("Empty list argument");
+    }
+    return count;
+}
+
+// Rough peak host memory of a case: the seed grid plus what the engine
+// allocates for this size. HashLife is held near its own --memory-mb soft cap.
+size_t estimate_case_bytes(const Bench_Case *bench_case) {
+    size_t cells = (size_t)bench_case->size.w * bench_case->size.h;
+    size_t seed_bytes = cells / 8;
+    if (bench_case->api == &g_cpu_engine_api) {
+        return seed_bytes + 2 * cells;
+    }
+    if (bench_case->api == &g_bitpacked_engine_api) {
+        return seed_bytes + 2 * (cells / 8);
+    }
+    if (bench_case->api == &g_chunked_engine_api) {
+        // A random seed fills every chunk, plus a frontier ring and headers.
+        return seed_bytes + 2 * (cells / 8) + cells / 32;
+    }
+    if (bench_case->api == &g_gl_engine_api) {
+        // Two R8 textures; readback is packed, like the seed grid.
+        return seed_bytes + 2 * cells;
+    }
+    return seed_bytes;
+}
+
+size_t get_physical_memory_mb() {
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long page_size = sysconf(_SC_PAGESIZE);
+    if (pages <= 0 || page_size <= 0) {
+        return 4096;
+    }
+    return (size_t)pages / (1024 * 1024 / (size_t)page_size);
+}
+
+uint64_t get_peak_rss_bytes() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    // Linux reports kilobytes.
+    return (uint64_t)usage.ru_maxrss * 1024;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+void write_skipped_case(FILE *out, const Bench_Case *bench_case, const char *reason) {
+    trace_log("%s %dx%d density %.3f x%llu: skipped (%s)",
+              bench_case->api->name, bench_case->size.w, bench_case->size.h,
+              bench_case->density, (unsigned long long)bench_case->generations, reason);
+    fprintf(out, "    {\"engine\": \"%s\", \"width\": %d, \"height\": %d, \"density\": %.4f, "
+            "\"generations\": %llu, \"status\": \"skipped\", \"reason\": \"%s\"}",
+            bench_case->api->name, bench_case->size.w, bench_case->size.h,
+            bench_case->density, (unsigned long long)bench_case->generations, reason);
+}
+
+// Steps the cpu engine from seed_grid as the case did and compares the grids.
+// The cpu engine is the reference: one cell at a time, wrapping every
+// neighbour, with no tiles to skip or block.
+//
+// An unbounded engine's window is checked against a cpu torus padded on every
+// side by more than the pattern can spread in the case's generations, so
+// nothing wraps; its whole-plane population must match the torus's too.
+static bool matches_cpu_engine(const Bench_Options *options, const Bench_Case *bench_case,
+                               const Bit_Grid *seed_grid, Gol_Engine *engine) {
+    int64_t pad = 0;
+    if (options->engine_options.unbounded) {
+        int64_t radius = options->rule.family == RULE_FAMILY_LARGER_THAN_LIFE ? options->rule.radius : 1;
+        pad = radius * ((int64_t)bench_case->generations + 1);
+    }
+    int64_t reference_w = bench_case->size.w + 2 * pad;
+    int64_t reference_h = bench_case->size.h + 2 * pad;
+    if (reference_w > INT32_MAX || reference_h > INT32_MAX ||
+        // Two byte-per-cell buffers in the cpu engine.
+        2.0 * (double)reference_w * (double)reference_h / (1024.0 * 1024.0) > (double)options->memory_budget_mb) {
+        exit_with_error("Can't verify %s %dx%d x%llu unbounded: the padded %lldx%lld cpu reference "
+                        "is over the memory budget; use fewer generations",
+                        bench_case->api->name, bench_case->size.w, bench_case->size.h,
+                        (unsigned long long)bench_case->generations,
+                        (long long)reference_w, (long long)reference_h);
+    }
+
+    Engine_Options reference_options = options->engine_options;
+    reference_options.unbounded = false;
+    Gol_Engine *reference = create_engine(&g_cpu_engine_api, (int)reference_w, (int)reference_h,
+                                          &reference_options);
+    if (!reference) {
+        exit_with_error("Failed to initialize engine '%s'", g_cpu_engine_api.name);
+    }
+    Bit_Grid padded_seed = create_bit_grid((int)reference_w, (int)reference_h);
+    for (int y = 0; y < seed_grid->h; y++) {
+        for (int x = 0; x < seed_grid->w; x++) {
+            if (get_bit_grid_cell(seed_grid, x, y)) {
+                set_bit_grid_cell(&padded_seed, (int)(x + pad), (int)(y + pad), true);
+            }
+        }
+    }
+    seed_engine(reference, &padded_seed);
+    step_engine(reference, bench_case->generations);
+
+    Bit_Grid padded_expected = create_bit_grid((int)reference_w, (int)reference_h);
+    Bit_Grid expected = create_bit_grid(bench_case->size.w, bench_case->size.h);
+    Bit_Grid actual = create_bit_grid(bench_case->size.w, bench_case->size.h);
+    read_engine_grid(reference, &padded_expected);
+    for (int y = 0; y < expected.h; y++) {
+        for (int x = 0; x < expected.w; x++) {
+            set_bit_grid_cell(&expected, x, y, get_bit_grid_cell(&padded_expected, (int)(x + pad), (int)(y + pad)));
+        }
+    }
+    read_engine_grid(engine, &actual);
+    bool equal = bit_grids_equal(&expected, &actual);
+    if (!equal) {
+        trace_log("%s %dx%d density %.3f x%llu: final grid differs from the cpu engine's "
+                  "(population %llu, expected %llu)",
+                  bench_case->api->name, bench_case->size.w, bench_case->size.h,
+                  bench_case->density, (unsigned long long)bench_case->generations,
+                  (unsigned long long)count_bit_grid_population(&actual),
+                  (unsigned long long)count_bit_grid_population(&expected));
+    } else if (pad > 0) {
+        uint64_t plane_population = get_engine_population(engine);
+        uint64_t expected_population = count_bit_grid_population(&padded_expected);
+        equal = plane_population == expected_population;
+        if (!equal) {
+            trace_log("%s %dx%d density %.3f x%llu: plane population %llu differs from the cpu engine's %llu",
+                      bench_case->api->name, bench_case->size.w, bench_case->size.h,
+                      bench_case->density, (unsigned long long)bench_case->generations,
+                      (unsigned long long)plane_population, (unsigned long long)expected_population);
+        }
+    }
+
+    free_bit_grid(&padded_seed);
+    free_bit_grid(&padded_expected);
+    free_bit_grid(&expected);
+    free_bit_grid(&actual);
+    destroy_engine(reference);
+    return equal;
+}
+
+// Returns false only if --verify found the final grid wrong.
+bool run_bench_case(FILE *out, const Bench_Options *options, const Bench_Case *bench_case) {
+    size_t estimated_mb = estimate_case_bytes(bench_case) / (1024 * 1024);
+    if (estimated_mb > options->memory_budget_mb) {
+        write_skipped_case(out, bench_case, "over memory budget");
+        return true;
+    }
+
+    Gol_Engine *engine = create_engine(bench_case->api, bench_case->size.w, bench_case->size.h,
+                                       &options->engine_options);
+    if (!engine) {
+        write_skipped_case(out, bench_case, "engine unavailable for this configuration");
+        return true;
+    }
+
+    Bit_Grid seed_grid = create_bit_grid(bench_case->size.w, bench_case->size.h);
+    fill_random_bit_grid_with_density(&seed_grid, bench_case->density, options->seed);
+
+    uint64_t samples[MAX_SAMPLES];
+    int sample_count = 0;
+    bool truncated = false;
+    double max_rep_ns = options->max_rep_seconds * 1e9;
+
+    for (int rep = 0; rep < options->warmup_reps + options->reps; rep++) {
+        if (rep > 0) {
+            destroy_engine(engine);
+            engine = create_engine(bench_case->api, bench_case->size.w, bench_case->size.h,
+                                   &options->engine_options);
+            if (!engine) {
+                write_skipped_case(out, bench_case, "engine failed to reinitialize between repetitions");
+                free_bit_grid(&seed_grid);
+                return true;
+            }
+        }
+        seed_engine(engine, &seed_grid);
+        finish_engine(engine);
+
+        uint64_t start_ns = get_time_ns();
+        step_engine(engine, bench_case->generations);
+        finish_engine(engine);
+        uint64_t elapsed_ns = get_time_ns() - start_ns;
+
+        bool warmup = rep < options->warmup_reps;
+        if (!warmup) {
+            samples[sample_count++] = elapsed_ns;
+        }
+        if ((double)elapsed_ns > max_rep_ns && rep + 1 < options->warmup_reps + options->reps) {
+            // Keep a too-slow warmup as the only sample rather than reporting nothing.
+            if (warmup) {
+                samples[sample_count++] = elapsed_ns;
+            }
+            truncated = true;
+            break;
+        }
+    }
+
+    uint64_t population = get_engine_population(engine);
+    size_t engine_bytes = get_engine_memory_usage(engine);
+    bool verify = options->verify && bench_case->api != &g_cpu_engine_api;
+    bool matches = !verify || matches_cpu_engine(options, bench_case, &seed_grid, engine);
+
+    qsort(samples, sample_count, sizeof(uint64_t), compare_u64);
+    double median_ns = sample_count % 2
+        ? (double)samples[sample_count / 2]
+        : 0.5 * ((double)samples[sample_count / 2 - 1] + (double)samples[sample_count / 2]);
+    // Nearest-rank percentile.
+    uint64_t p95_ns = samples[(int)ceil(0.95 * sample_count) - 1];
+    double cell_updates = (double)bench_case->size.w * bench_case->size.h * (double)bench_case->generations;
+
+    trace_log("%s %dx%d density %.3f x%llu: median %.3f ms, %.3e cell-updates/s%s",
+              bench_case->api->name, bench_case->size.w, bench_case->size.h,
+              bench_case->density, (unsigned long long)bench_case->generations,
+              median_ns / 1e6, cell_updates / (median_ns / 1e9), truncated ? " (truncated)" : "");
+
+    fprintf(out, "    {\"engine\": \"%s\", \"width\": %d, \"height\": %d, \"density\": %.4f, "
+            "\"generations\": %llu, \"status\": \"%s\",\n",
+            bench_case->api->name, bench_case->size.w, bench_case->size.h,
+            bench_case->density, (unsigned long long)bench_case->generations,
+            truncated ? "truncated" : "ok");
+    fprintf(out, "     \"samples_ns\": [");
+    for (int i = 0; i < sample_count; i++) {
+        fprintf(out, "%s%llu", i > 0 ? ", " : "", (unsigned long long)samples[i]);
+    }
+    fprintf(out, "],\n");
+    fprintf(out, "     \"median_ns\": %.0f, \"p95_ns\": %llu, \"min_ns\": %llu,\n",
+            median_ns, (unsigned long long)p95_ns, (unsigned long long)samples[0]);
+    fprintf(out, "     \"cell_updates_per_sec\": %.6e, \"cell_updates_per_sec_p95\": %.6e, "
+            "\"ns_per_cell\": %.6f, \"ns_per_cell_p95\": %.6f,\n",
+            cell_updates / (median_ns / 1e9), cell_updates / ((double)p95_ns / 1e9),
+            median_ns / cell_updates, (double)p95_ns / cell_updates);
+    fprintf(out, "     \"engine_memory_bytes\": %zu, \"peak_rss_bytes\": %llu, \"final_population\": %llu",
+            engine_bytes, (unsigned long long)get_peak_rss_bytes(), (unsigned long long)population);
+    if (verify) {
+        fprintf(out, ", \"matches_cpu\": %s", matches ? "true" : "false");
+    }
+    fprintf(out, "}");
+
+    free_bit_grid(&seed_grid);
+    destroy_engine(engine);
+    return matches;
+}
@@ -0,0 +1,156 @@
+#include "bit_grid.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+
+Bit_Grid create_bit_grid(int w, int h) {
+    Bit_Grid grid = {0};
+    grid.w = w;
+    grid.h = h;
+    grid.words_per_row = (w + 63) / 64;
+    grid.words = xcalloc((size_t)grid.words_per_row * h, sizeof(uint64_t));
+    return grid;
+}
+
+void free_bit_grid(Bit_Grid *grid) {
+    free(grid->words);
+    grid->words = NULL;
+}
+
+void clear_bit_grid(Bit_Grid *grid) {
+    memset(grid->words, 0, (size_t)grid->words_per_row * grid->h * sizeof(uint64_t));
+}
+
+void copy_bit_grid(Bit_Grid *dst, const Bit_Grid *src) {
+    assert(dst->w == src->w && dst->h == src->h);
+    memcpy(dst->words, src->words, (size_t)src->words_per_row * src->h * sizeof(uint64_t));
+}
+
+bool bit_grids_equal(const Bit_Grid *a, const Bit_Grid *b) {
+    if (a->w != b->w || a->h != b->h) {
+        return false;
+    }
+    return memcmp(a->words, b->words, (size_t)a->words_per_row * a->h * sizeof(uint64_t)) == 0;
+}
+
+uint64_t count_bit_grid_population(const Bit_Grid *grid) {
+    size_t word_count = (size_t)grid->words_per_row * grid->h;
+    uint64_t population = 0;
+    for (size_t i = 0; i < word_count; i++) {
+        population += __builtin_popcountll(grid->words[i]);
+    }
+    return population;
+}
+
+uint64_t read_bit_grid_span(const Bit_Grid *grid, int y, int64_t x) {
+    const uint64_t *row = get_bit_grid_row(grid, y);
+    x %= grid->w;
+    if (x < 0) {
+        x += grid->w;
+    }
+    if ((x & 63) == 0 && x + 64 <= grid->w) {
+        return row[x >> 6];
+    }
+
+    uint64_t span = 0;
+    int filled = 0;
+    while (filled < 64) {
+        int bit = (int)(x & 63);
+        int count = 64 - filled;
+        if (count > 64 - bit) {
+            count = 64 - bit;
+        }
+        if (count > grid->w - x) {
+            count = (int)(grid->w - x);
+        }
+        uint64_t mask = count == 64 ? ~0ull : (1ull << count) - 1;
+        span |= ((row[x >> 6] >> bit) & mask) << filled;
+        filled += count;
+        x += count;
+        if (x == grid->w) {
+            x = 0;
+        }
+    }
+    return span;
+}
+
+void set_bit_grid_run(Bit_Grid *grid, int64_t x, int64_t y, uint64_t count) {
+    x %= grid->w;
+    x = x < 0 ? x + grid->w : x;
+    y %= grid->h;
+    y = y < 0 ? y + grid->h : y;
+    if (count > (uint64_t)grid->w) {
+        count = grid->w;
+    }
+
+    uint64_t *row = get_bit_grid_row(grid, (int)y);
+    while (count > 0) {
+        int bit = (int)(x & 63);
+        uint64_t n = 64 - bit;
+        if (n > count) {
+            n = count;
+        }
+        if (n > (uint64_t)(grid->w - x)) {
+            n = grid->w - x;
+        }
+        uint64_t mask = n == 64 ? ~0ull : ((1ull << n) - 1) << bit;
+        row[x >> 6] |= mask;
+        count -= n;
+        x += n;
+        if (x == grid->w) {
+            x = 0;
+        }
+    }
+}
+
+uint64_t hash_bit_grid_region(const Bit_Grid *grid, int y_begin, int y_end, int word_begin, int word_end) {
+    uint64_t hash = 0;
+    for (int y = y_begin; y < y_end; y++) {
+        const uint64_t *row = get_bit_grid_row(grid, y);
+        for (int i = word_begin; i < word_end; i++) {
+            hash += hash_bit_word(row[i], i, y);
+        }
+    }
+    return hash;
+}
+
+void fill_random_bit_grid(Bit_Grid *grid) {
+    clear_bit_grid(grid);
+    for (int y = 0; y < grid->h; y++) {
+        uint64_t *row = get_bit_grid_row(grid, y);
+        for (int x = 0; x < grid->w; x++) {
+            if (rand() % 10 == 0) {
+                row[x >> 6] |= 1ull << (x & 63);
+            }
+        }
+    }
+}
+
+static inline uint64_t next_splitmix64(uint64_t *state) {
+    return mix_hash_bits(*state += 0x9E3779B97F4A7C15ull);
+}
+
+void fill_random_bit_grid_with_density(Bit_Grid *grid, double density, uint64_t seed) {
+    int level = (int)(density * 256.0 + 0.5);
+    level = level < 0 ? 0 : level > 256 ? 256 : level;
+
+    uint64_t state = seed;
+    uint64_t tail_mask = get_bit_grid_tail_mask(grid);
+    for (int y = 0; y < grid->h; y++) {
+        uint64_t *row = get_bit_grid_row(grid, y);
+        for (int i = 0; i < grid->words_per_row; i++) {
+            // Folding in one random word per bit of level, least significant
+            // first, leaves every bit set with probability level / 256.
+            uint64_t word = level == 256 ? ~0ull : 0;
+            for (int bit = 0; bit < 8 && level < 256; bit++) {
+                uint64_t r = next_splitmix64(&state);
+                word = (level >> bit) & 1 ? word | r : word & r;
+            }
+            row[i] = word;
+        }
+        row[grid->words_per_row - 1] &= tail_mask;
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef BIT_GRID_H
+#define BIT_GRID_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// A grid packed 64 cells per word. Cell x of a row lives in bit (x % 64) of
+// word (x / 64); bits past grid_w in the last word of a row are always zero.
+
+typedef struct {
+    int w;
+    int h;
+    int words_per_row;
+    uint64_t *words;
+} Bit_Grid;
+
+Bit_Grid create_bit_grid(int w, int h);
+void free_bit_grid(Bit_Grid *grid);
+void clear_bit_grid(Bit_Grid *grid);
+void copy_bit_grid(Bit_Grid *dst, const Bit_Grid *src);
+bool bit_grids_equal(const Bit_Grid *a, const Bit_Grid *b);
+
+uint64_t count_bit_grid_population(const Bit_Grid *grid);
+
+// Same density as the original texture seeding: each cell alive with p = 1/10,
+// drawn from rand() in row-major order.
+void fill_random_bit_grid(Bit_Grid *grid);
+// Each cell alive with p = density (rounded to 1/256), from a generator
+// seeded by `seed` and independent of rand(). Fast enough for huge grids.
+void fill_random_bit_grid_with_density(Bit_Grid *grid, double density, uint64_t seed);
+
+// Sets `count` cells of row y alive starting at column x, a word at a time.
+// x and y wrap toroidally and may be negative.
+void set_bit_grid_run(Bit_Grid *grid, int64_t x, int64_t y, uint64_t count);
+
+// The 64 cells of row y starting at column x, wrapping toroidally (x may be
+// negative or past the edge), packed like a row word.
+uint64_t read_bit_grid_span(const Bit_Grid *grid, int y, int64_t x);
+
+// State hashes are sums over nonzero words of a mix of the word and its
+// position, so regions hash separately and add up, empty regions contribute
+// nothing, and engines that tile the plane differently agree on a state.
+// word_x is the word column (cell x / 64).
+static inline uint64_t mix_hash_bits(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t hash_bit_word(uint64_t word, int64_t word_x, int64_t y) {
+    if (!word) {
+        return 0;
+    }
+    return mix_hash_bits(word ^ mix_hash_bits((uint64_t)word_x * 0x9E3779B97F4A7C15ull + (uint64_t)y));
+}
+
+// Sum of hash_bit_word over rows [y_begin, y_end) and words
+// [word_begin, word_end).
+uint64_t hash_bit_grid_region(const Bit_Grid *grid, int y_begin, int y_end, int word_begin, int word_end);
+
+static inline uint64_t *get_bit_grid_row(const Bit_Grid *grid, int y) {
+    return grid->words + (size_t)y * grid->words_per_row;
+}
+
+static inline uint64_t get_bit_grid_tail_mask(const Bit_Grid *grid) {
+    int tail_bits = grid->w - (grid->words_per_row - 1) * 64;
+    return tail_bits == 64 ? ~0ull : (1ull << tail_bits) - 1;
+}
+
+static inline bool get_bit_grid_cell(const Bit_Grid *grid, int x, int y) {
+    return (get_bit_grid_row(grid, y)[x >> 6] >> (x & 63)) & 1;
+}
+
+static inline void set_bit_grid_cell(Bit_Grid *grid, int x, int y, bool alive) {
+    uint64_t *word = &get_bit_grid_row(grid, y)[x >> 6];
+    uint64_t bit = 1ull << (x & 63);
+    *word = alive ? (*word | bit) : (*word & ~bit);
+}
+
+static inline uint64_t hash_bit_grid(const Bit_Grid *grid) {
+    return hash_bit_grid_region(grid, 0, grid->h, 0, grid->words_per_row);
+}
+
+#endif
@@ -0,0 +1,332 @@
+// Batched CPU engine: universes packed 64 cells per word, interleaved word by
+// word in groups of BATCH_LANES. Word i of row y of universe u lives at
+//   ((group * grid_h + y) * words_per_row + i) * BATCH_LANES + lane
+// with group = u / BATCH_LANES and lane = u % BATCH_LANES, so the same word of
+// every universe in a group is contiguous and a group row steps as one run of
+// step_life_words, SIMD across universes. Horizontal neighbours are
+// BATCH_LANES words away, vertical ones a row away, and each group is one
+// contiguous block that stays in cache for its whole step.
+//
+// A step is one thread pool job with a task per group, and a task advances
+// its group all the requested generations: universes never interact, so
+// there is no barrier between generations. Each generation also yields every
+// lane's population and whether it differs from the previous generation and
+// from the one before (the back buffer still holds it). A lane that settles
+// or runs out of generations is copied into both buffers and from then on
+// rewritten unchanged; groups whose lanes have all finished are skipped.
+//
+// Rows wrap toroidally at any width: the first and last word of each row
+// step against synthetic neighbour words that carry the wrapped-around cell,
+// and the last word's padding bits are masked off again afterwards.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "batch_engine.h"
+#include "bit_grid.h"
+#include "common.h"
+#include "life_kernel.h"
+#include "thread_pool.h"
+
+enum {
+    // Universes per group: two AVX2 vectors per word position.
+    BATCH_LANES = 8
+};
+
+typedef struct {
+    uint64_t *front;
+    uint64_t *back;
+    int words_per_row;
+    int group_count;
+    size_t group_words;
+    uint64_t tail_mask;
+    Life_Kernel kernel;
+    Thread_Pool *pool;
+    uint64_t step_generations;
+
+    Universe_Status *status;
+    // Per worker: one stepped group row, then the synthetic edge words of
+    // every row of the group.
+    uint64_t *scratch;
+    size_t scratch_words;
+} Bitpacked_Batch;
+
+// Synthetic words for the first and last word of one row, per lane: the west
+// neighbour of word 0, and the centre and east words of the last word.
+typedef struct {
+    uint64_t first_west[BATCH_LANES];
+    uint64_t last_center[BATCH_LANES];
+    uint64_t last_east[BATCH_LANES];
+} Row_Edges;
+
+static uint64_t *get_group_row(const Bitpacked_Batch *packed, uint64_t *buffer, int group, int grid_h, int y) {
+    return buffer + ((size_t)group * grid_h + y) * packed->words_per_row * BATCH_LANES;
+}
+
+static bool bitpacked_batch_init(Batch_Engine *batch) {
+    Bitpacked_Batch *packed = xcalloc(1, sizeof(Bitpacked_Batch));
+    packed->kernel = get_life_kernel(batch->rule.birth, batch->rule.survival);
+    packed->words_per_row = (batch->grid_w + 63) / 64;
+    packed->group_count = (batch->universe_count + BATCH_LANES - 1) / BATCH_LANES;
+    packed->group_words = (size_t)batch->grid_h * packed->words_per_row * BATCH_LANES;
+    int tail_bits = batch->grid_w - (packed->words_per_row - 1) * 64;
+    packed->tail_mask = tail_bits == 64 ? ~0ull : (1ull << tail_bits) - 1;
+
+    size_t buffer_words = (size_t)packed->group_count * packed->group_words;
+    packed->front = xcalloc(buffer_words, sizeof(uint64_t));
+    packed->back = xcalloc(buffer_words, sizeof(uint64_t));
+
+    int thread_count = batch->options.thread_count > 0 ? batch->options.thread_count : get_online_cpu_count();
+    if (thread_count > packed->group_count) {
+        thread_count = packed->group_count;
+    }
+    if (thread_count > 1) {
+        packed->pool = create_thread_pool(thread_count);
+    }
+    int worker_count = packed->pool ? get_thread_pool_size(packed->pool) : 1;
+    packed->scratch_words = (size_t)packed->words_per_row * BATCH_LANES
+        + (size_t)batch->grid_h * sizeof(Row_Edges) / sizeof(uint64_t);
+    packed->scratch = xcalloc((size_t)worker_count * packed->scratch_words, sizeof(uint64_t));
+
+    // Lanes past universe_count pad the last group; they start out finished
+    // so it can still be skipped once the real ones are.
+    packed->status = xcalloc((size_t)packed->group_count * BATCH_LANES, sizeof(Universe_Status));
+    for (int u = batch->universe_count; u < packed->group_count * BATCH_LANES; u++) {
+        packed->status[u].finished = true;
+    }
+
+    batch->impl = packed;
+    return true;
+}
+
+static void bitpacked_batch_destroy(Batch_Engine *batch) {
+    Bitpacked_Batch *packed = batch->impl;
+    destroy_thread_pool(packed->pool);
+    free(packed->front);
+    free(packed->back);
+    free(packed->scratch);
+    free(packed->status);
+    free(packed);
+}
+
+static void bitpacked_batch_seed_universe(Batch_Engine *batch, int universe, const Bit_Grid *grid) {
+    Bitpacked_Batch *packed = batch->impl;
+    int group = universe / BATCH_LANES;
+    int lane = universe % BATCH_LANES;
+
+    uint64_t population = 0;
+    for (int y = 0; y < batch->grid_h; y++) {
+        const uint64_t *in = get_bit_grid_row(grid, y);
+        uint64_t *front = get_group_row(packed, packed->front, group, batch->grid_h, y);
+        uint64_t *back = get_group_row(packed, packed->back, group, batch->grid_h, y);
+        for (int i = 0; i < packed->words_per_row; i++) {
+            front[i * BATCH_LANES + lane] = in[i];
+            back[i * BATCH_LANES + lane] = in[i];
+            population += (uint64_t)__builtin_popcountll(in[i]);
+        }
+    }
+
+    Universe_Status *status = &packed->status[universe];
+    memset(status, 0, sizeof(*status));
+    status->population = population;
+}
+
+static void fill_row_edges(const Bitpacked_Batch *packed, const uint64_t *row, Row_Edges *edges) {
+    int last = packed->words_per_row - 1;
+    int tail_bit = 63 - __builtin_clzll(packed->tail_mask);
+    for (int lane = 0; lane < BATCH_LANES; lane++) {
+        uint64_t first_word = row[lane];
+        uint64_t last_word = row[last * BATCH_LANES + lane];
+        // Cell w - 1 lands in bit 63, where west shifts read their carry.
+        edges->first_west[lane] = last_word << (63 - tail_bit);
+        if (tail_bit == 63) {
+            edges->last_center[lane] = last_word;
+            edges->last_east[lane] = first_word;
+        } else {
+            // Cell 0 goes in the padding bit just past cell w - 1, where the
+            // east shift picks it up.
+            edges->last_center[lane] = last_word | ((first_word & 1) << (tail_bit + 1));
+            edges->last_east[lane] = 0;
+        }
+    }
+}
+
+// Steps one row of a group into out: word 0, the interior words and the last
+// word, each as one step_life_words run across the lanes.
+static void step_group_row(const Bitpacked_Batch *packed, const uint64_t *const rows[3],
+                           const Row_Edges *const edges[3], uint64_t *out) {
+    int last = packed->words_per_row - 1;
+
+    const uint64_t *west[3];
+    const uint64_t *center[3];
+    const uint64_t *east[3];
+    if (last == 0) {
+        for (int r = 0; r < 3; r++) {
+            west[r] = edges[r]->first_west;
+            center[r] = edges[r]->last_center;
+            east[r] = edges[r]->last_east;
+        }
+        step_life_words(&packed->kernel, west, center, east, out, BATCH_LANES);
+        return;
+    }
+
+    for (int r = 0; r < 3; r++) {
+        west[r] = edges[r]->first_west;
+        center[r] = rows[r];
+        east[r] = rows[r] + BATCH_LANES;
+    }
+    step_life_words(&packed->kernel, west, center, east, out, BATCH_LANES);
+
+    if (last > 1) {
+        for (int r = 0; r < 3; r++) {
+            west[r] = rows[r];
+            center[r] = rows[r] + BATCH_LANES;
+            east[r] = rows[r] + 2 * BATCH_LANES;
+        }
+        step_life_words(&packed->kernel, west, center, east, out + BATCH_LANES, (last - 1) * BATCH_LANES);
+    }
+
+    for (int r = 0; r < 3; r++) {
+        west[r] = rows[r] + (last - 1) * BATCH_LANES;
+        center[r] = edges[r]->last_center;
+        east[r] = edges[r]->last_east;
+    }
+    step_life_words(&packed->kernel, west, center, east, out + last * BATCH_LANES, BATCH_LANES);
+}
+
+static void step_group(void *ctx, int task_index, int worker_index) {
+    Batch_Engine *batch = ctx;
+    Bitpacked_Batch *packed = batch->impl;
+    int group = task_index;
+    Universe_Status *status = &packed->status[group * BATCH_LANES];
+    int grid_h = batch->grid_h;
+    int row_words = packed->words_per_row * BATCH_LANES;
+    int last_word_offset = (packed->words_per_row - 1) * BATCH_LANES;
+    uint64_t *stepped = packed->scratch + (size_t)worker_index * packed->scratch_words;
+    Row_Edges *row_edges = (Row_Edges *)(stepped + row_words);
+
+    uint64_t *current = packed->front + (size_t)group * packed->group_words;
+    uint64_t *next = packed->back + (size_t)group * packed->group_words;
+
+    for (uint64_t generation = 0; generation < packed->step_generations; generation++) {
+        bool all_finished = true;
+        for (int lane = 0; lane < BATCH_LANES; lane++) {
+            all_finished = all_finished && status[lane].finished;
+        }
+        if (all_finished) {
+            // Both buffers hold the same cells, so the parity of the
+            // remaining generations doesn't matter.
+            return;
+        }
+
+        uint64_t population[BATCH_LANES] = {0};
+        uint64_t changed[BATCH_LANES] = {0};
+        uint64_t changed_since_previous[BATCH_LANES] = {0};
+        for (int y = 0; y < grid_h; y++) {
+            fill_row_edges(packed, current + (size_t)y * row_words, &row_edges[y]);
+        }
+        for (int y = 0; y < grid_h; y++) {
+            int above = y == 0 ? grid_h - 1 : y - 1;
+            int below = y == grid_h - 1 ? 0 : y + 1;
+            const uint64_t *rows[3] = {
+                current + (size_t)above * row_words,
+                current + (size_t)y * row_words,
+                current + (size_t)below * row_words,
+            };
+            const Row_Edges *edges[3] = { &row_edges[above], &row_edges[y], &row_edges[below] };
+            step_group_row(packed, rows, edges, stepped);
+
+            // next still holds the generation before current.
+            uint64_t *out = next + (size_t)y * row_words;
+            for (int k = 0; k < row_words; k++) {
+                int lane = k % BATCH_LANES;
+                uint64_t word = k >= last_word_offset ? stepped[k] & packed->tail_mask : stepped[k];
+                word = status[lane].finished ? rows[1][k] : word;
+                changed[lane] |= word ^ rows[1][k];
+                changed_since_previous[lane] |= word ^ out[k];
+                population[lane] += (uint64_t)__builtin_popcountll(word);
+                out[k] = word;
+            }
+        }
+
+        for (int lane = 0; lane < BATCH_LANES; lane++) {
+            Universe_Status *lane_status = &status[lane];
+            if (lane_status->finished) {
+                continue;
+            }
+            lane_status->generation++;
+            lane_status->population = population[lane];
+            lane_status->period = !changed[lane] ? 1 : !changed_since_previous[lane] ? 2 : 0;
+            lane_status->finished = lane_status->period > 0 ||
+                (batch->options.max_generations > 0 && lane_status->generation >= batch->options.max_generations);
+            if (lane_status->finished) {
+                // Freeze it: both buffers get the final cells.
+                for (size_t k = lane; k < packed->group_words; k += BATCH_LANES) {
+                    current[k] = next[k];
+                }
+            }
+        }
+
+        uint64_t *temp = current;
+        current = next;
+        next = temp;
+    }
+}
+
+static void bitpacked_batch_step(Batch_Engine *batch, uint64_t generations) {
+    Bitpacked_Batch *packed = batch->impl;
+    if (generations == 0) {
+        return;
+    }
+    packed->step_generations = generations;
+    if (packed->pool) {
+        run_thread_pool_tasks(packed->pool, step_group, batch, packed->group_count);
+    } else {
+        for (int group = 0; group < packed->group_count; group++) {
+            step_group(batch, group, 0);
+        }
+    }
+    if (generations % 2) {
+        uint64_t *temp = packed->front;
+        packed->front = packed->back;
+        packed->back = temp;
+    }
+}
+
+static void bitpacked_batch_read_universe(Batch_Engine *batch, int universe, Bit_Grid *grid) {
+    Bitpacked_Batch *packed = batch->impl;
+    int group = universe / BATCH_LANES;
+    int lane = universe % BATCH_LANES;
+    for (int y = 0; y < batch->grid_h; y++) {
+        const uint64_t *in = get_group_row(packed, packed->front, group, batch->grid_h, y);
+        uint64_t *out = get_bit_grid_row(grid, y);
+        for (int i = 0; i < packed->words_per_row; i++) {
+            out[i] = in[i * BATCH_LANES + lane];
+        }
+    }
+}
+
+static void bitpacked_batch_read_status(Batch_Engine *batch, Universe_Status *status) {
+    Bitpacked_Batch *packed = batch->impl;
+    memcpy(status, packed->status, (size_t)batch->universe_count * sizeof(Universe_Status));
+}
+
+static size_t bitpacked_batch_memory_usage(Batch_Engine *batch) {
+    Bitpacked_Batch *packed = batch->impl;
+    int worker_count = packed->pool ? get_thread_pool_size(packed->pool) : 1;
+    return sizeof(Bitpacked_Batch)
+        + 2 * (size_t)packed->group_count * packed->group_words * sizeof(uint64_t)
+        + (size_t)worker_count * packed->scratch_words * sizeof(uint64_t)
+        + (size_t)packed->group_count * BATCH_LANES * sizeof(Universe_Status);
+}
+
+const Batch_Engine_Api g_bitpacked_batch_engine_api = {
+    .name = "bitpacked",
+    .init = bitpacked_batch_init,
+    .destroy = bitpacked_batch_destroy,
+    .seed_universe = bitpacked_batch_seed_universe,
+    .step = bitpacked_batch_step,
+    .read_universe = bitpacked_batch_read_universe,
+    .read_status = bitpacked_batch_read_status,
+    .memory_usage = bitpacked_batch_memory_usage,
+};
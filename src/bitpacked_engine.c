@@ -0,0 +1,486 @@
+// Headless engine on packed grids: 64 cells per word, stepped by the
+// bit-sliced kernels in life_kernel.c.
+//
+// The grid is cut into tiles of TILE_ROWS x TILE_WORDS words, the CPU analogue
+// of the shader's 16x16 workgroups, and each generation is one thread pool job
+// over all tiles. Tiles read their one-cell halo straight from the shared front
+// buffer (wrapping toroidally) and write only their own cells of the back
+// buffer, so no tile ever waits on another within a generation; the pool's
+// end-of-job barrier is the only synchronisation between generations.
+//
+// Only tiles that may change are stepped: a tile is active if it or one of
+// its eight (toroidal) neighbours changed in the previous generation. A tile
+// that was not active holds the same cells in both buffers, because it did not
+// change last generation and cannot change in this one, so skipping it needs
+// no copy. Engine_Options.dense turns the tracking off.
+//
+// Any Life-like or Generations rule without B0 runs here, bound to its kernel
+// at init. B0 would bring the empty grid (and the zero scratch padding) to
+// life. Generations rules carry their dying-state counter planes (see
+// life_kernel.h) beside each buffer, step one generation per pass and fold
+// the dying cells into the tile hashes.
+//
+// With Engine_Options.temporal_block_generations = k > 1, each tile instead
+// copies itself plus a k-cell halo into per-worker scratch, advances k
+// generations there and writes back once, so the shared grids are read and
+// written once per k generations. A tile whose k-cell neighbourhood did not
+// change over the last block cannot change over the next one. Full tiles are
+// at least k cells across (k <= TILE_ROWS), so that neighbourhood lies in the
+// eight neighbouring tiles, except where the partial last tile row or column
+// is thinner than k: the halo then reaches through it into the tile beyond,
+// which counts as a neighbour too.
+//
+// The state hash is kept per tile. A tile's hash goes stale only when the
+// tile changes, so after the first call hashing costs a pass over the changed
+// tiles plus one add per tile. Incremental readback tracks the tiles changed
+// since the last read the same way and copies only those.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "bit_grid.h"
+#include "common.h"
+#include "engine.h"
+#include "life_kernel.h"
+#include "thread_pool.h"
+
+enum {
+    // 32 rows x 16 words = 4 KiB of input per tile (1024 x 32 cells): the
+    // tile, its halo and its output stay resident in L1/L2, and tiles are
+    // small enough that settled regions are skipped at a useful granularity.
+    TILE_ROWS = 32,
+    TILE_WORDS = 16,
+
+    MAX_BLOCK_GENERATIONS = TILE_ROWS,
+    // One word of halo covers up to 64 cells; two keep the row a multiple of
+    // the AVX2 width so no scalar tail runs.
+    BLOCK_HALO_WORDS = 2,
+    // Scratch rows carry a zero word either side for step_life_row_unwrapped.
+    BLOCK_ROW_WORDS = TILE_WORDS + 2 * BLOCK_HALO_WORDS + 2,
+    BLOCK_SCRATCH_WORDS = (TILE_ROWS + 2 * MAX_BLOCK_GENERATIONS) * BLOCK_ROW_WORDS
+};
+
+typedef struct {
+    Bit_Grid front;
+    Bit_Grid back;
+    int tiles_x;
+    int tiles_y;
+    Thread_Pool *pool;
+
+    // Per tile: did it change in the last generation stepped.
+    uint8_t *tile_changed;
+    int *active_tiles;
+    int active_tile_count;
+    Engine_Stats stats;
+
+    // Per tile: hash_bit_grid_region of its cells, valid unless stale.
+    uint64_t *tile_hashes;
+    uint8_t *tile_hash_stale;
+    // Per tile: changed since the last read_grid_changes.
+    uint8_t *tile_read_stale;
+
+    // Generations per tile pass, and the span the changed flags refer to.
+    int block_generations;
+    int changed_span;
+    // Two scratch tiles per worker for temporal blocking.
+    uint64_t *block_scratch;
+    Life_Kernel kernel;
+
+    // Generations rules: counter planes for front and back; plane_count is 0
+    // for Life-like rules.
+    Generations_Kernel generations_kernel;
+    int plane_count;
+    Bit_Grid front_planes[MAX_GENERATIONS_PLANES];
+    Bit_Grid back_planes[MAX_GENERATIONS_PLANES];
+} Bitpacked_Engine;
+
+static bool bitpacked_engine_supports_rule(const Rule *rule) {
+    return (rule->family == RULE_FAMILY_LIFE || rule->family == RULE_FAMILY_GENERATIONS) && !(rule->birth & 1);
+}
+
+static bool bitpacked_engine_init(Gol_Engine *engine) {
+    Bitpacked_Engine *packed = xcalloc(1, sizeof(Bitpacked_Engine));
+    packed->kernel = get_life_kernel(engine->rule.birth, engine->rule.survival);
+    packed->front = create_bit_grid(engine->grid_w, engine->grid_h);
+    packed->back = create_bit_grid(engine->grid_w, engine->grid_h);
+    if (engine->rule.family == RULE_FAMILY_GENERATIONS) {
+        packed->generations_kernel = get_generations_kernel(engine->rule.birth, engine->rule.survival,
+                                                            engine->rule.states);
+        packed->plane_count = packed->generations_kernel.plane_count;
+        for (int p = 0; p < packed->plane_count; p++) {
+            packed->front_planes[p] = create_bit_grid(engine->grid_w, engine->grid_h);
+            packed->back_planes[p] = create_bit_grid(engine->grid_w, engine->grid_h);
+        }
+    }
+    packed->tiles_x = (packed->front.words_per_row + TILE_WORDS - 1) / TILE_WORDS;
+    packed->tiles_y = (engine->grid_h + TILE_ROWS - 1) / TILE_ROWS;
+
+    int thread_count = engine->options.thread_count;
+    if (thread_count <= 0) {
+        thread_count = get_online_cpu_count();
+    }
+    // More workers than tiles would only spin.
+    int tile_count = packed->tiles_x * packed->tiles_y;
+    if (thread_count > tile_count) {
+        thread_count = tile_count;
+    }
+    if (thread_count > 1) {
+        packed->pool = create_thread_pool(thread_count);
+    }
+
+    packed->tile_changed = xmalloc(tile_count);
+    memset(packed->tile_changed, 1, tile_count);
+    packed->active_tiles = xmalloc(tile_count * sizeof(int));
+    packed->stats.total_tiles = tile_count;
+    packed->tile_hashes = xcalloc(tile_count, sizeof(uint64_t));
+    packed->tile_hash_stale = xmalloc(tile_count);
+    memset(packed->tile_hash_stale, 1, tile_count);
+    packed->tile_read_stale = xmalloc(tile_count);
+    memset(packed->tile_read_stale, 1, tile_count);
+
+    packed->block_generations = engine->options.temporal_block_generations > 1
+        ? engine->options.temporal_block_generations : 1;
+    if (packed->block_generations > MAX_BLOCK_GENERATIONS) {
+        trace_log("Temporal blocking is limited to %d generations per pass", MAX_BLOCK_GENERATIONS);
+        packed->block_generations = MAX_BLOCK_GENERATIONS;
+    }
+    if (packed->block_generations > 1 && packed->plane_count > 0) {
+        trace_log("Temporal blocking doesn't carry Generations states; stepping one generation per pass");
+        packed->block_generations = 1;
+    }
+    if (packed->block_generations > 1) {
+        int worker_count = packed->pool ? get_thread_pool_size(packed->pool) : 1;
+        packed->block_scratch = xcalloc((size_t)worker_count * 2 * BLOCK_SCRATCH_WORDS, sizeof(uint64_t));
+    }
+
+    engine->impl = packed;
+    return true;
+}
+
+static void bitpacked_engine_destroy(Gol_Engine *engine) {
+    Bitpacked_Engine *packed = engine->impl;
+    destroy_thread_pool(packed->pool);
+    free(packed->tile_changed);
+    free(packed->active_tiles);
+    free(packed->tile_hashes);
+    free(packed->tile_hash_stale);
+    free(packed->tile_read_stale);
+    free(packed->block_scratch);
+    free_bit_grid(&packed->front);
+    free_bit_grid(&packed->back);
+    for (int p = 0; p < packed->plane_count; p++) {
+        free_bit_grid(&packed->front_planes[p]);
+        free_bit_grid(&packed->back_planes[p]);
+    }
+    free(packed);
+}
+
+static void bitpacked_engine_seed(Gol_Engine *engine, const Bit_Grid *grid) {
+    Bitpacked_Engine *packed = engine->impl;
+    copy_bit_grid(&packed->front, grid);
+    for (int p = 0; p < packed->plane_count; p++) {
+        clear_bit_grid(&packed->front_planes[p]);
+    }
+    // Both buffers must agree on every tile before any can be skipped.
+    memset(packed->tile_changed, 1, packed->tiles_x * packed->tiles_y);
+    memset(packed->tile_hash_stale, 1, packed->tiles_x * packed->tiles_y);
+    memset(packed->tile_read_stale, 1, packed->tiles_x * packed->tiles_y);
+
+    uint64_t total_tiles = packed->stats.total_tiles;
+    memset(&packed->stats, 0, sizeof(packed->stats));
+    packed->stats.total_tiles = total_tiles;
+}
+
+typedef struct {
+    int y_begin;
+    int y_end;
+    int word_begin;
+    int word_end;
+} Tile_Bounds;
+
+static Tile_Bounds get_tile_bounds(const Bitpacked_Engine *packed, int tile_index) {
+    int tile_x = tile_index % packed->tiles_x;
+    int tile_y = tile_index / packed->tiles_x;
+
+    Tile_Bounds bounds;
+    bounds.y_begin = tile_y * TILE_ROWS;
+    bounds.y_end = bounds.y_begin + TILE_ROWS < packed->front.h ? bounds.y_begin + TILE_ROWS : packed->front.h;
+    bounds.word_begin = tile_x * TILE_WORDS;
+    bounds.word_end = bounds.word_begin + TILE_WORDS < packed->front.words_per_row
+        ? bounds.word_begin + TILE_WORDS : packed->front.words_per_row;
+    return bounds;
+}
+
+static void step_tile(void *ctx, int task_index, int worker_index) {
+    (void)worker_index;
+
+    Bitpacked_Engine *packed = ctx;
+    int tile_index = packed->active_tiles[task_index];
+    Tile_Bounds bounds = get_tile_bounds(packed, tile_index);
+
+    if (packed->plane_count > 0) {
+        packed->tile_changed[tile_index] =
+            step_generations_region(&packed->generations_kernel, &packed->front, packed->front_planes,
+                                    &packed->back, packed->back_planes,
+                                    bounds.y_begin, bounds.y_end, bounds.word_begin, bounds.word_end);
+        return;
+    }
+    packed->tile_changed[tile_index] =
+        step_life_region(&packed->kernel, &packed->front, &packed->back,
+                         bounds.y_begin, bounds.y_end, bounds.word_begin, bounds.word_end);
+}
+
+static void step_tile_block(void *ctx, int task_index, int worker_index) {
+    Bitpacked_Engine *packed = ctx;
+    int tile_index = packed->active_tiles[task_index];
+    Tile_Bounds bounds = get_tile_bounds(packed, tile_index);
+    const Bit_Grid *front = &packed->front;
+    int halo = packed->block_generations;
+
+    int rows = bounds.y_end - bounds.y_begin + 2 * halo;
+    int words = bounds.word_end - bounds.word_begin + 2 * BLOCK_HALO_WORDS;
+    uint64_t *current = packed->block_scratch + (size_t)worker_index * 2 * BLOCK_SCRATCH_WORDS;
+    uint64_t *next = current + BLOCK_SCRATCH_WORDS;
+
+    // Scratch row r holds grid row y_begin - halo + r; scratch word j holds the
+    // 64 cells from (word_begin - BLOCK_HALO_WORDS + j) * 64, both wrapping.
+    // Word -1 and word `words` of each row are never written and stay zero.
+    // Words that lie whole inside the row are copied; only the wrap and the
+    // partial tail word need read_bit_grid_span.
+    int whole_words = front->w / 64;
+    for (int r = 0; r < rows; r++) {
+        int y = (bounds.y_begin - halo + r) % front->h;
+        y = y < 0 ? y + front->h : y;
+        const uint64_t *in = get_bit_grid_row(front, y);
+        uint64_t *scratch_row = current + r * BLOCK_ROW_WORDS + 1;
+        for (int j = 0; j < words; j++) {
+            int word = bounds.word_begin - BLOCK_HALO_WORDS + j;
+            scratch_row[j] = word >= 0 && word < whole_words
+                ? in[word] : read_bit_grid_span(front, y, (int64_t)word * 64);
+        }
+    }
+
+    // Junk from the unwrapped scratch edges creeps in one cell per generation,
+    // so the rows stepped shrink by one at each end and the halo absorbs it.
+    for (int generation = 1; generation <= halo; generation++) {
+        for (int r = generation; r < rows - generation; r++) {
+            uint64_t *row = current + r * BLOCK_ROW_WORDS + 1;
+            step_life_row_unwrapped(&packed->kernel, row - BLOCK_ROW_WORDS, row, row + BLOCK_ROW_WORDS,
+                                    next + r * BLOCK_ROW_WORDS + 1, words);
+        }
+        uint64_t *temp = current;
+        current = next;
+        next = temp;
+    }
+
+    int last_word = front->words_per_row - 1;
+    uint64_t tail_mask = get_bit_grid_tail_mask(front);
+    uint64_t changed = 0;
+    for (int y = bounds.y_begin; y < bounds.y_end; y++) {
+        const uint64_t *in = get_bit_grid_row(front, y);
+        uint64_t *out = get_bit_grid_row(&packed->back, y);
+        const uint64_t *stepped = current + (y - bounds.y_begin + halo) * BLOCK_ROW_WORDS + 1 + BLOCK_HALO_WORDS;
+        for (int i = bounds.word_begin; i < bounds.word_end; i++) {
+            uint64_t value = stepped[i - bounds.word_begin];
+            if (i == last_word) {
+                value &= tail_mask;
+            }
+            changed |= value ^ in[i];
+            out[i] = value;
+        }
+    }
+    packed->tile_changed[tile_index] = changed != 0;
+}
+
+// The tile offsets [*lo, *hi] along one axis whose cells lie within span
+// cells of tile. Only the last tile can be thinner than span, and only
+// reaching through it takes a second step.
+static void get_tile_reach(int tile, int tile_count, int last_extent, int span, int *lo, int *hi) {
+    bool thin = last_extent < span;
+    *lo = thin && (tile - 1 + tile_count) % tile_count == tile_count - 1 ? -2 : -1;
+    *hi = thin && (tile + 1) % tile_count == tile_count - 1 ? 2 : 1;
+}
+
+static void collect_active_tiles(Gol_Engine *engine) {
+    Bitpacked_Engine *packed = engine->impl;
+    int tiles_x = packed->tiles_x;
+    int tiles_y = packed->tiles_y;
+    int span = packed->changed_span;
+    int last_columns = packed->front.w - (tiles_x - 1) * TILE_WORDS * 64;
+    int last_rows = packed->front.h - (tiles_y - 1) * TILE_ROWS;
+    int count = 0;
+
+    for (int tile_y = 0; tile_y < tiles_y; tile_y++) {
+        int dy_lo, dy_hi;
+        get_tile_reach(tile_y, tiles_y, last_rows, span, &dy_lo, &dy_hi);
+        for (int tile_x = 0; tile_x < tiles_x; tile_x++) {
+            int dx_lo, dx_hi;
+            get_tile_reach(tile_x, tiles_x, last_columns, span, &dx_lo, &dx_hi);
+            bool active = engine->options.dense;
+            for (int dy = dy_lo; dy <= dy_hi && !active; dy++) {
+                int ny = (tile_y + dy + tiles_y) % tiles_y;
+                for (int dx = dx_lo; dx <= dx_hi && !active; dx++) {
+                    int nx = (tile_x + dx + tiles_x) % tiles_x;
+                    active = packed->tile_changed[ny * tiles_x + nx];
+                }
+            }
+            if (active) {
+                packed->active_tiles[count++] = tile_y * tiles_x + tile_x;
+            }
+        }
+    }
+
+    memset(packed->tile_changed, 0, tiles_x * tiles_y);
+    packed->active_tile_count = count;
+}
+
+// Advances every active tile by span generations (1, or a full temporal block).
+static void run_tile_pass(Gol_Engine *engine, int span) {
+    Bitpacked_Engine *packed = engine->impl;
+
+    // Changed flags compare generations `changed_span` apart; a pass of a
+    // different span can't rely on them.
+    if (span != packed->changed_span) {
+        memset(packed->tile_changed, 1, packed->tiles_x * packed->tiles_y);
+        packed->changed_span = span;
+    }
+    collect_active_tiles(engine);
+
+    Thread_Pool_Task task = span > 1 ? step_tile_block : step_tile;
+    if (packed->pool) {
+        run_thread_pool_tasks(packed->pool, task, packed, packed->active_tile_count);
+    } else {
+        for (int i = 0; i < packed->active_tile_count; i++) {
+            task(packed, i, 0);
+        }
+    }
+
+    for (int i = 0; i < packed->active_tile_count; i++) {
+        int tile_index = packed->active_tiles[i];
+        packed->tile_hash_stale[tile_index] |= packed->tile_changed[tile_index];
+        packed->tile_read_stale[tile_index] |= packed->tile_changed[tile_index];
+    }
+
+    packed->stats.active_tiles = packed->active_tile_count;
+    packed->stats.active_tile_steps += (uint64_t)packed->active_tile_count * span;
+    packed->stats.generations += span;
+
+    Bit_Grid temp = packed->front;
+    packed->front = packed->back;
+    packed->back = temp;
+    for (int p = 0; p < packed->plane_count; p++) {
+        temp = packed->front_planes[p];
+        packed->front_planes[p] = packed->back_planes[p];
+        packed->back_planes[p] = temp;
+    }
+}
+
+static void bitpacked_engine_step(Gol_Engine *engine, uint64_t generations) {
+    Bitpacked_Engine *packed = engine->impl;
+    uint64_t block = (uint64_t)packed->block_generations;
+
+    for (uint64_t i = 0; i < generations / block; i++) {
+        run_tile_pass(engine, (int)block);
+    }
+    for (uint64_t i = 0; i < generations % block; i++) {
+        run_tile_pass(engine, 1);
+    }
+}
+
+static void bitpacked_engine_read_grid(Gol_Engine *engine, Bit_Grid *grid) {
+    Bitpacked_Engine *packed = engine->impl;
+    copy_bit_grid(grid, &packed->front);
+}
+
+static void bitpacked_engine_read_grid_changes(Gol_Engine *engine, Bit_Grid *grid, uint8_t *changed_blocks) {
+    Bitpacked_Engine *packed = engine->impl;
+    memset(changed_blocks, 0, get_changed_block_count(grid->w, grid->h));
+    for (int i = 0; i < packed->tiles_x * packed->tiles_y; i++) {
+        if (!packed->tile_read_stale[i]) {
+            continue;
+        }
+        Tile_Bounds bounds = get_tile_bounds(packed, i);
+        size_t bytes = (size_t)(bounds.word_end - bounds.word_begin) * sizeof(uint64_t);
+        for (int y = bounds.y_begin; y < bounds.y_end; y++) {
+            memcpy(get_bit_grid_row(grid, y) + bounds.word_begin,
+                   get_bit_grid_row(&packed->front, y) + bounds.word_begin, bytes);
+        }
+        int x_end = bounds.word_end * 64 < grid->w ? bounds.word_end * 64 : grid->w;
+        flag_changed_blocks(changed_blocks, grid->w, bounds.word_begin * 64, bounds.y_begin, x_end, bounds.y_end);
+        packed->tile_read_stale[i] = 0;
+    }
+}
+
+// The cpu engine's per-cell term for each dying cell in bounds, so both
+// engines hash a Generations state alike.
+static uint64_t hash_dying_cells(const Bitpacked_Engine *packed, Tile_Bounds bounds) {
+    uint64_t hash = 0;
+    int grid_w = packed->front.w;
+    for (int y = bounds.y_begin; y < bounds.y_end; y++) {
+        for (int i = bounds.word_begin; i < bounds.word_end; i++) {
+            uint64_t dying = 0;
+            for (int p = 0; p < packed->plane_count; p++) {
+                dying |= get_bit_grid_row(&packed->front_planes[p], y)[i];
+            }
+            for (; dying; dying &= dying - 1) {
+                int bit = __builtin_ctzll(dying);
+                uint64_t state = 1;
+                for (int p = 0; p < packed->plane_count; p++) {
+                    state += ((get_bit_grid_row(&packed->front_planes[p], y)[i] >> bit) & 1) << p;
+                }
+                uint64_t position = (uint64_t)y * grid_w + (uint64_t)i * 64 + bit;
+                hash += mix_hash_bits((state << 56) ^ mix_hash_bits(position));
+            }
+        }
+    }
+    return hash;
+}
+
+static uint64_t bitpacked_engine_state_hash(Gol_Engine *engine) {
+    Bitpacked_Engine *packed = engine->impl;
+    uint64_t hash = 0;
+    for (int i = 0; i < packed->tiles_x * packed->tiles_y; i++) {
+        if (packed->tile_hash_stale[i]) {
+            Tile_Bounds bounds = get_tile_bounds(packed, i);
+            packed->tile_hashes[i] = hash_bit_grid_region(&packed->front, bounds.y_begin, bounds.y_end,
+                                                          bounds.word_begin, bounds.word_end);
+            if (packed->plane_count > 0) {
+                packed->tile_hashes[i] += hash_dying_cells(packed, bounds);
+            }
+            packed->tile_hash_stale[i] = 0;
+        }
+        hash += packed->tile_hashes[i];
+    }
+    return hash;
+}
+
+static void bitpacked_engine_get_stats(Gol_Engine *engine, Engine_Stats *stats) {
+    Bitpacked_Engine *packed = engine->impl;
+    *stats = packed->stats;
+}
+
+static size_t bitpacked_engine_memory_usage(Gol_Engine *engine) {
+    Bitpacked_Engine *packed = engine->impl;
+    size_t grid_bytes = (size_t)packed->front.words_per_row * packed->front.h * sizeof(uint64_t);
+    size_t tile_count = (size_t)packed->tiles_x * packed->tiles_y;
+    size_t bytes = sizeof(Bitpacked_Engine) + 2 * (1 + (size_t)packed->plane_count) * grid_bytes + tile_count * (3 + sizeof(int) + sizeof(uint64_t));
+    if (packed->block_scratch) {
+        int worker_count = packed->pool ? get_thread_pool_size(packed->pool) : 1;
+        bytes += (size_t)worker_count * 2 * BLOCK_SCRATCH_WORDS * sizeof(uint64_t);
+    }
+    return bytes;
+}
+
+const Gol_Engine_Api g_bitpacked_engine_api = {
+    .name = "bitpacked",
+    .supports_rule = bitpacked_engine_supports_rule,
+    .init = bitpacked_engine_init,
+    .destroy = bitpacked_engine_destroy,
+    .seed = bitpacked_engine_seed,
+    .step = bitpacked_engine_step,
+    .read_grid = bitpacked_engine_read_grid,
+    .read_grid_changes = bitpacked_engine_read_grid_changes,
+    .state_hash = bitpacked_engine_state_hash,
+    .get_stats = bitpacked_engine_get_stats,
+    .memory_usage = bitpacked_engine_memory_usage,
+};
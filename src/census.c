@@ -0,0 +1,520 @@
+// Soup census: runs many small random soups until each settles into a still
+// life or an oscillator, and writes how many ended up with each period as
+// JSON.
+//
+// Each soup is a soup_size x soup_size square of random cells, at the density
+// of the original texture seeding (1/10) by default, centred in an otherwise
+// empty board_size x board_size torus. Soup i is drawn from seed + i, so a
+// census is reproducible and any soup can be rerun on its own with --first.
+// Soups run in parallel on the thread pool, one single-threaded engine per
+// worker, and a soup stops as soon as its state hash repeats (see
+// cycle_detector.h).
+//
+// The board is a torus, so escaping gliders come back around: a soup that
+// throws one off settles with a period of a few times the board size, or
+// collides with its own debris, rather than running forever.
+//
+// With --batch N, soups first run N at a time in a batched engine (see
+// batch_engine.h), each finished universe reseeded with the next soup. Those
+// that settle into a still life or a period-2 oscillator within
+// --batch-generations are recorded from the batch status; the rest are rerun
+// from scratch on the per-worker engines, so the census comes out the same
+// as without batching.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "batch_engine.h"
+#include "bit_grid.h"
+#include "common.h"
+#include "cycle_detector.h"
+#include "engine.h"
+#include "gl_util.h"
+#include "life_kernel.h"
+#include "rule.h"
+#include "thread_pool.h"
+
+enum {
+    DEFAULT_SOUP_COUNT = 10000,
+    DEFAULT_SOUP_SIZE = 16,
+    DEFAULT_BOARD_SIZE = 64,
+    DEFAULT_MAX_GENERATIONS = 20000,
+    // A glider crossing the default board diagonally comes back after 256.
+    DEFAULT_MAX_PERIOD = 512,
+    DEFAULT_SEED = 1,
+    DEFAULT_BATCH_GENERATIONS = 1000,
+    // Generations between batch status reads; finished universes idle until
+    // the next read reseeds them.
+    BATCH_STATUS_INTERVAL = 16
+};
+
+#define DEFAULT_ENGINE "bitpacked"
+#define DEFAULT_BATCH_ENGINE "bitpacked"
+#define DEFAULT_DENSITY 0.1
+#define DEFAULT_OUTPUT "census.json"
+
+typedef struct {
+    const char *engine_name;
+    int soup_count;
+    uint64_t first_soup;
+    int soup_size;
+    int board_size;
+    double density;
+    uint64_t max_generations;
+    int max_period;
+    uint64_t seed;
+    int thread_count;
+    const char *kernel_name;
+    const char *output_path;
+    Rule rule;
+    // Zero runs every soup on the per-worker engines.
+    int batch_size;
+    const char *batch_engine_name;
+    uint64_t batch_generations;
+} Census_Options;
+
+typedef struct {
+    // 0 if the soup hadn't settled after max_generations.
+    uint64_t period;
+    // First generation of the final cycle, or max_generations.
+    uint64_t settle_generation;
+    uint64_t population;
+} Soup_Result;
+
+typedef struct {
+    Gol_Engine *engine;
+    Cycle_Detector detector;
+    Bit_Grid soup;
+    Bit_Grid board;
+} Census_Worker;
+
+typedef struct {
+    const Census_Options *options;
+    Census_Worker *workers;
+    Soup_Result *results;
+    // Soups run_soup steps, by index into results; NULL means task i is
+    // soup i.
+    const int *soup_indices;
+} Census;
+
+typedef struct {
+    uint64_t period;
+    uint64_t count;
+    uint64_t settle_generation_sum;
+    uint64_t population_sum;
+} Period_Tally;
+
+Census_Options parse_census_options(int argc, char **argv);
+void print_census_usage(const char *program);
+void fill_soup_board(const Census_Options *options, int soup, Bit_Grid *soup_grid, Bit_Grid *board);
+int run_batched_soups(Census *census, Batch_Engine *batch, int *reruns);
+void run_soup(void *ctx, int task_index, int worker_index);
+int tally_periods(const Soup_Result *results, int soup_count, Period_Tally *tallies);
+void write_census(const Census_Options *options, const Period_Tally *tallies, int tally_count,
+                  uint64_t generations, double seconds);
+
+int main(int argc, char **argv) {
+    Census_Options options = parse_census_options(argc, argv);
+
+    if (options.kernel_name && !select_life_kernel(options.kernel_name)) {
+        exit_with_error("Kernel '%s' is unknown or unsupported on this CPU", options.kernel_name);
+    }
+    init_life_kernel();
+
+    const Gol_Engine_Api *api = find_engine_api(options.engine_name);
+    if (!api) {
+        char engine_names[256];
+        list_engine_names(engine_names, sizeof(engine_names));
+        exit_with_error("Unknown engine '%s' (available: %s)", options.engine_name, engine_names);
+    }
+    if (api == &g_gl_engine_api) {
+        exit_with_error("The census runs one engine per worker thread, so it needs a CPU engine");
+    }
+
+    Thread_Pool *pool = create_thread_pool(options.thread_count);
+    int worker_count = get_thread_pool_size(pool);
+
+    // Soups are too small to split further; the parallelism is across soups.
+    Engine_Options engine_options = {0};
+    engine_options.thread_count = 1;
+    engine_options.rule = &options.rule;
+
+    Census census = { &options, NULL, NULL, NULL };
+    census.workers = xcalloc(worker_count, sizeof(Census_Worker));
+    census.results = xcalloc(options.soup_count, sizeof(Soup_Result));
+    for (int i = 0; i < worker_count; i++) {
+        Census_Worker *worker = &census.workers[i];
+        worker->engine = create_engine(api, options.board_size, options.board_size, &engine_options);
+        if (!worker->engine) {
+            exit_with_error("Engine '%s' is not available for the census", api->name);
+        }
+        if (!can_hash_engine_state(worker->engine)) {
+            exit_with_error("Engine '%s' can't hash the dying states of %s", api->name, options.rule.name);
+        }
+        worker->detector = create_cycle_detector(options.max_period);
+        worker->soup = create_bit_grid(options.soup_size, options.soup_size);
+        worker->board = create_bit_grid(options.board_size, options.board_size);
+    }
+
+    trace_log("Census: engine=%s kernel=%s rule=%s soups=%d (from %llu) soup=%dx%d board=%dx%d threads=%d",
+              api->name, get_life_kernel_name(), options.rule.name, options.soup_count,
+              (unsigned long long)options.first_soup, options.soup_size, options.soup_size,
+              options.board_size, options.board_size, worker_count);
+
+    Batch_Engine *batch = NULL;
+    if (options.batch_size > 0) {
+        const Batch_Engine_Api *batch_api = find_batch_engine_api(options.batch_engine_name);
+        if (!batch_api) {
+            char batch_engine_names[256];
+            list_batch_engine_names(batch_engine_names, sizeof(batch_engine_names));
+            exit_with_error("Unknown batch engine '%s' (available: %s)", options.batch_engine_name,
+                            batch_engine_names);
+        }
+        if (batch_api == &g_gl_batch_engine_api && !init_offscreen_gl_context()) {
+            exit_with_error("Failed to create an offscreen GL context for the batch");
+        }
+        Batch_Options batch_options = {0};
+        batch_options.thread_count = options.thread_count;
+        batch_options.max_generations = options.batch_generations < options.max_generations
+            ? options.batch_generations : options.max_generations;
+        batch_options.rule = &options.rule;
+        batch = create_batch_engine(batch_api, options.batch_size, options.board_size, options.board_size,
+                                    &batch_options);
+        if (!batch) {
+            exit_with_error("Batch engine '%s' is not available for the census", batch_api->name);
+        }
+        trace_log("Batch: engine=%s universes=%d generations=%llu", batch_api->name, options.batch_size,
+                  (unsigned long long)batch_options.max_generations);
+    }
+
+    uint64_t start_ns = get_time_ns();
+    if (batch) {
+        int *reruns = xmalloc(options.soup_count * sizeof(int));
+        int rerun_count = run_batched_soups(&census, batch, reruns);
+        trace_log("Batch settled %d soups in %.3f s, rerunning %d", options.soup_count - rerun_count,
+                  (double)(get_time_ns() - start_ns) / 1e9, rerun_count);
+        census.soup_indices = reruns;
+        run_thread_pool_tasks(pool, run_soup, &census, rerun_count);
+        census.soup_indices = NULL;
+        free(reruns);
+    } else {
+        run_thread_pool_tasks(pool, run_soup, &census, options.soup_count);
+    }
+    double seconds = (double)(get_time_ns() - start_ns) / 1e9;
+
+    uint64_t generations = 0;
+    for (int i = 0; i < options.soup_count; i++) {
+        generations += census.results[i].settle_generation + census.results[i].period;
+    }
+
+    Period_Tally *tallies = xcalloc(options.soup_count, sizeof(Period_Tally));
+    int tally_count = tally_periods(census.results, options.soup_count, tallies);
+    write_census(&options, tallies, tally_count, generations, seconds);
+
+    free(tallies);
+    if (batch) {
+        bool gl_batch = batch->api == &g_gl_batch_engine_api;
+        destroy_batch_engine(batch);
+        if (gl_batch) {
+            destroy_offscreen_gl_context();
+        }
+    }
+    for (int i = 0; i < worker_count; i++) {
+        Census_Worker *worker = &census.workers[i];
+        destroy_engine(worker->engine);
+        free_cycle_detector(&worker->detector);
+        free_bit_grid(&worker->soup);
+        free_bit_grid(&worker->board);
+    }
+    free(census.workers);
+    free(census.results);
+    destroy_thread_pool(pool);
+    return 0;
+}
+
+Census_Options parse_census_options(int argc, char **argv) {
+    Census_Options options = {0};
+    options.engine_name = DEFAULT_ENGINE;
+    options.soup_count = DEFAULT_SOUP_COUNT;
+    options.soup_size = DEFAULT_SOUP_SIZE;
+    options.board_size = DEFAULT_BOARD_SIZE;
+    options.density = DEFAULT_DENSITY;
+    options.max_generations = DEFAULT_MAX_GENERATIONS;
+    options.max_period = DEFAULT_MAX_PERIOD;
+    options.seed = DEFAULT_SEED;
+    options.output_path = DEFAULT_OUTPUT;
+    options.rule = get_conway_rule();
+    options.batch_engine_name = DEFAULT_BATCH_ENGINE;
+    options.batch_generations = DEFAULT_BATCH_GENERATIONS;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (strcmp(arg, "--engine") == 0 && has_value) {
+            options.engine_name = argv[++i];
+        } else if (strcmp(arg, "--soups") == 0 && has_value) {
+            options.soup_count = atoi(argv[++i]);
+        } else if (strcmp(arg, "--first") == 0 && has_value) {
+            options.first_soup = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--soup-size") == 0 && has_value) {
+            options.soup_size = atoi(argv[++i]);
+        } else if (strcmp(arg, "--board") == 0 && has_value) {
+            options.board_size = atoi(argv[++i]);
+        } else if (strcmp(arg, "--density") == 0 && has_value) {
+            options.density = atof(argv[++i]);
+        } else if (strcmp(arg, "--max-generations") == 0 && has_value) {
+            options.max_generations = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--max-period") == 0 && has_value) {
+            options.max_period = atoi(argv[++i]);
+        } else if (strcmp(arg, "--seed") == 0 && has_value) {
+            options.seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--threads") == 0 && has_value) {
+            options.thread_count = atoi(argv[++i]);
+        } else if (strcmp(arg, "--rule") == 0 && has_value) {
+            if (!parse_rule(argv[++i], &options.rule)) {
+                exit_with_error("Rule '%s' is not supported", argv[i]);
+            }
+        } else if (strcmp(arg, "--kernel") == 0 && has_value) {
+            options.kernel_name = argv[++i];
+        } else if (strcmp(arg, "--batch") == 0 && has_value) {
+            options.batch_size = atoi(argv[++i]);
+        } else if (strcmp(arg, "--batch-engine") == 0 && has_value) {
+            options.batch_engine_name = argv[++i];
+        } else if (strcmp(arg, "--batch-generations") == 0 && has_value) {
+            options.batch_generations = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--output") == 0 && has_value) {
+            options.output_path = argv[++i];
+        } else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            print_census_usage(argv[0]);
+            exit(0);
+        } else {
+            print_census_usage(argv[0]);
+            exit_with_error("Unknown or incomplete argument '%s'", arg);
+        }
+    }
+
+    if (options.soup_count <= 0 || options.max_period <= 0 || options.max_generations == 0) {
+        exit_with_error("Expected positive --soups, --max-period and --max-generations");
+    }
+    if (options.soup_size <= 0 || options.board_size < options.soup_size) {
+        exit_with_error("Expected a positive soup size no larger than the board");
+    }
+    if (options.batch_size < 0 || (options.batch_size > 0 && options.batch_generations == 0)) {
+        exit_with_error("Expected a non-negative --batch and positive --batch-generations");
+    }
+    if (options.density < 0.0 || options.density > 1.0) {
+        exit_with_error("Invalid density %g, expected a value in [0, 1]", options.density);
+    }
+
+    return options;
+}
+
+void print_census_usage(const char *program) {
+    char engine_names[256];
+    list_engine_names(engine_names, sizeof(engine_names));
+
+    printf("Usage: %s [options]\n", program);
+    printf("  --engine NAME          CPU engine to step the soups (default %s; available: %s)\n",
+           DEFAULT_ENGINE, engine_names);
+    printf("  --soups N              Soups to run (default %d)\n", DEFAULT_SOUP_COUNT);
+    printf("  --first N              Index of the first soup, to rerun part of a census (default 0)\n");
+    printf("  --soup-size N          Side of the random square (default %d)\n", DEFAULT_SOUP_SIZE);
+    printf("  --board N              Side of the torus it runs on (default %d)\n", DEFAULT_BOARD_SIZE);
+    printf("  --density D            Live-cell fraction of the soups (default %.1f)\n", DEFAULT_DENSITY);
+    printf("  --max-generations N    Give up on a soup after N generations (default %d)\n",
+           DEFAULT_MAX_GENERATIONS);
+    printf("  --max-period P         Longest period detected (default %d)\n", DEFAULT_MAX_PERIOD);
+    printf("  --seed N               Census seed; soup i is drawn from seed + i (default %d)\n", DEFAULT_SEED);
+    printf("  --threads N            Soups run in parallel (default: one per CPU)\n");
+    printf("  --rule RULE            Rule to run (default B3/S23)\n");
+    printf("  --kernel NAME          Packed CPU kernel: scalar, sse2 or avx2\n");
+    printf("  --batch N              Run soups N at a time in a batched engine first (default 0: off)\n");
+    printf("  --batch-engine NAME    Batched engine: bitpacked or gl (default %s)\n", DEFAULT_BATCH_ENGINE);
+    printf("  --batch-generations N  Hand soups that haven't settled with period 1 or 2 after N generations\n"
+           "                         to the per-worker engines (default %d)\n", DEFAULT_BATCH_GENERATIONS);
+    printf("  --output PATH          JSON destination (default %s)\n", DEFAULT_OUTPUT);
+}
+
+// Draws soup (an index into the census) and centres it on an empty board.
+void fill_soup_board(const Census_Options *options, int soup, Bit_Grid *soup_grid, Bit_Grid *board) {
+    uint64_t soup_index = options->first_soup + (uint64_t)soup;
+    fill_random_bit_grid_with_density(soup_grid, options->density, options->seed + soup_index);
+    clear_bit_grid(board);
+    int offset = (options->board_size - options->soup_size) / 2;
+    for (int y = 0; y < options->soup_size; y++) {
+        for (int x = 0; x < options->soup_size; x++) {
+            if (get_bit_grid_cell(soup_grid, x, y)) {
+                set_bit_grid_cell(board, offset + x, offset + y, true);
+            }
+        }
+    }
+}
+
+// Streams every soup through the batch and records those it settles. The
+// others go into reruns, and their count is returned.
+int run_batched_soups(Census *census, Batch_Engine *batch, int *reruns) {
+    const Census_Options *options = census->options;
+    Bit_Grid soup_grid = create_bit_grid(options->soup_size, options->soup_size);
+    Bit_Grid board = create_bit_grid(options->board_size, options->board_size);
+    // The soup each universe runs, or -1 once there are none left.
+    int *universe_soups = xmalloc(batch->universe_count * sizeof(int));
+    Universe_Status *status = xcalloc(batch->universe_count, sizeof(Universe_Status));
+
+    int next_soup = 0;
+    int running = 0;
+    int rerun_count = 0;
+    for (int u = 0; u < batch->universe_count; u++) {
+        universe_soups[u] = -1;
+        if (next_soup < options->soup_count) {
+            fill_soup_board(options, next_soup, &soup_grid, &board);
+            seed_batch_universe(batch, u, &board);
+            universe_soups[u] = next_soup++;
+            running++;
+        }
+    }
+
+    while (running > 0) {
+        step_batch_engine(batch, BATCH_STATUS_INTERVAL);
+        read_batch_status(batch, status);
+        for (int u = 0; u < batch->universe_count; u++) {
+            int soup = universe_soups[u];
+            if (soup < 0 || !status[u].finished) {
+                continue;
+            }
+            if (status[u].period > 0) {
+                Soup_Result *result = &census->results[soup];
+                result->period = status[u].period;
+                result->settle_generation = status[u].generation - status[u].period;
+                result->population = status[u].population;
+            } else {
+                reruns[rerun_count++] = soup;
+            }
+
+            if (next_soup < options->soup_count) {
+                fill_soup_board(options, next_soup, &soup_grid, &board);
+                seed_batch_universe(batch, u, &board);
+                universe_soups[u] = next_soup++;
+            } else {
+                universe_soups[u] = -1;
+                running--;
+            }
+        }
+    }
+
+    free(status);
+    free(universe_soups);
+    free_bit_grid(&soup_grid);
+    free_bit_grid(&board);
+    return rerun_count;
+}
+
+void run_soup(void *ctx, int task_index, int worker_index) {
+    Census *census = ctx;
+    const Census_Options *options = census->options;
+    Census_Worker *worker = &census->workers[worker_index];
+    Gol_Engine *engine = worker->engine;
+
+    int soup = census->soup_indices ? census->soup_indices[task_index] : task_index;
+    fill_soup_board(options, soup, &worker->soup, &worker->board);
+    seed_engine(engine, &worker->board);
+
+    reset_cycle_detector(&worker->detector);
+    uint64_t period = record_cycle_state(&worker->detector, 0, get_engine_state_hash(engine));
+    while (period == 0 && engine->generation < options->max_generations) {
+        step_engine(engine, 1);
+        period = record_cycle_state(&worker->detector, engine->generation, get_engine_state_hash(engine));
+    }
+
+    Soup_Result *result = &census->results[soup];
+    result->period = period;
+    result->settle_generation = engine->generation - period;
+    result->population = get_engine_population(engine);
+}
+
+static int compare_tallies(const void *a, const void *b) {
+    uint64_t x = ((const Period_Tally *)a)->period;
+    uint64_t y = ((const Period_Tally *)b)->period;
+    return x < y ? -1 : x > y;
+}
+
+// One tally per distinct period, unsettled soups (period 0) first.
+int tally_periods(const Soup_Result *results, int soup_count, Period_Tally *tallies) {
+    int tally_count = 0;
+    for (int i = 0; i < soup_count; i++) {
+        const Soup_Result *result = &results[i];
+        int t = 0;
+        while (t < tally_count && tallies[t].period != result->period) {
+            t++;
+        }
+        if (t == tally_count) {
+            tallies[tally_count++].period = result->period;
+        }
+        tallies[t].count++;
+        tallies[t].settle_generation_sum += result->settle_generation;
+        tallies[t].population_sum += result->population;
+    }
+    qsort(tallies, tally_count, sizeof(Period_Tally), compare_tallies);
+    return tally_count;
+}
+
+void write_census(const Census_Options *options, const Period_Tally *tallies, int tally_count,
+                  uint64_t generations, double seconds) {
+    FILE *out = fopen(options->output_path, "w");
+    if (!out) {
+        exit_with_error("Failed to open '%s' for writing", options->output_path);
+    }
+
+    uint64_t unsettled = tally_count > 0 && tallies[0].period == 0 ? tallies[0].count : 0;
+    fprintf(out, "{\n");
+    fprintf(out, "  \"engine\": \"%s\",\n", options->engine_name);
+    fprintf(out, "  \"kernel\": \"%s\",\n", get_life_kernel_name());
+    fprintf(out, "  \"rule\": \"%s\",\n", options->rule.name);
+    fprintf(out, "  \"soups\": %d,\n", options->soup_count);
+    fprintf(out, "  \"first_soup\": %llu,\n", (unsigned long long)options->first_soup);
+    fprintf(out, "  \"seed\": %llu,\n", (unsigned long long)options->seed);
+    fprintf(out, "  \"soup_size\": %d,\n", options->soup_size);
+    fprintf(out, "  \"board_size\": %d,\n", options->board_size);
+    fprintf(out, "  \"density\": %.4f,\n", options->density);
+    fprintf(out, "  \"max_generations\": %llu,\n", (unsigned long long)options->max_generations);
+    fprintf(out, "  \"max_period\": %d,\n", options->max_period);
+    fprintf(out, "  \"batch\": %d,\n", options->batch_size);
+    if (options->batch_size > 0) {
+        fprintf(out, "  \"batch_engine\": \"%s\",\n", options->batch_engine_name);
+        fprintf(out, "  \"batch_generations\": %llu,\n", (unsigned long long)options->batch_generations);
+    }
+    fprintf(out, "  \"elapsed_seconds\": %.6f,\n", seconds);
+    fprintf(out, "  \"soups_per_second\": %.3f,\n", seconds > 0.0 ? options->soup_count / seconds : 0.0);
+    fprintf(out, "  \"generations\": %llu,\n", (unsigned long long)generations);
+    fprintf(out, "  \"unsettled\": %llu,\n", (unsigned long long)unsettled);
+    fprintf(out, "  \"periods\": [");
+
+    bool first = true;
+    for (int i = 0; i < tally_count; i++) {
+        const Period_Tally *tally = &tallies[i];
+        if (tally->period == 0) {
+            continue;
+        }
+        fprintf(out, "%s\n    {\"period\": %llu, \"count\": %llu, \"mean_settle_generation\": %.1f, "
+                "\"mean_population\": %.1f}",
+                first ? "" : ",", (unsigned long long)tally->period, (unsigned long long)tally->count,
+                (double)tally->settle_generation_sum / tally->count, (double)tally->population_sum / tally->count);
+        first = false;
+        trace_log("Period %llu: %llu soups, settled at generation %.0f on average",
+                  (unsigned long long)tally->period, (unsigned long long)tally->count,
+                  (double)tally->settle_generation_sum / tally->count);
+    }
+    fprintf(out, "\n  ]\n}\n");
+    fclose(out);
+
+    if (unsettled > 0) {
+        trace_log("%llu soups hadn't settled after %llu generations", (unsigned long long)unsettled,
+                  (unsigned long long)options->max_generations);
+    }
+    trace_log("%d soups in %.3f s (%.1f soups/s, %.3e generations/s); wrote %s", options->soup_count, seconds,
+              seconds > 0.0 ? options->soup_count / seconds : 0.0,
+              seconds > 0.0 ? (double)generations / seconds : 0.0, options->output_path);
+}
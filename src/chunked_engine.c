@@ -0,0 +1,528 @@
+// Headless engine on an unbounded plane held as a sparse set of 64x64 chunks,
+// each 64 packed rows, found by chunk coordinates through a hash map. Only
+// chunks with live cells, and the empty ones bordering them, exist, so memory
+// follows the live area rather than its bounding box. The grid passed to seed
+// and read_grid is a window at (0, 0); cells outside it are kept, so a glider
+// that leaves the window keeps flying. Needs Engine_Options.unbounded.
+//
+// Each generation:
+//   1. Chunks that may change (they or a neighbour changed last generation)
+//      are collected, as in the bitpacked engine; the rest hold the same rows
+//      in both buffers and are skipped.
+//   2. The active chunks step in parallel. Each builds a 66-row halo from its
+//      neighbours' current rows (missing neighbours are empty) and writes its
+//      own next rows, so workers never touch each other's output.
+//   3. On the calling thread, empty chunks are created next to any chunk with
+//      live cells on the facing edge or corner, and chunks that stayed empty
+//      with nothing live facing them are freed.
+//
+// Chunks come from slabs of CHUNKS_PER_SLAB and go back on a free list, and
+// the hash map and chunk lists only grow when the chunk count reaches a new
+// high, so a run in steady state does no allocation at all.
+//
+// The state hash covers the whole plane, summed from per-chunk hashes that are
+// only recomputed for chunks that changed. Incremental readback keeps a flag
+// per chunk position in the window, set when the chunk there changes, since
+// a chunk that emptied may be freed before anyone reads it.
+//
+// Any Life-like rule without B0 works; with B0 the empty plane itself changes.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "bit_grid.h"
+#include "common.h"
+#include "engine.h"
+#include "life_kernel.h"
+#include "thread_pool.h"
+
+enum {
+    CHUNK_SIZE = 64,
+    CHUNKS_PER_SLAB = 256,
+    MIN_BUCKET_COUNT = 1024,
+    DIRECTION_COUNT = 8
+};
+
+// Neighbour directions, ordered so that the opposite of d is 7 - d. Rows grow
+// southwards.
+typedef enum {
+    DIRECTION_NW,
+    DIRECTION_N,
+    DIRECTION_NE,
+    DIRECTION_W,
+    DIRECTION_E,
+    DIRECTION_SW,
+    DIRECTION_S,
+    DIRECTION_SE
+} Direction;
+
+static const int g_direction_dx[DIRECTION_COUNT] = { -1, 0, 1, -1, 1, -1, 0, 1 };
+static const int g_direction_dy[DIRECTION_COUNT] = { -1, -1, -1, 0, 0, 1, 1, 1 };
+
+static const uint64_t g_empty_rows[CHUNK_SIZE];
+
+typedef struct Chunk Chunk;
+
+struct Chunk {
+    // Two generations, indexed by the engine's front.
+    uint64_t rows[2][CHUNK_SIZE];
+    int64_t x;
+    int64_t y;
+    Chunk *neighbors[DIRECTION_COUNT];
+    // Next in the hash bucket, or in the free list.
+    Chunk *next;
+    int list_index;
+    uint32_t population;
+    // hash_bit_word summed over the rows, valid unless hash_stale.
+    uint64_t hash;
+    // Bit d: live cells on the edge or corner facing direction d.
+    uint8_t border;
+    // Changed in the last generation stepped.
+    bool changed;
+    bool active;
+    bool hash_stale;
+};
+
+typedef struct {
+    // Every chunk in use, in no particular order.
+    Chunk **chunks;
+    int chunk_count;
+    int chunk_capacity;
+    Chunk **active_chunks;
+    int active_chunk_count;
+
+    Chunk **buckets;
+    uint32_t bucket_mask;
+
+    Chunk **slabs;
+    int slab_count;
+    Chunk *free_list;
+
+    int front;
+    Life_Kernel kernel;
+    Thread_Pool *pool;
+    Engine_Stats stats;
+
+    // Per chunk position in the window: changed since the last
+    // read_grid_changes.
+    int window_chunks_x;
+    int window_chunks_y;
+    uint8_t *window_read_stale;
+} Chunked_Engine;
+
+static inline uint32_t hash_chunk_coords(int64_t x, int64_t y) {
+    uint64_t h = (uint64_t)x * 0x9E3779B97F4A7C15ull;
+    h = (h ^ (uint64_t)y) * 0xC2B2AE3D27D4EB4Full;
+    return (uint32_t)(h >> 32);
+}
+
+static Chunk *find_chunk(const Chunked_Engine *ce, int64_t x, int64_t y) {
+    Chunk *chunk = ce->buckets[hash_chunk_coords(x, y) & ce->bucket_mask];
+    while (chunk && (chunk->x != x || chunk->y != y)) {
+        chunk = chunk->next;
+    }
+    return chunk;
+}
+
+static void insert_chunk_into_buckets(Chunked_Engine *ce, Chunk *chunk) {
+    Chunk **bucket = &ce->buckets[hash_chunk_coords(chunk->x, chunk->y) & ce->bucket_mask];
+    chunk->next = *bucket;
+    *bucket = chunk;
+}
+
+static void grow_chunk_storage(Chunked_Engine *ce) {
+    Chunk *slab = xmalloc(CHUNKS_PER_SLAB * sizeof(Chunk));
+    for (int i = CHUNKS_PER_SLAB - 1; i >= 0; i--) {
+        slab[i].next = ce->free_list;
+        ce->free_list = &slab[i];
+    }
+
+    ce->slabs = realloc(ce->slabs, (ce->slab_count + 1) * sizeof(Chunk *));
+    ce->chunk_capacity += CHUNKS_PER_SLAB;
+    ce->chunks = realloc(ce->chunks, ce->chunk_capacity * sizeof(Chunk *));
+    ce->active_chunks = realloc(ce->active_chunks, ce->chunk_capacity * sizeof(Chunk *));
+    if (!ce->slabs || !ce->chunks || !ce->active_chunks) {
+        exit_with_error("Failed to grow the chunk pool");
+    }
+    ce->slabs[ce->slab_count++] = slab;
+
+    // Keep chains short: at most one chunk per bucket on average.
+    if ((uint32_t)ce->chunk_capacity > ce->bucket_mask + 1) {
+        uint32_t bucket_count = (ce->bucket_mask + 1) * 2;
+        free(ce->buckets);
+        ce->buckets = xcalloc(bucket_count, sizeof(Chunk *));
+        ce->bucket_mask = bucket_count - 1;
+        for (int i = 0; i < ce->chunk_count; i++) {
+            insert_chunk_into_buckets(ce, ce->chunks[i]);
+        }
+    }
+}
+
+// Returns an empty chunk marked changed, so it is stepped next generation.
+static Chunk *create_chunk(Chunked_Engine *ce, int64_t x, int64_t y) {
+    if (!ce->free_list) {
+        grow_chunk_storage(ce);
+    }
+    Chunk *chunk = ce->free_list;
+    ce->free_list = chunk->next;
+
+    memset(chunk->rows, 0, sizeof(chunk->rows));
+    chunk->x = x;
+    chunk->y = y;
+    chunk->population = 0;
+    chunk->border = 0;
+    chunk->changed = true;
+    chunk->active = false;
+    chunk->hash_stale = true;
+    insert_chunk_into_buckets(ce, chunk);
+
+    for (int d = 0; d < DIRECTION_COUNT; d++) {
+        Chunk *neighbor = find_chunk(ce, x + g_direction_dx[d], y + g_direction_dy[d]);
+        chunk->neighbors[d] = neighbor;
+        if (neighbor) {
+            neighbor->neighbors[DIRECTION_COUNT - 1 - d] = chunk;
+        }
+    }
+
+    chunk->list_index = ce->chunk_count;
+    ce->chunks[ce->chunk_count++] = chunk;
+    return chunk;
+}
+
+static void free_chunk(Chunked_Engine *ce, Chunk *chunk) {
+    for (int d = 0; d < DIRECTION_COUNT; d++) {
+        if (chunk->neighbors[d]) {
+            chunk->neighbors[d]->neighbors[DIRECTION_COUNT - 1 - d] = NULL;
+        }
+    }
+
+    Chunk **link = &ce->buckets[hash_chunk_coords(chunk->x, chunk->y) & ce->bucket_mask];
+    while (*link != chunk) {
+        link = &(*link)->next;
+    }
+    *link = chunk->next;
+
+    Chunk *last = ce->chunks[--ce->chunk_count];
+    ce->chunks[chunk->list_index] = last;
+    last->list_index = chunk->list_index;
+
+    chunk->next = ce->free_list;
+    ce->free_list = chunk;
+}
+
+static void free_all_chunks(Chunked_Engine *ce) {
+    while (ce->chunk_count > 0) {
+        free_chunk(ce, ce->chunks[ce->chunk_count - 1]);
+    }
+}
+
+static uint8_t get_chunk_border(const uint64_t *rows) {
+    uint64_t west = 0;
+    uint64_t east = 0;
+    for (int r = 0; r < CHUNK_SIZE; r++) {
+        west |= rows[r] & 1;
+        east |= rows[r] >> 63;
+    }
+    uint64_t top = rows[0];
+    uint64_t bottom = rows[CHUNK_SIZE - 1];
+    return (uint8_t)(((top & 1) << DIRECTION_NW) | ((uint64_t)(top != 0) << DIRECTION_N) |
+                     ((top >> 63) << DIRECTION_NE) | (west << DIRECTION_W) | (east << DIRECTION_E) |
+                     ((bottom & 1) << DIRECTION_SW) | ((uint64_t)(bottom != 0) << DIRECTION_S) |
+                     ((bottom >> 63) << DIRECTION_SE));
+}
+
+static void update_chunk_summary(Chunk *chunk, const uint64_t *rows) {
+    uint32_t population = 0;
+    for (int r = 0; r < CHUNK_SIZE; r++) {
+        population += (uint32_t)__builtin_popcountll(rows[r]);
+    }
+    chunk->population = population;
+    chunk->border = get_chunk_border(rows);
+}
+
+static const uint64_t *get_neighbor_rows(const Chunk *chunk, Direction d, int front) {
+    return chunk->neighbors[d] ? chunk->neighbors[d]->rows[front] : g_empty_rows;
+}
+
+static void step_chunk(void *ctx, int task_index, int worker_index) {
+    (void)worker_index;
+
+    Chunked_Engine *ce = ctx;
+    Chunk *chunk = ce->active_chunks[task_index];
+    int front = ce->front;
+    const uint64_t *center = chunk->rows[front];
+    const uint64_t *west = get_neighbor_rows(chunk, DIRECTION_W, front);
+    const uint64_t *east = get_neighbor_rows(chunk, DIRECTION_E, front);
+
+    // Rows -1..64 of the west, centre and east columns, so the chunk steps as
+    // one column with its halo rows at either end.
+    uint64_t halo[3][CHUNK_SIZE + 2];
+    halo[0][0] = get_neighbor_rows(chunk, DIRECTION_NW, front)[CHUNK_SIZE - 1];
+    halo[1][0] = get_neighbor_rows(chunk, DIRECTION_N, front)[CHUNK_SIZE - 1];
+    halo[2][0] = get_neighbor_rows(chunk, DIRECTION_NE, front)[CHUNK_SIZE - 1];
+    memcpy(&halo[0][1], west, sizeof(uint64_t) * CHUNK_SIZE);
+    memcpy(&halo[1][1], center, sizeof(uint64_t) * CHUNK_SIZE);
+    memcpy(&halo[2][1], east, sizeof(uint64_t) * CHUNK_SIZE);
+    halo[0][CHUNK_SIZE + 1] = get_neighbor_rows(chunk, DIRECTION_SW, front)[0];
+    halo[1][CHUNK_SIZE + 1] = get_neighbor_rows(chunk, DIRECTION_S, front)[0];
+    halo[2][CHUNK_SIZE + 1] = get_neighbor_rows(chunk, DIRECTION_SE, front)[0];
+
+    uint64_t *out = chunk->rows[1 - front];
+    bool changed = step_life_column(&ce->kernel, &halo[0][1], &halo[1][1], &halo[2][1], out, CHUNK_SIZE);
+    chunk->changed = changed;
+    chunk->hash_stale |= changed;
+    if (changed && chunk->x >= 0 && chunk->x < ce->window_chunks_x && chunk->y >= 0 && chunk->y < ce->window_chunks_y) {
+        ce->window_read_stale[chunk->y * ce->window_chunks_x + chunk->x] = 1;
+    }
+    update_chunk_summary(chunk, out);
+}
+
+static void collect_active_chunks(Chunked_Engine *ce) {
+    int count = 0;
+    for (int i = 0; i < ce->chunk_count; i++) {
+        Chunk *chunk = ce->chunks[i];
+        bool active = chunk->changed;
+        for (int d = 0; d < DIRECTION_COUNT && !active; d++) {
+            active = chunk->neighbors[d] && chunk->neighbors[d]->changed;
+        }
+        chunk->active = active;
+        if (active) {
+            ce->active_chunks[count++] = chunk;
+        }
+    }
+    // Skipped chunks didn't change this generation either.
+    for (int i = 0; i < ce->chunk_count; i++) {
+        if (!ce->chunks[i]->active) {
+            ce->chunks[i]->changed = false;
+        }
+    }
+    ce->active_chunk_count = count;
+}
+
+static bool is_chunk_faced_by_live_cells(const Chunk *chunk) {
+    for (int d = 0; d < DIRECTION_COUNT; d++) {
+        const Chunk *neighbor = chunk->neighbors[d];
+        if (neighbor && (neighbor->border >> (DIRECTION_COUNT - 1 - d)) & 1) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Grows the frontier where live cells reach an edge and drops chunks that
+// have been empty for a generation with nothing live next to them. A chunk
+// that only just emptied is kept one more generation, so its neighbours
+// still see it as changed.
+static void update_chunk_frontier(Chunked_Engine *ce) {
+    int count = ce->chunk_count;
+    for (int i = 0; i < count; i++) {
+        Chunk *chunk = ce->chunks[i];
+        for (int d = 0; d < DIRECTION_COUNT; d++) {
+            if ((chunk->border >> d) & 1 && !chunk->neighbors[d]) {
+                create_chunk(ce, chunk->x + g_direction_dx[d], chunk->y + g_direction_dy[d]);
+            }
+        }
+    }
+
+    for (int i = ce->chunk_count - 1; i >= 0; i--) {
+        Chunk *chunk = ce->chunks[i];
+        if (chunk->population == 0 && !chunk->changed && !is_chunk_faced_by_live_cells(chunk)) {
+            free_chunk(ce, chunk);
+        }
+    }
+}
+
+static bool chunked_engine_supports_rule(const Rule *rule) {
+    return rule->family == RULE_FAMILY_LIFE && !(rule->birth & 1);
+}
+
+static bool chunked_engine_init(Gol_Engine *engine) {
+    if (!engine->options.unbounded) {
+        trace_log("The chunked engine only runs unbounded universes (--unbounded)");
+        return false;
+    }
+
+    Chunked_Engine *ce = xcalloc(1, sizeof(Chunked_Engine));
+    ce->kernel = get_life_kernel(engine->rule.birth, engine->rule.survival);
+    ce->buckets = xcalloc(MIN_BUCKET_COUNT, sizeof(Chunk *));
+    ce->bucket_mask = MIN_BUCKET_COUNT - 1;
+
+    int thread_count = engine->options.thread_count;
+    if (thread_count <= 0) {
+        thread_count = get_online_cpu_count();
+    }
+    if (thread_count > 1) {
+        ce->pool = create_thread_pool(thread_count);
+    }
+
+    ce->window_chunks_x = (engine->grid_w + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    ce->window_chunks_y = (engine->grid_h + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    ce->window_read_stale = xmalloc((size_t)ce->window_chunks_x * ce->window_chunks_y);
+    memset(ce->window_read_stale, 1, (size_t)ce->window_chunks_x * ce->window_chunks_y);
+
+    engine->impl = ce;
+    return true;
+}
+
+static void chunked_engine_destroy(Gol_Engine *engine) {
+    Chunked_Engine *ce = engine->impl;
+    destroy_thread_pool(ce->pool);
+    for (int i = 0; i < ce->slab_count; i++) {
+        free(ce->slabs[i]);
+    }
+    free(ce->slabs);
+    free(ce->chunks);
+    free(ce->active_chunks);
+    free(ce->buckets);
+    free(ce->window_read_stale);
+    free(ce);
+}
+
+static void chunked_engine_seed(Gol_Engine *engine, const Bit_Grid *grid) {
+    Chunked_Engine *ce = engine->impl;
+    free_all_chunks(ce);
+    ce->front = 0;
+    memset(ce->window_read_stale, 1, (size_t)ce->window_chunks_x * ce->window_chunks_y);
+
+    int chunk_rows = (grid->h + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    for (int cy = 0; cy < chunk_rows; cy++) {
+        int row_count = grid->h - cy * CHUNK_SIZE < CHUNK_SIZE ? grid->h - cy * CHUNK_SIZE : CHUNK_SIZE;
+        for (int cx = 0; cx < grid->words_per_row; cx++) {
+            uint64_t any = 0;
+            for (int r = 0; r < row_count; r++) {
+                any |= get_bit_grid_row(grid, cy * CHUNK_SIZE + r)[cx];
+            }
+            if (!any) {
+                continue;
+            }
+            Chunk *chunk = create_chunk(ce, cx, cy);
+            for (int r = 0; r < row_count; r++) {
+                chunk->rows[0][r] = get_bit_grid_row(grid, cy * CHUNK_SIZE + r)[cx];
+            }
+            update_chunk_summary(chunk, chunk->rows[0]);
+        }
+    }
+    update_chunk_frontier(ce);
+
+    memset(&ce->stats, 0, sizeof(ce->stats));
+    ce->stats.total_tiles = ce->chunk_count;
+}
+
+static void chunked_engine_step(Gol_Engine *engine, uint64_t generations) {
+    Chunked_Engine *ce = engine->impl;
+    for (uint64_t i = 0; i < generations; i++) {
+        collect_active_chunks(ce);
+        if (ce->pool) {
+            run_thread_pool_tasks(ce->pool, step_chunk, ce, ce->active_chunk_count);
+        } else {
+            for (int j = 0; j < ce->active_chunk_count; j++) {
+                step_chunk(ce, j, 0);
+            }
+        }
+        ce->front = 1 - ce->front;
+        update_chunk_frontier(ce);
+
+        ce->stats.active_tiles = ce->active_chunk_count;
+        ce->stats.active_tile_steps += ce->active_chunk_count;
+        ce->stats.generations++;
+    }
+    ce->stats.total_tiles = ce->chunk_count;
+}
+
+static void chunked_engine_read_grid(Gol_Engine *engine, Bit_Grid *grid) {
+    Chunked_Engine *ce = engine->impl;
+    clear_bit_grid(grid);
+
+    uint64_t tail_mask = get_bit_grid_tail_mask(grid);
+    for (int i = 0; i < ce->chunk_count; i++) {
+        const Chunk *chunk = ce->chunks[i];
+        if (chunk->population == 0 || chunk->x < 0 || chunk->x >= grid->words_per_row ||
+            chunk->y < 0 || chunk->y * CHUNK_SIZE >= grid->h) {
+            continue;
+        }
+        int cx = (int)chunk->x;
+        int y_begin = (int)chunk->y * CHUNK_SIZE;
+        uint64_t mask = cx == grid->words_per_row - 1 ? tail_mask : ~0ull;
+        for (int r = 0; r < CHUNK_SIZE && y_begin + r < grid->h; r++) {
+            get_bit_grid_row(grid, y_begin + r)[cx] = chunk->rows[ce->front][r] & mask;
+        }
+    }
+}
+
+static void chunked_engine_read_grid_changes(Gol_Engine *engine, Bit_Grid *grid, uint8_t *changed_blocks) {
+    Chunked_Engine *ce = engine->impl;
+    memcpy(changed_blocks, ce->window_read_stale, (size_t)ce->window_chunks_x * ce->window_chunks_y);
+
+    uint64_t tail_mask = get_bit_grid_tail_mask(grid);
+    for (int cy = 0; cy < ce->window_chunks_y; cy++) {
+        for (int cx = 0; cx < ce->window_chunks_x; cx++) {
+            uint8_t *stale = &ce->window_read_stale[cy * ce->window_chunks_x + cx];
+            if (!*stale) {
+                continue;
+            }
+            *stale = 0;
+            const Chunk *chunk = find_chunk(ce, cx, cy);
+            const uint64_t *rows = chunk ? chunk->rows[ce->front] : g_empty_rows;
+            uint64_t mask = cx == grid->words_per_row - 1 ? tail_mask : ~0ull;
+            for (int r = 0; r < CHUNK_SIZE && cy * CHUNK_SIZE + r < grid->h; r++) {
+                get_bit_grid_row(grid, cy * CHUNK_SIZE + r)[cx] = rows[r] & mask;
+            }
+        }
+    }
+}
+
+// Counts the whole plane, not just the window.
+static uint64_t chunked_engine_population(Gol_Engine *engine) {
+    Chunked_Engine *ce = engine->impl;
+    uint64_t population = 0;
+    for (int i = 0; i < ce->chunk_count; i++) {
+        population += ce->chunks[i]->population;
+    }
+    return population;
+}
+
+static uint64_t chunked_engine_state_hash(Gol_Engine *engine) {
+    Chunked_Engine *ce = engine->impl;
+    uint64_t hash = 0;
+    for (int i = 0; i < ce->chunk_count; i++) {
+        Chunk *chunk = ce->chunks[i];
+        if (chunk->hash_stale) {
+            chunk->hash = 0;
+            for (int r = 0; r < CHUNK_SIZE; r++) {
+                chunk->hash += hash_bit_word(chunk->rows[ce->front][r], chunk->x, chunk->y * CHUNK_SIZE + r);
+            }
+            chunk->hash_stale = false;
+        }
+        hash += chunk->hash;
+    }
+    return hash;
+}
+
+static void chunked_engine_get_stats(Gol_Engine *engine, Engine_Stats *stats) {
+    Chunked_Engine *ce = engine->impl;
+    *stats = ce->stats;
+}
+
+static size_t chunked_engine_memory_usage(Gol_Engine *engine) {
+    Chunked_Engine *ce = engine->impl;
+    return sizeof(Chunked_Engine)
+        + (size_t)ce->slab_count * (CHUNKS_PER_SLAB * sizeof(Chunk) + sizeof(Chunk *))
+        + (size_t)ce->chunk_capacity * 2 * sizeof(Chunk *)
+        + ((size_t)ce->bucket_mask + 1) * sizeof(Chunk *)
+        + (size_t)ce->window_chunks_x * ce->window_chunks_y;
+}
+
+const Gol_Engine_Api g_chunked_engine_api = {
+    .name = "chunked",
+    .supports_rule = chunked_engine_supports_rule,
+    .init = chunked_engine_init,
+    .destroy = chunked_engine_destroy,
+    .seed = chunked_engine_seed,
+    .step = chunked_engine_step,
+    .read_grid = chunked_engine_read_grid,
+    .read_grid_changes = chunked_engine_read_grid_changes,
+    .population = chunked_engine_population,
+    .state_hash = chunked_engine_state_hash,
+    .get_stats = chunked_engine_get_stats,
+    .memory_usage = chunked_engine_memory_usage,
+};
@@ -0,0 +1,49 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "common.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+void exit_with_error(const char *msg, ...) {
+    fprintf(stderr, "FATAL: ");
+    va_list ap;
+    va_start(ap, msg);
+    vfprintf(stderr, msg, ap);
+    va_end(ap);
+    fprintf(stderr, "\n");
+    exit(1);
+}
+
+void trace_log(const char *msg, ...) {
+    printf("INFO: ");
+    va_list ap;
+    va_start(ap, msg);
+    vprintf(msg, ap);
+    va_end(ap);
+    printf("\n");
+}
+
+void *xmalloc(size_t size) {
+    void *d = malloc(size);
+    if (!d) {
+        exit_with_error("Failed to malloc");
+    }
+    return d;
+}
+
+void *xcalloc(size_t count, size_t size) {
+    void *d = calloc(count, size);
+    if (!d) {
+        exit_with_error("Failed to calloc");
+    }
+    return d;
+}
+
+uint64_t get_time_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
@@ -0,0 +1,15 @@
+#ifndef COMMON_H
+#define COMMON_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+void exit_with_error(const char *msg, ...);
+void trace_log(const char *msg, ...);
+void *xmalloc(size_t size);
+void *xcalloc(size_t count, size_t size);
+
+// Monotonic clock in nanoseconds, for timing and throughput reporting.
+uint64_t get_time_ns();
+
+#endif
@@ -0,0 +1,228 @@
+// Headless reference engine: one byte per cell, stepped on the calling thread.
+// Mirrors res/shaders/game_of_life.comp.glsl cell for cell, and is the baseline
+// the faster engines are checked against.
+//
+// Runs every rule family. A cell's byte is its state: 0 dead, 1 alive and
+// 2..states-1 dying. Life-like and Generations rules look the next state up in
+// a table indexed by state and live neighbour count. Larger than Life counts
+// its (2r+1)^2 window from a summed-area table of the live cells, built over a
+// copy padded by r on each side with the wrapped-around cells, so each count
+// is four lookups whatever the radius.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "engine.h"
+
+enum { MAX_NEIGHBORS = 8 };
+
+typedef struct {
+    uint8_t *front;
+    uint8_t *back;
+    // Life-like and Generations: next state by [state][live neighbours].
+    uint8_t (*next_state)[MAX_NEIGHBORS + 1];
+    // Larger than Life: (grid_w + 2r + 1) x (grid_h + 2r + 1) prefix sums.
+    uint32_t *window_sums;
+} Cpu_Engine;
+
+static bool cpu_engine_supports_rule(const Rule *rule) {
+    (void)rule;
+    return true;
+}
+
+static uint8_t get_dying_state(const Rule *rule, int state) {
+    return state + 1 < rule->states ? (uint8_t)(state + 1) : 0;
+}
+
+static bool cpu_engine_init(Gol_Engine *engine) {
+    const Rule *rule = &engine->rule;
+    if (rule->family == RULE_FAMILY_LARGER_THAN_LIFE &&
+        (engine->grid_w < 2 * rule->radius + 1 || engine->grid_h < 2 * rule->radius + 1)) {
+        trace_log("Rule %s needs a grid of at least %dx%d", rule->name, 2 * rule->radius + 1, 2 * rule->radius + 1);
+        return false;
+    }
+
+    size_t cell_count = (size_t)engine->grid_w * engine->grid_h;
+    Cpu_Engine *cpu = xcalloc(1, sizeof(Cpu_Engine));
+    cpu->front = xcalloc(cell_count, 1);
+    cpu->back = xcalloc(cell_count, 1);
+
+    if (rule->family == RULE_FAMILY_LARGER_THAN_LIFE) {
+        size_t sums_w = (size_t)engine->grid_w + 2 * rule->radius + 1;
+        size_t sums_h = (size_t)engine->grid_h + 2 * rule->radius + 1;
+        cpu->window_sums = xcalloc(sums_w * sums_h, sizeof(uint32_t));
+    } else {
+        cpu->next_state = xcalloc(rule->states, sizeof(*cpu->next_state));
+        for (int count = 0; count <= MAX_NEIGHBORS; count++) {
+            cpu->next_state[0][count] = (rule->birth >> count) & 1;
+            cpu->next_state[1][count] = (rule->survival >> count) & 1 ? 1 : get_dying_state(rule, 1);
+            for (int state = 2; state < rule->states; state++) {
+                cpu->next_state[state][count] = get_dying_state(rule, state);
+            }
+        }
+    }
+
+    engine->impl = cpu;
+    return true;
+}
+
+static void cpu_engine_destroy(Gol_Engine *engine) {
+    Cpu_Engine *cpu = engine->impl;
+    free(cpu->front);
+    free(cpu->back);
+    free(cpu->next_state);
+    free(cpu->window_sums);
+    free(cpu);
+}
+
+static void cpu_engine_seed(Gol_Engine *engine, const Bit_Grid *grid) {
+    Cpu_Engine *cpu = engine->impl;
+    for (int y = 0; y < engine->grid_h; y++) {
+        for (int x = 0; x < engine->grid_w; x++) {
+            cpu->front[(size_t)y * engine->grid_w + x] = get_bit_grid_cell(grid, x, y);
+        }
+    }
+}
+
+static void step_cpu_generation(const Cpu_Engine *cpu, const uint8_t *input, uint8_t *output,
+                                int grid_w, int grid_h) {
+    for (int y = 0; y < grid_h; y++) {
+        int y_up = (y - 1 + grid_h) % grid_h;
+        int y_down = (y + 1) % grid_h;
+        const uint8_t *row_up = input + (size_t)y_up * grid_w;
+        const uint8_t *row = input + (size_t)y * grid_w;
+        const uint8_t *row_down = input + (size_t)y_down * grid_w;
+
+        for (int x = 0; x < grid_w; x++) {
+            int x_left = (x - 1 + grid_w) % grid_w;
+            int x_right = (x + 1) % grid_w;
+
+            // Dying cells don't count.
+            int alive_neighbors =
+                (row_up[x_left] == 1) + (row_up[x] == 1) + (row_up[x_right] == 1) +
+                (row[x_left] == 1) + (row[x_right] == 1) +
+                (row_down[x_left] == 1) + (row_down[x] == 1) + (row_down[x_right] == 1);
+
+            output[(size_t)y * grid_w + x] = cpu->next_state[row[x]][alive_neighbors];
+        }
+    }
+}
+
+static void step_larger_than_life_generation(const Cpu_Engine *cpu, const Rule *rule,
+                                             const uint8_t *input, uint8_t *output, int grid_w, int grid_h) {
+    int r = rule->radius;
+    size_t sums_w = (size_t)grid_w + 2 * r + 1;
+    uint32_t *sums = cpu->window_sums;
+
+    // sums[py][px] counts live cells in padded rows < py and columns < px;
+    // padded cell (px, py) is grid cell (px - r, py - r), wrapped.
+    for (int py = 0; py < grid_h + 2 * r; py++) {
+        const uint8_t *row = input + (size_t)((py - r + grid_h) % grid_h) * grid_w;
+        const uint32_t *above = sums + (size_t)py * sums_w;
+        uint32_t *out = sums + (size_t)(py + 1) * sums_w;
+        uint32_t row_sum = 0;
+        for (int px = 0; px < grid_w + 2 * r; px++) {
+            row_sum += row[(px - r + grid_w) % grid_w] == 1;
+            out[px + 1] = above[px + 1] + row_sum;
+        }
+    }
+
+    // Unsigned wraparound keeps the differences exact even if the totals
+    // overflow.
+    int side = 2 * r + 1;
+    for (int y = 0; y < grid_h; y++) {
+        const uint32_t *top = sums + (size_t)y * sums_w;
+        const uint32_t *bottom = sums + (size_t)(y + side) * sums_w;
+        for (int x = 0; x < grid_w; x++) {
+            size_t i = (size_t)y * grid_w + x;
+            int state = input[i];
+            int count = (int)(bottom[x + side] - bottom[x] - top[x + side] + top[x]);
+            if (state == 1 && !rule->include_center) {
+                count--;
+            }
+
+            if (state == 0) {
+                output[i] = count >= rule->birth_min && count <= rule->birth_max;
+            } else if (state == 1) {
+                output[i] = count >= rule->survival_min && count <= rule->survival_max
+                    ? 1 : get_dying_state(rule, 1);
+            } else {
+                output[i] = get_dying_state(rule, state);
+            }
+        }
+    }
+}
+
+static void cpu_engine_step(Gol_Engine *engine, uint64_t generations) {
+    Cpu_Engine *cpu = engine->impl;
+    for (uint64_t i = 0; i < generations; i++) {
+        if (engine->rule.family == RULE_FAMILY_LARGER_THAN_LIFE) {
+            step_larger_than_life_generation(cpu, &engine->rule, cpu->front, cpu->back,
+                                             engine->grid_w, engine->grid_h);
+        } else {
+            step_cpu_generation(cpu, cpu->front, cpu->back, engine->grid_w, engine->grid_h);
+        }
+
+        uint8_t *temp = cpu->front;
+        cpu->front = cpu->back;
+        cpu->back = temp;
+    }
+}
+
+static void cpu_engine_read_grid(Gol_Engine *engine, Bit_Grid *grid) {
+    Cpu_Engine *cpu = engine->impl;
+    for (int y = 0; y < engine->grid_h; y++) {
+        for (int x = 0; x < engine->grid_w; x++) {
+            set_bit_grid_cell(grid, x, y, cpu->front[(size_t)y * engine->grid_w + x] == 1);
+        }
+    }
+}
+
+// Live cells hash as packed words, as in every engine; dying cells add a term
+// per cell for their state.
+static uint64_t cpu_engine_state_hash(Gol_Engine *engine) {
+    Cpu_Engine *cpu = engine->impl;
+    uint64_t hash = 0;
+    for (int y = 0; y < engine->grid_h; y++) {
+        const uint8_t *row = cpu->front + (size_t)y * engine->grid_w;
+        for (int word_x = 0; word_x * 64 < engine->grid_w; word_x++) {
+            uint64_t word = 0;
+            for (int bit = 0; bit < 64 && word_x * 64 + bit < engine->grid_w; bit++) {
+                int x = word_x * 64 + bit;
+                if (row[x] == 1) {
+                    word |= 1ull << bit;
+                } else if (row[x] > 1) {
+                    uint64_t position = (uint64_t)y * engine->grid_w + x;
+                    hash += mix_hash_bits(((uint64_t)row[x] << 56) ^ mix_hash_bits(position));
+                }
+            }
+            hash += hash_bit_word(word, word_x, y);
+        }
+    }
+    return hash;
+}
+
+static size_t cpu_engine_memory_usage(Gol_Engine *engine) {
+    const Rule *rule = &engine->rule;
+    size_t bytes = sizeof(Cpu_Engine) + 2 * (size_t)engine->grid_w * engine->grid_h;
+    if (rule->family == RULE_FAMILY_LARGER_THAN_LIFE) {
+        bytes += ((size_t)engine->grid_w + 2 * rule->radius + 1) *
+                 ((size_t)engine->grid_h + 2 * rule->radius + 1) * sizeof(uint32_t);
+    } else {
+        bytes += (size_t)rule->states * (MAX_NEIGHBORS + 1);
+    }
+    return bytes;
+}
+
+const Gol_Engine_Api g_cpu_engine_api = {
+    .name = "cpu",
+    .supports_rule = cpu_engine_supports_rule,
+    .init = cpu_engine_init,
+    .destroy = cpu_engine_destroy,
+    .seed = cpu_engine_seed,
+    .step = cpu_engine_step,
+    .read_grid = cpu_engine_read_grid,
+    .state_hash = cpu_engine_state_hash,
+    .memory_usage = cpu_engine_memory_usage,
+};
@@ -0,0 +1,44 @@
+#include "cycle_detector.h"
+
+#include <stdlib.h>
+
+#include "common.h"
+
+Cycle_Detector create_cycle_detector(int capacity) {
+    Cycle_Detector detector = {0};
+    detector.capacity = capacity;
+    detector.hashes = xmalloc((size_t)capacity * sizeof(uint64_t));
+    detector.generations = xmalloc((size_t)capacity * sizeof(uint64_t));
+    return detector;
+}
+
+void free_cycle_detector(Cycle_Detector *detector) {
+    free(detector->hashes);
+    free(detector->generations);
+    *detector = (Cycle_Detector){0};
+}
+
+void reset_cycle_detector(Cycle_Detector *detector) {
+    detector->count = 0;
+    detector->next = 0;
+}
+
+uint64_t record_cycle_state(Cycle_Detector *detector, uint64_t generation, uint64_t hash) {
+    // Newest first, so the shortest period wins when several match.
+    uint64_t period = 0;
+    for (int i = 1; i <= detector->count; i++) {
+        int slot = (detector->next - i + detector->capacity) % detector->capacity;
+        if (detector->hashes[slot] == hash) {
+            period = generation - detector->generations[slot];
+            break;
+        }
+    }
+
+    detector->hashes[detector->next] = hash;
+    detector->generations[detector->next] = generation;
+    detector->next = (detector->next + 1) % detector->capacity;
+    if (detector->count < detector->capacity) {
+        detector->count++;
+    }
+    return period;
+}
@@ -0,0 +1,34 @@
+#ifndef CYCLE_DETECTOR_H
+#define CYCLE_DETECTOR_H
+
+#include <stdint.h>
+
+// Spots a universe that has settled into a still life or an oscillator, from
+// its state hashes (get_engine_state_hash). The hashes of the last `capacity`
+// recorded generations sit in a ring buffer; a state that hashes like one
+// still in the ring is taken as a repeat, so periods up to `capacity` are
+// found. Record every generation for exact periods: recording every k-th
+// finds a multiple of the period.
+//
+// Only the hash is compared. Two different states colliding is a 2^-64 event
+// per pair, which is well below anything a census will run into.
+
+typedef struct {
+    uint64_t *hashes;
+    uint64_t *generations;
+    int capacity;
+    int count;
+    // Slot the next state goes in.
+    int next;
+} Cycle_Detector;
+
+Cycle_Detector create_cycle_detector(int capacity);
+void free_cycle_detector(Cycle_Detector *detector);
+void reset_cycle_detector(Cycle_Detector *detector);
+
+// Records the state of `generation` and returns the generations since the
+// same state was last recorded: 1 for a still life (an empty universe
+// included), p for a period-p oscillator, 0 if it hasn't repeated yet.
+uint64_t record_cycle_state(Cycle_Detector *detector, uint64_t generation, uint64_t hash);
+
+#endif
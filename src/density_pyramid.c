@@ -0,0 +1,200 @@
+#include "density_pyramid.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+
+enum { TILE_SIZE = 1 << DENSITY_PYRAMID_BASE_LEVEL };
+
+Density_Pyramid create_density_pyramid(int w, int h) {
+    Density_Pyramid pyramid = {0};
+    pyramid.w = w;
+    pyramid.h = h;
+    int level_w = (w + TILE_SIZE - 1) / TILE_SIZE;
+    int level_h = (h + TILE_SIZE - 1) / TILE_SIZE;
+    while (true) {
+        int i = pyramid.level_count++;
+        assert(i < DENSITY_PYRAMID_MAX_LEVELS);
+        pyramid.level_w[i] = level_w;
+        pyramid.level_h[i] = level_h;
+        pyramid.counts[i] = xcalloc((size_t)level_w * level_h, sizeof(uint64_t));
+        pyramid.dirty[i] = xcalloc((size_t)level_w * level_h, 1);
+        if (level_w == 1 && level_h == 1) {
+            break;
+        }
+        level_w = (level_w + 1) / 2;
+        level_h = (level_h + 1) / 2;
+    }
+    return pyramid;
+}
+
+void free_density_pyramid(Density_Pyramid *pyramid) {
+    for (int i = 0; i < pyramid->level_count; i++) {
+        free(pyramid->counts[i]);
+        free(pyramid->dirty[i]);
+    }
+    memset(pyramid, 0, sizeof(*pyramid));
+}
+
+int get_density_pyramid_top_level(const Density_Pyramid *pyramid) {
+    return DENSITY_PYRAMID_BASE_LEVEL + pyramid->level_count - 1;
+}
+
+static void mark_parent_dirty(Density_Pyramid *pyramid, int i, int x, int y) {
+    if (i + 1 < pyramid->level_count) {
+        pyramid->dirty[i + 1][(size_t)(y / 2) * pyramid->level_w[i + 1] + x / 2] = 1;
+    }
+}
+
+static void update_tile_count(Density_Pyramid *pyramid, int tx, int ty, uint32_t count, uint64_t *changed) {
+    uint64_t *old = &pyramid->counts[0][(size_t)ty * pyramid->level_w[0] + tx];
+    if (*old != count) {
+        pyramid->population += count;
+        pyramid->population -= *old;
+        *old = count;
+        mark_parent_dirty(pyramid, 0, tx, ty);
+        (*changed)++;
+    }
+}
+
+uint64_t update_density_pyramid(Density_Pyramid *pyramid, const Bit_Grid *grid, const uint8_t *changed_tiles) {
+    assert(grid->w == pyramid->w && grid->h == pyramid->h);
+
+    int tiles_x = pyramid->level_w[0];
+    uint64_t changed = 0;
+    bool any_flagged = !changed_tiles;
+    if (changed_tiles) {
+        // Base level: the flagged tiles, a word column at a time.
+        for (int ty = 0; ty < pyramid->level_h[0]; ty++) {
+            int y_end = (ty + 1) * TILE_SIZE < grid->h ? (ty + 1) * TILE_SIZE : grid->h;
+            for (int tx = 0; tx < tiles_x; tx++) {
+                if (!changed_tiles[(size_t)ty * tiles_x + tx]) {
+                    continue;
+                }
+                any_flagged = true;
+                uint32_t count = 0;
+                for (int y = ty * TILE_SIZE; y < y_end; y++) {
+                    count += (uint32_t)__builtin_popcountll(get_bit_grid_row(grid, y)[tx]);
+                }
+                update_tile_count(pyramid, tx, ty, count, &changed);
+            }
+        }
+    } else {
+        // Base level: one streaming pass over the grid, a tile row at a time.
+        uint32_t *tile_counts = xmalloc((size_t)tiles_x * sizeof(uint32_t));
+        for (int ty = 0; ty < pyramid->level_h[0]; ty++) {
+            memset(tile_counts, 0, (size_t)tiles_x * sizeof(uint32_t));
+            int y_end = (ty + 1) * TILE_SIZE < grid->h ? (ty + 1) * TILE_SIZE : grid->h;
+            for (int y = ty * TILE_SIZE; y < y_end; y++) {
+                const uint64_t *row = get_bit_grid_row(grid, y);
+                for (int tx = 0; tx < tiles_x; tx++) {
+                    tile_counts[tx] += (uint32_t)__builtin_popcountll(row[tx]);
+                }
+            }
+            for (int tx = 0; tx < tiles_x; tx++) {
+                update_tile_count(pyramid, tx, ty, tile_counts[tx], &changed);
+            }
+        }
+        free(tile_counts);
+    }
+
+    // Levels above: resum only the dirty texels.
+    for (int i = 1; i < pyramid->level_count && changed > 0; i++) {
+        const uint64_t *children = pyramid->counts[i - 1];
+        int child_w = pyramid->level_w[i - 1];
+        int child_h = pyramid->level_h[i - 1];
+        for (int y = 0; y < pyramid->level_h[i]; y++) {
+            for (int x = 0; x < pyramid->level_w[i]; x++) {
+                size_t index = (size_t)y * pyramid->level_w[i] + x;
+                if (!pyramid->dirty[i][index]) {
+                    continue;
+                }
+                pyramid->dirty[i][index] = 0;
+
+                uint64_t sum = 0;
+                for (int cy = 2 * y; cy < 2 * y + 2 && cy < child_h; cy++) {
+                    for (int cx = 2 * x; cx < 2 * x + 2 && cx < child_w; cx++) {
+                        sum += children[(size_t)cy * child_w + cx];
+                    }
+                }
+                if (pyramid->counts[i][index] != sum) {
+                    pyramid->counts[i][index] = sum;
+                    mark_parent_dirty(pyramid, i, x, y);
+                }
+            }
+        }
+    }
+
+    if (any_flagged) {
+        pyramid->version++;
+    }
+    return changed;
+}
+
+static uint8_t get_density_texel(uint64_t count, int level) {
+    if (count == 0) {
+        return 0;
+    }
+    // In floating point: count * 255 overflows 64 bits at the top levels of
+    // the largest grids.
+    double area = (double)(1ull << (2 * level));
+    uint64_t density = (uint64_t)((double)count * 255.0 / area + 0.5);
+    return density < 1 ? 1 : density > 255 ? 255 : (uint8_t)density;
+}
+
+void fill_density_texels(const Density_Pyramid *pyramid, const Bit_Grid *grid, int level,
+                         int x, int y, int w, int h, uint8_t *texels) {
+    assert(level >= 0 && level <= get_density_pyramid_top_level(pyramid));
+    memset(texels, 0, (size_t)w * h);
+    int64_t block = 1ll << level;
+    int64_t level_w = (pyramid->w + block - 1) / block;
+    int64_t level_h = (pyramid->h + block - 1) / block;
+    // The part of the rectangle on the grid.
+    int x_begin = x < 0 ? 0 : x;
+    int y_begin = y < 0 ? 0 : y;
+    int x_end = (int64_t)x + w < level_w ? x + w : (int)level_w;
+    int y_end = (int64_t)y + h < level_h ? y + h : (int)level_h;
+    if (x_begin >= x_end || y_begin >= y_end) {
+        return;
+    }
+
+    if (level >= DENSITY_PYRAMID_BASE_LEVEL) {
+        int i = level - DENSITY_PYRAMID_BASE_LEVEL;
+        for (int ty = y_begin; ty < y_end; ty++) {
+            const uint64_t *counts = &pyramid->counts[i][(size_t)ty * pyramid->level_w[i]];
+            uint8_t *out = &texels[(size_t)(ty - y) * w];
+            for (int tx = x_begin; tx < x_end; tx++) {
+                out[tx - x] = get_density_texel(counts[tx], level);
+            }
+        }
+        return;
+    }
+
+    // Below the base level a block is a bit field of a single word, since
+    // block sizes divide 64, and blocks in empty tiles are skipped.
+    uint64_t mask = (1ull << block) - 1;
+    uint32_t *block_counts = xmalloc((size_t)(x_end - x_begin) * sizeof(uint32_t));
+    for (int ty = y_begin; ty < y_end; ty++) {
+        memset(block_counts, 0, (size_t)(x_end - x_begin) * sizeof(uint32_t));
+        const uint64_t *tile_counts = &pyramid->counts[0][(size_t)(ty * block / TILE_SIZE) * pyramid->level_w[0]];
+        int cell_y_end = (ty + 1) * block < grid->h ? (int)((ty + 1) * block) : grid->h;
+        for (int cell_y = (int)(ty * block); cell_y < cell_y_end; cell_y++) {
+            const uint64_t *row = get_bit_grid_row(grid, cell_y);
+            for (int tx = x_begin; tx < x_end; tx++) {
+                int64_t cell_x = tx * block;
+                if (tile_counts[cell_x >> 6] == 0) {
+                    continue;
+                }
+                block_counts[tx - x_begin] += (uint32_t)__builtin_popcountll((row[cell_x >> 6] >> (cell_x & 63)) & mask);
+            }
+        }
+
+        uint8_t *out = &texels[(size_t)(ty - y) * w];
+        for (int tx = x_begin; tx < x_end; tx++) {
+            out[tx - x] = get_density_texel(block_counts[tx - x_begin], level);
+        }
+    }
+    free(block_counts);
+}
@@ -0,0 +1,58 @@
+#ifndef DENSITY_PYRAMID_H
+#define DENSITY_PYRAMID_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bit_grid.h"
+
+// Live cell counts per block, for drawing grids far larger than the screen.
+// Level L has one texel per 2^L x 2^L block of cells, anchored at (0, 0).
+//
+// Levels from DENSITY_PYRAMID_BASE_LEVEL up are stored: the base level has one
+// count per 64x64 tile (a word column of 64 rows), and each level above sums
+// 2x2 texels of the one below, up to a single texel. An update recounts the
+// tiles the caller says changed (every tile if it can't tell) and only
+// rebuilds the ancestors of tiles whose count changed. Levels below the base
+// are counted from the grid on demand, which costs at most 64 cells per texel.
+
+enum {
+    DENSITY_PYRAMID_BASE_LEVEL = 6,
+    DENSITY_PYRAMID_MAX_LEVELS = 32
+};
+
+typedef struct {
+    int w;
+    int h;
+    // Stored levels; counts[i] is level DENSITY_PYRAMID_BASE_LEVEL + i. A
+    // texel at level 16 and up can hold 2^32 or more live cells, so counts
+    // are 64-bit throughout.
+    int level_count;
+    int level_w[DENSITY_PYRAMID_MAX_LEVELS];
+    int level_h[DENSITY_PYRAMID_MAX_LEVELS];
+    uint64_t *counts[DENSITY_PYRAMID_MAX_LEVELS];
+    uint8_t *dirty[DENSITY_PYRAMID_MAX_LEVELS];
+    // Sum of the base level.
+    uint64_t population;
+    // Bumped by every update that may have changed the grid: even when no
+    // count changed, the grid the lower levels are counted from may have.
+    uint64_t version;
+} Density_Pyramid;
+
+Density_Pyramid create_density_pyramid(int w, int h);
+void free_density_pyramid(Density_Pyramid *pyramid);
+// grid must be pyramid-sized. changed_tiles flags the base-level tiles whose
+// cells may differ from the last update, one byte each, row-major; NULL
+// means all of them. Returns how many tiles changed count.
+uint64_t update_density_pyramid(Density_Pyramid *pyramid, const Bit_Grid *grid, const uint8_t *changed_tiles);
+// The coarsest useful level: one texel covers the whole grid.
+int get_density_pyramid_top_level(const Density_Pyramid *pyramid);
+
+// Writes the density of texels [x, x + w) x [y, y + h) of level into
+// texels, row-major and w wide: 0 for no live cells, 255 for all, and at
+// least 1 for any, so a lone glider stays visible from far out. grid must be
+// the one the pyramid was last updated from. Texels off the grid are 0.
+void fill_density_texels(const Density_Pyramid *pyramid, const Bit_Grid *grid, int level,
+                         int x, int y, int w, int h, uint8_t *texels);
+
+#endif
@@ -0,0 +1,482 @@
+#define _POSIX_C_SOURCE 200809L
+
+// Packed engine split across worker processes. The torus is cut into
+// horizontal bands of whole rows, one per worker (Engine_Options
+// process_count), so each band wraps around horizontally on its own and only
+// shares edges with the bands above and below. A worker owns its band as a
+// Bit_Grid with one halo row above and below, and no process ever holds the
+// whole grid: the engine itself keeps only the control sockets, and seeding
+// and readback stream each band through its worker's socket.
+//
+// Neighbouring workers are connected by a Unix socket pair per band
+// boundary. Each generation, a worker sends its top and bottom rows to the
+// bands above and below and steps its interior rows, which don't need the
+// halo, while those rows and its own halos are in flight on non-blocking
+// sockets. Only the first and last rows wait for the exchange. With one
+// worker the boundary's pair connects the band to itself.
+//
+// Workers handle commands strictly in order and only between generations,
+// so a population, hash or readback sent after a step reports exactly the
+// generation it follows. Steps are not acknowledged: step() only queues
+// them, and finish() waits for every worker to drain its queue.
+//
+// The band's cells go through step_life_region like the bitpacked engine's
+// tiles, so the result is bit-for-bit the same. Only Life-like rules without
+// B0 run here.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "bit_grid.h"
+#include "common.h"
+#include "engine.h"
+#include "life_kernel.h"
+#include "thread_pool.h"
+
+enum {
+    // Interior rows stepped between polls of the halo exchange.
+    INTERIOR_CHUNK_ROWS = 64,
+    // Transfers in one halo exchange: a row to and from each neighbour.
+    HALO_TRANSFERS = 4
+};
+
+typedef enum {
+    WORKER_SEED,
+    WORKER_STEP,
+    WORKER_READ,
+    WORKER_POPULATION,
+    WORKER_HASH,
+    WORKER_SYNC,
+    WORKER_QUIT
+} Worker_Command_Type;
+
+typedef struct {
+    uint32_t type;
+    uint32_t pad;
+    // Generations for WORKER_STEP.
+    uint64_t value;
+} Worker_Command;
+
+typedef struct {
+    pid_t pid;
+    // The engine's end of the worker's control socket.
+    int control_fd;
+    int y_begin;
+    int y_end;
+} Worker_Handle;
+
+typedef struct {
+    Worker_Handle *workers;
+    int worker_count;
+} Distributed_Engine;
+
+// The worker process's side.
+typedef struct {
+    int control_fd;
+    int north_fd;
+    int south_fd;
+    int y_begin;
+    int band_h;
+    // Band rows 1..band_h; rows 0 and band_h + 1 are the halos.
+    Bit_Grid front;
+    Bit_Grid back;
+    Life_Kernel kernel;
+} Band_Worker;
+
+typedef struct {
+    int fd;
+    bool send;
+    uint8_t *data;
+    size_t size;
+    size_t done;
+} Halo_Transfer;
+
+static bool write_all(int fd, const void *data, size_t size) {
+    const uint8_t *bytes = data;
+    while (size > 0) {
+        ssize_t written = send(fd, bytes, size, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        bytes += written;
+        size -= (size_t)written;
+    }
+    return true;
+}
+
+static bool read_all(int fd, void *data, size_t size) {
+    uint8_t *bytes = data;
+    while (size > 0) {
+        ssize_t received = recv(fd, bytes, size, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        bytes += received;
+        size -= (size_t)received;
+    }
+    return true;
+}
+
+// Moves whatever the sockets take or have without blocking. Returns true once
+// every transfer is complete.
+static bool pump_halo_transfers(Halo_Transfer *transfers, int count) {
+    bool complete = true;
+    for (int i = 0; i < count; i++) {
+        Halo_Transfer *transfer = &transfers[i];
+        while (transfer->done < transfer->size) {
+            uint8_t *data = transfer->data + transfer->done;
+            size_t size = transfer->size - transfer->done;
+            ssize_t moved = transfer->send ? send(transfer->fd, data, size, MSG_NOSIGNAL | MSG_DONTWAIT)
+                                           : recv(transfer->fd, data, size, MSG_DONTWAIT);
+            if (moved > 0) {
+                transfer->done += (size_t)moved;
+            } else if (moved < 0 && errno == EINTR) {
+                continue;
+            } else if (moved < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            } else {
+                // A neighbour is gone; the engine will see this worker's
+                // control socket close.
+                _exit(1);
+            }
+        }
+        complete = complete && transfer->done == transfer->size;
+    }
+    return complete;
+}
+
+static void finish_halo_transfers(Halo_Transfer *transfers, int count) {
+    while (!pump_halo_transfers(transfers, count)) {
+        struct pollfd fds[HALO_TRANSFERS];
+        int fd_count = 0;
+        for (int i = 0; i < count; i++) {
+            if (transfers[i].done < transfers[i].size) {
+                fds[fd_count].fd = transfers[i].fd;
+                fds[fd_count].events = transfers[i].send ? POLLOUT : POLLIN;
+                fd_count++;
+            }
+        }
+        poll(fds, fd_count, -1);
+    }
+}
+
+static void step_band(Band_Worker *worker) {
+    Bit_Grid *front = &worker->front;
+    int band_h = worker->band_h;
+    size_t row_size = (size_t)front->words_per_row * sizeof(uint64_t);
+
+    // The top row goes north and becomes that band's bottom halo, and the
+    // bottom row likewise goes south.
+    Halo_Transfer transfers[HALO_TRANSFERS] = {
+        { worker->north_fd, true, (uint8_t *)get_bit_grid_row(front, 1), row_size, 0 },
+        { worker->south_fd, true, (uint8_t *)get_bit_grid_row(front, band_h), row_size, 0 },
+        { worker->north_fd, false, (uint8_t *)get_bit_grid_row(front, 0), row_size, 0 },
+        { worker->south_fd, false, (uint8_t *)get_bit_grid_row(front, band_h + 1), row_size, 0 },
+    };
+    pump_halo_transfers(transfers, HALO_TRANSFERS);
+
+    for (int y = 2; y < band_h; y += INTERIOR_CHUNK_ROWS) {
+        int y_end = y + INTERIOR_CHUNK_ROWS < band_h ? y + INTERIOR_CHUNK_ROWS : band_h;
+        step_life_region(&worker->kernel, front, &worker->back, y, y_end, 0, front->words_per_row);
+        pump_halo_transfers(transfers, HALO_TRANSFERS);
+    }
+    finish_halo_transfers(transfers, HALO_TRANSFERS);
+
+    step_life_region(&worker->kernel, front, &worker->back, 1, 2, 0, front->words_per_row);
+    if (band_h > 1) {
+        step_life_region(&worker->kernel, front, &worker->back, band_h, band_h + 1, 0, front->words_per_row);
+    }
+
+    Bit_Grid temp = worker->front;
+    worker->front = worker->back;
+    worker->back = temp;
+}
+
+static uint64_t hash_band(const Band_Worker *worker) {
+    uint64_t hash = 0;
+    for (int y = 1; y <= worker->band_h; y++) {
+        const uint64_t *row = get_bit_grid_row(&worker->front, y);
+        for (int i = 0; i < worker->front.words_per_row; i++) {
+            if (row[i]) {
+                hash += hash_bit_word(row[i], i, worker->y_begin + y - 1);
+            }
+        }
+    }
+    return hash;
+}
+
+static uint64_t count_band_population(const Band_Worker *worker) {
+    uint64_t population = 0;
+    for (int y = 1; y <= worker->band_h; y++) {
+        const uint64_t *row = get_bit_grid_row(&worker->front, y);
+        for (int i = 0; i < worker->front.words_per_row; i++) {
+            population += (uint64_t)__builtin_popcountll(row[i]);
+        }
+    }
+    return population;
+}
+
+static void run_band_worker(Band_Worker *worker) {
+    size_t band_size = (size_t)worker->band_h * worker->front.words_per_row * sizeof(uint64_t);
+    uint64_t *band_rows = get_bit_grid_row(&worker->front, 1);
+
+    Worker_Command command;
+    while (read_all(worker->control_fd, &command, sizeof(command))) {
+        uint64_t reply = 0;
+        switch (command.type) {
+        case WORKER_SEED:
+            band_rows = get_bit_grid_row(&worker->front, 1);
+            if (!read_all(worker->control_fd, band_rows, band_size)) {
+                return;
+            }
+            continue;
+        case WORKER_STEP:
+            for (uint64_t i = 0; i < command.value; i++) {
+                step_band(worker);
+            }
+            continue;
+        case WORKER_READ:
+            band_rows = get_bit_grid_row(&worker->front, 1);
+            if (!write_all(worker->control_fd, band_rows, band_size)) {
+                return;
+            }
+            continue;
+        case WORKER_POPULATION:
+            reply = count_band_population(worker);
+            break;
+        case WORKER_HASH:
+            reply = hash_band(worker);
+            break;
+        case WORKER_SYNC:
+            break;
+        default:
+            return;
+        }
+        if (!write_all(worker->control_fd, &reply, sizeof(reply))) {
+            return;
+        }
+    }
+}
+
+static void set_non_blocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+static void close_fds(int *fds, int count) {
+    for (int i = 0; i < count; i++) {
+        if (fds[i] >= 0) {
+            close(fds[i]);
+            fds[i] = -1;
+        }
+    }
+}
+
+static void send_worker_command(Gol_Engine *engine, int worker_index, Worker_Command_Type type, uint64_t value) {
+    Distributed_Engine *distributed = engine->impl;
+    Worker_Command command = { (uint32_t)type, 0, value };
+    if (!write_all(distributed->workers[worker_index].control_fd, &command, sizeof(command))) {
+        exit_with_error("Distributed worker %d exited unexpectedly", worker_index);
+    }
+}
+
+static void read_worker_reply(Gol_Engine *engine, int worker_index, void *data, size_t size) {
+    Distributed_Engine *distributed = engine->impl;
+    if (!read_all(distributed->workers[worker_index].control_fd, data, size)) {
+        exit_with_error("Distributed worker %d exited unexpectedly", worker_index);
+    }
+}
+
+// Sends type to every worker, then sums their replies, so they all work on
+// it at once.
+static uint64_t sum_worker_replies(Gol_Engine *engine, Worker_Command_Type type) {
+    Distributed_Engine *distributed = engine->impl;
+    for (int i = 0; i < distributed->worker_count; i++) {
+        send_worker_command(engine, i, type, 0);
+    }
+    uint64_t sum = 0;
+    for (int i = 0; i < distributed->worker_count; i++) {
+        uint64_t reply;
+        read_worker_reply(engine, i, &reply, sizeof(reply));
+        sum += reply;
+    }
+    return sum;
+}
+
+static bool distributed_engine_supports_rule(const Rule *rule) {
+    return rule->family == RULE_FAMILY_LIFE && !(rule->birth & 1);
+}
+
+static bool distributed_engine_init(Gol_Engine *engine) {
+    if (engine->options.unbounded) {
+        trace_log("The distributed engine only runs toroidal grids");
+        return false;
+    }
+    int worker_count = engine->options.process_count > 0 ? engine->options.process_count : get_online_cpu_count();
+    // Every band needs at least one row.
+    if (worker_count > engine->grid_h) {
+        worker_count = engine->grid_h;
+    }
+
+    // Boundary i joins the bottom of band i (end 0) to the top of band i + 1
+    // (end 1), wrapping around.
+    int *boundary_fds = xmalloc(2 * worker_count * sizeof(int));
+    int *control_fds = xmalloc(2 * worker_count * sizeof(int));
+    for (int i = 0; i < worker_count; i++) {
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, &boundary_fds[2 * i]) != 0 ||
+            socketpair(AF_UNIX, SOCK_STREAM, 0, &control_fds[2 * i]) != 0) {
+            exit_with_error("Failed to create the distributed engine's sockets");
+        }
+    }
+
+    // Bound here so the workers inherit the kernel selection.
+    Life_Kernel kernel = get_life_kernel(engine->rule.birth, engine->rule.survival);
+
+    Distributed_Engine *distributed = xcalloc(1, sizeof(Distributed_Engine));
+    distributed->workers = xcalloc(worker_count, sizeof(Worker_Handle));
+    distributed->worker_count = worker_count;
+    engine->impl = distributed;
+
+    for (int i = 0; i < worker_count; i++) {
+        Worker_Handle *handle = &distributed->workers[i];
+        handle->y_begin = (int)((int64_t)engine->grid_h * i / worker_count);
+        handle->y_end = (int)((int64_t)engine->grid_h * (i + 1) / worker_count);
+        handle->control_fd = control_fds[2 * i];
+
+        pid_t pid = fork();
+        if (pid < 0) {
+            exit_with_error("Failed to start distributed worker %d", i);
+        }
+        if (pid == 0) {
+            Band_Worker worker = {0};
+            worker.control_fd = control_fds[2 * i + 1];
+            worker.south_fd = boundary_fds[2 * i];
+            worker.north_fd = boundary_fds[2 * ((i + worker_count - 1) % worker_count) + 1];
+            for (int fd = 0; fd < 2 * worker_count; fd++) {
+                if (control_fds[fd] >= 0 && control_fds[fd] != worker.control_fd) {
+                    close(control_fds[fd]);
+                }
+                if (boundary_fds[fd] != worker.south_fd && boundary_fds[fd] != worker.north_fd) {
+                    close(boundary_fds[fd]);
+                }
+            }
+            set_non_blocking(worker.north_fd);
+            set_non_blocking(worker.south_fd);
+
+            worker.y_begin = handle->y_begin;
+            worker.band_h = handle->y_end - handle->y_begin;
+            worker.front = create_bit_grid(engine->grid_w, worker.band_h + 2);
+            worker.back = create_bit_grid(engine->grid_w, worker.band_h + 2);
+            worker.kernel = kernel;
+            run_band_worker(&worker);
+            // Skip the parent's atexit handlers and stdio buffers.
+            _exit(0);
+        }
+        handle->pid = pid;
+        close(control_fds[2 * i + 1]);
+        control_fds[2 * i + 1] = -1;
+    }
+
+    close_fds(boundary_fds, 2 * worker_count);
+    free(boundary_fds);
+    free(control_fds);
+    return true;
+}
+
+static void distributed_engine_destroy(Gol_Engine *engine) {
+    Distributed_Engine *distributed = engine->impl;
+    for (int i = 0; i < distributed->worker_count; i++) {
+        Worker_Command command = { WORKER_QUIT, 0, 0 };
+        write_all(distributed->workers[i].control_fd, &command, sizeof(command));
+        close(distributed->workers[i].control_fd);
+    }
+    for (int i = 0; i < distributed->worker_count; i++) {
+        waitpid(distributed->workers[i].pid, NULL, 0);
+    }
+    free(distributed->workers);
+    free(distributed);
+}
+
+static void distributed_engine_seed(Gol_Engine *engine, const Bit_Grid *grid) {
+    Distributed_Engine *distributed = engine->impl;
+    for (int i = 0; i < distributed->worker_count; i++) {
+        Worker_Handle *handle = &distributed->workers[i];
+        send_worker_command(engine, i, WORKER_SEED, 0);
+        size_t band_size = (size_t)(handle->y_end - handle->y_begin) * grid->words_per_row * sizeof(uint64_t);
+        if (!write_all(handle->control_fd, get_bit_grid_row(grid, handle->y_begin), band_size)) {
+            exit_with_error("Distributed worker %d exited unexpectedly", i);
+        }
+    }
+}
+
+static void distributed_engine_step(Gol_Engine *engine, uint64_t generations) {
+    Distributed_Engine *distributed = engine->impl;
+    if (generations == 0) {
+        return;
+    }
+    for (int i = 0; i < distributed->worker_count; i++) {
+        send_worker_command(engine, i, WORKER_STEP, generations);
+    }
+}
+
+static void distributed_engine_read_grid(Gol_Engine *engine, Bit_Grid *grid) {
+    Distributed_Engine *distributed = engine->impl;
+    for (int i = 0; i < distributed->worker_count; i++) {
+        send_worker_command(engine, i, WORKER_READ, 0);
+    }
+    for (int i = 0; i < distributed->worker_count; i++) {
+        Worker_Handle *handle = &distributed->workers[i];
+        size_t band_size = (size_t)(handle->y_end - handle->y_begin) * grid->words_per_row * sizeof(uint64_t);
+        read_worker_reply(engine, i, get_bit_grid_row(grid, handle->y_begin), band_size);
+    }
+}
+
+static uint64_t distributed_engine_population(Gol_Engine *engine) {
+    return sum_worker_replies(engine, WORKER_POPULATION);
+}
+
+static uint64_t distributed_engine_state_hash(Gol_Engine *engine) {
+    return sum_worker_replies(engine, WORKER_HASH);
+}
+
+static void distributed_engine_finish(Gol_Engine *engine) {
+    sum_worker_replies(engine, WORKER_SYNC);
+}
+
+// Counts the workers' bands too, though they live in other processes.
+static size_t distributed_engine_memory_usage(Gol_Engine *engine) {
+    Distributed_Engine *distributed = engine->impl;
+    size_t words_per_row = (size_t)(engine->grid_w + 63) / 64;
+    size_t bytes = sizeof(Distributed_Engine) + distributed->worker_count * sizeof(Worker_Handle);
+    for (int i = 0; i < distributed->worker_count; i++) {
+        const Worker_Handle *handle = &distributed->workers[i];
+        bytes += 2 * (size_t)(handle->y_end - handle->y_begin + 2) * words_per_row * sizeof(uint64_t);
+    }
+    return bytes;
+}
+
+const Gol_Engine_Api g_distributed_engine_api = {
+    .name = "distributed",
+    .supports_rule = distributed_engine_supports_rule,
+    .init = distributed_engine_init,
+    .destroy = distributed_engine_destroy,
+    .seed = distributed_engine_seed,
+    .step = distributed_engine_step,
+    .read_grid = distributed_engine_read_grid,
+    .population = distributed_engine_population,
+    .state_hash = distributed_engine_state_hash,
+    .finish = distributed_engine_finish,
+    .memory_usage = distributed_engine_memory_usage,
+};
@@ -0,0 +1,167 @@
+#include "engine.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "profiler.h"
+
+static const Gol_Engine_Api *g_engine_apis[] = {
+    &g_cpu_engine_api,
+    &g_bitpacked_engine_api,
+    &g_hashlife_engine_api,
+    &g_chunked_engine_api,
+    &g_distributed_engine_api,
+    &g_gl_engine_api,
+};
+
+enum { ENGINE_API_COUNT = sizeof(g_engine_apis) / sizeof(g_engine_apis[0]) };
+
+const Gol_Engine_Api *find_engine_api(const char *name) {
+    for (int i = 0; i < ENGINE_API_COUNT; i++) {
+        if (strcmp(g_engine_apis[i]->name, name) == 0) {
+            return g_engine_apis[i];
+        }
+    }
+    return NULL;
+}
+
+void list_engine_names(char *buffer, int buffer_size) {
+    int offset = 0;
+    buffer[0] = '\0';
+    for (int i = 0; i < ENGINE_API_COUNT && offset < buffer_size; i++) {
+        offset += snprintf(buffer + offset, buffer_size - offset, "%s%s",
+                           i > 0 ? ", " : "", g_engine_apis[i]->name);
+    }
+}
+
+Gol_Engine *create_engine(const Gol_Engine_Api *api, int grid_w, int grid_h,
+                          const Engine_Options *options) {
+    Gol_Engine *engine = xcalloc(1, sizeof(Gol_Engine));
+    engine->api = api;
+    engine->grid_w = grid_w;
+    engine->grid_h = grid_h;
+    if (options) {
+        engine->options = *options;
+    }
+    engine->rule = options && options->rule ? *options->rule : get_conway_rule();
+    engine->options.rule = &engine->rule;
+
+    if (!is_conway_rule(&engine->rule) && (!api->supports_rule || !api->supports_rule(&engine->rule))) {
+        trace_log("Engine '%s' doesn't support rule %s", api->name, engine->rule.name);
+        free(engine);
+        return NULL;
+    }
+    if (!api->init(engine)) {
+        free(engine);
+        return NULL;
+    }
+    return engine;
+}
+
+void destroy_engine(Gol_Engine *engine) {
+    if (!engine) {
+        return;
+    }
+    engine->api->destroy(engine);
+    free(engine);
+}
+
+void seed_engine(Gol_Engine *engine, const Bit_Grid *grid) {
+    Profile_Zone zone = begin_profile_zone("seed");
+    engine->api->seed(engine, grid);
+    end_profile_zone(zone);
+    engine->generation = 0;
+}
+
+// Asynchronous engines only queue the work here; finish_engine is where
+// they wait for it.
+void step_engine(Gol_Engine *engine, uint64_t generations) {
+    Profile_Zone zone = begin_profile_zone("step");
+    engine->api->step(engine, generations);
+    end_profile_zone(zone);
+    engine->generation += generations;
+}
+
+void read_engine_grid(Gol_Engine *engine, Bit_Grid *grid) {
+    Profile_Zone zone = begin_profile_zone("read_grid");
+    engine->api->read_grid(engine, grid);
+    end_profile_zone(zone);
+}
+
+void read_engine_grid_changes(Gol_Engine *engine, Bit_Grid *grid, uint8_t *changed_blocks) {
+    Profile_Zone zone = begin_profile_zone("read_grid");
+    if (engine->api->read_grid_changes) {
+        engine->api->read_grid_changes(engine, grid, changed_blocks);
+    } else {
+        engine->api->read_grid(engine, grid);
+        memset(changed_blocks, 1, get_changed_block_count(grid->w, grid->h));
+    }
+    end_profile_zone(zone);
+}
+
+size_t get_changed_block_count(int grid_w, int grid_h) {
+    return (size_t)((grid_w + CHANGED_BLOCK_SIZE - 1) / CHANGED_BLOCK_SIZE) *
+           ((grid_h + CHANGED_BLOCK_SIZE - 1) / CHANGED_BLOCK_SIZE);
+}
+
+void flag_changed_blocks(uint8_t *changed_blocks, int grid_w, int x_begin, int y_begin, int x_end, int y_end) {
+    int blocks_x = (grid_w + CHANGED_BLOCK_SIZE - 1) / CHANGED_BLOCK_SIZE;
+    for (int by = y_begin / CHANGED_BLOCK_SIZE; by <= (y_end - 1) / CHANGED_BLOCK_SIZE; by++) {
+        for (int bx = x_begin / CHANGED_BLOCK_SIZE; bx <= (x_end - 1) / CHANGED_BLOCK_SIZE; bx++) {
+            changed_blocks[(size_t)by * blocks_x + bx] = 1;
+        }
+    }
+}
+
+uint64_t get_engine_population(Gol_Engine *engine) {
+    if (engine->api->population) {
+        return engine->api->population(engine);
+    }
+
+    Bit_Grid grid = create_bit_grid(engine->grid_w, engine->grid_h);
+    read_engine_grid(engine, &grid);
+    uint64_t population = count_bit_grid_population(&grid);
+    free_bit_grid(&grid);
+    return population;
+}
+
+uint64_t get_engine_state_hash(Gol_Engine *engine) {
+    if (engine->api->state_hash) {
+        Profile_Zone zone = begin_profile_zone("state_hash");
+        uint64_t hash = engine->api->state_hash(engine);
+        end_profile_zone(zone);
+        return hash;
+    }
+
+    Bit_Grid grid = create_bit_grid(engine->grid_w, engine->grid_h);
+    read_engine_grid(engine, &grid);
+    uint64_t hash = hash_bit_grid(&grid);
+    free_bit_grid(&grid);
+    return hash;
+}
+
+bool can_hash_engine_state(const Gol_Engine *engine) {
+    return engine->api->state_hash || engine->rule.states <= 2;
+}
+
+bool get_engine_stats(Gol_Engine *engine, Engine_Stats *stats) {
+    if (!engine->api->get_stats) {
+        return false;
+    }
+    engine->api->get_stats(engine, stats);
+    return true;
+}
+
+size_t get_engine_memory_usage(Gol_Engine *engine) {
+    return engine->api->memory_usage ? engine->api->memory_usage(engine) : 0;
+}
+
+void finish_engine(Gol_Engine *engine) {
+    if (engine->api->finish) {
+        Profile_Zone zone = begin_profile_zone("finish");
+        engine->api->finish(engine);
+        end_profile_zone(zone);
+    }
+}
@@ -0,0 +1,139 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "bit_grid.h"
+#include "rule.h"
+
+// A simulation backend. Every engine steps the same toroidal universe of
+// grid_w x grid_h cells under the same rule (B3/S23 unless Engine_Options.rule
+// says otherwise); they differ only in where and how the work runs.
+// step() takes a generation count rather than stepping once, so engines that
+// can jump (HashLife) get the whole span at once.
+//
+// Grids cross the interface packed 64 cells per word (see bit_grid.h), sized
+// exactly grid_w x grid_h. They hold live cells only: seeding a rule with dying
+// states starts every cell alive or dead, and reading one back drops the
+// dying cells.
+
+typedef struct Gol_Engine Gol_Engine;
+
+// Incremental readback reports what it rewrote in square blocks of this many
+// cells, one byte per block, row-major: (grid_w + 63) / 64 per row.
+enum { CHANGED_BLOCK_SIZE = 64 };
+
+// Tuning knobs shared by all engines; each engine reads the ones it supports.
+// Zero means "engine default" throughout.
+typedef struct {
+    int thread_count;
+    // Memory budget for engines with caches (HashLife). Soft: caches are
+    // evicted to stay under it, but live state may grow past it.
+    size_t memory_limit_mb;
+    // Treat the grid as a window at (0, 0) onto an infinite dead plane instead
+    // of a torus. Only engines that can grow support it.
+    bool unbounded;
+    // Step every tile every generation instead of only the active ones.
+    bool dense;
+    // Generations advanced per pass over a tile held in local/shared memory
+    // (temporal blocking); 0 or 1 steps one generation per pass.
+    int temporal_block_generations;
+    // Worker processes for the distributed engine; zero means one per CPU.
+    int process_count;
+    // NULL means B3/S23. Copied into the engine, so it needn't outlive it.
+    const Rule *rule;
+} Engine_Options;
+
+// Work done by engines that skip settled regions. A tile is the engine's unit
+// of stepping (a workgroup on the GPU); an active tile is one it stepped.
+typedef struct {
+    uint64_t total_tiles;
+    uint64_t active_tiles;
+    // Active tiles summed over `generations` generations.
+    uint64_t active_tile_steps;
+    uint64_t generations;
+} Engine_Stats;
+
+typedef struct {
+    const char *name;
+    // Allocates engine resources for engine->grid_w x engine->grid_h.
+    // Returns false if the engine can't run here (e.g. no GL context).
+    bool (*init)(Gol_Engine *engine);
+    void (*destroy)(Gol_Engine *engine);
+    void (*seed)(Gol_Engine *engine, const Bit_Grid *grid);
+    void (*step)(Gol_Engine *engine, uint64_t generations);
+    void (*read_grid)(Gol_Engine *engine, Bit_Grid *grid);
+    // Optional: read_grid into a grid that holds what the previous call left
+    // there, rewriting only what may have changed since. Every byte of
+    // changed_blocks is written: 1 for each block rewritten. The first call
+    // after a seed rewrites everything.
+    void (*read_grid_changes)(Gol_Engine *engine, Bit_Grid *grid, uint8_t *changed_blocks);
+    // Optional: live cell count without a full readback.
+    uint64_t (*population)(Gol_Engine *engine);
+    // Optional: activity statistics since the last seed.
+    void (*get_stats)(Gol_Engine *engine, Engine_Stats *stats);
+    // Optional: bytes currently held by the engine (host and device).
+    size_t (*memory_usage)(Gol_Engine *engine);
+    // Optional: blocks until every queued step has completed. Engines that
+    // step synchronously leave this NULL.
+    void (*finish)(Gol_Engine *engine);
+    // Optional: hash_bit_grid of the current state (see bit_grid.h), kept up
+    // to date incrementally. Engines with dying states must fold them in.
+    uint64_t (*state_hash)(Gol_Engine *engine);
+    // Optional: whether the engine can step rule. Engines without it only run
+    // B3/S23.
+    bool (*supports_rule)(const Rule *rule);
+} Gol_Engine_Api;
+
+struct Gol_Engine {
+    const Gol_Engine_Api *api;
+    int grid_w;
+    int grid_h;
+    uint64_t generation;
+    Engine_Options options;
+    Rule rule;
+    void *impl;
+};
+
+extern const Gol_Engine_Api g_cpu_engine_api;
+extern const Gol_Engine_Api g_bitpacked_engine_api;
+extern const Gol_Engine_Api g_hashlife_engine_api;
+extern const Gol_Engine_Api g_chunked_engine_api;
+extern const Gol_Engine_Api g_distributed_engine_api;
+extern const Gol_Engine_Api g_gl_engine_api;
+
+const Gol_Engine_Api *find_engine_api(const char *name);
+void list_engine_names(char *buffer, int buffer_size);
+
+// Returns NULL (and logs why) if the engine can't run the rule or failed to
+// initialize. options may be NULL.
+Gol_Engine *create_engine(const Gol_Engine_Api *api, int grid_w, int grid_h,
+                          const Engine_Options *options);
+void destroy_engine(Gol_Engine *engine);
+void seed_engine(Gol_Engine *engine, const Bit_Grid *grid);
+void step_engine(Gol_Engine *engine, uint64_t generations);
+void read_engine_grid(Gol_Engine *engine, Bit_Grid *grid);
+// Keeps grid in step with the engine by rewriting the blocks flagged in
+// changed_blocks (get_changed_block_count bytes). grid must be left alone
+// between calls. Without a read_grid_changes hook, reads it all and flags
+// every block.
+void read_engine_grid_changes(Gol_Engine *engine, Bit_Grid *grid, uint8_t *changed_blocks);
+size_t get_changed_block_count(int grid_w, int grid_h);
+// Flags the blocks overlapping cells [x_begin, x_end) x [y_begin, y_end).
+void flag_changed_blocks(uint8_t *changed_blocks, int grid_w, int x_begin, int y_begin, int x_end, int y_end);
+uint64_t get_engine_population(Gol_Engine *engine);
+// Equal states hash equally across engines; without a state_hash hook the
+// state is read back and hashed whole (only the window, if unbounded).
+uint64_t get_engine_state_hash(Gol_Engine *engine);
+// False if get_engine_state_hash would miss state: dying cells of an engine
+// that only hashes what read_grid returns.
+bool can_hash_engine_state(const Gol_Engine *engine);
+// Returns false if the engine doesn't track activity.
+bool get_engine_stats(Gol_Engine *engine, Engine_Stats *stats);
+// Returns 0 if the engine doesn't report its footprint.
+size_t get_engine_memory_usage(Gol_Engine *engine);
+void finish_engine(Gol_Engine *engine);
+
+#endif
@@ -0,0 +1,244 @@
+// Batched GPU engine: each universe is a layer of two R8 array textures, and a
+// generation is one dispatch of batch_step.comp.glsl over every layer (with a
+// cell per invocation, as in gl_engine.c) plus a tiny batch_resolve pass that
+// updates each universe's status from the counts the step accumulated. Status
+// stays on the GPU in one SSBO, so a step of many generations is recorded
+// without any readback; read_batch_status is the only sync point.
+//
+// Finished universes copy their final cells into the other texture for one
+// generation and are skipped after that. Seeding and readback reuse the
+// unpack and pack shaders on a single layer bound as a 2D image.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glad/glad.h>
+
+#include "batch_engine.h"
+#include "common.h"
+#include "gl_util.h"
+
+#define BATCH_STEP_COMPUTE_SHADER "res/shaders/batch_step.comp.glsl"
+#define BATCH_RESOLVE_COMPUTE_SHADER "res/shaders/batch_resolve.comp.glsl"
+#define UNPACK_GRID_COMPUTE_SHADER "res/shaders/unpack_grid.comp.glsl"
+#define PACK_GRID_COMPUTE_SHADER "res/shaders/pack_grid.comp.glsl"
+
+enum {
+    TILE_SIZE = 16,
+    RESOLVE_GROUP_SIZE = 64
+};
+
+// Layout of Universe_Status in the shaders.
+typedef struct {
+    uint32_t generation;
+    uint32_t population;
+    uint32_t period;
+    uint32_t finished;
+    uint32_t next_population;
+    uint32_t changed;
+    uint32_t changed_since_previous;
+    uint32_t pad;
+} Gpu_Universe_Status;
+
+typedef struct {
+    uint32_t step_shader;
+    uint32_t resolve_shader;
+    uint32_t unpack_grid_shader;
+    uint32_t pack_grid_shader;
+    uint32_t grid_tex_front;
+    uint32_t grid_tex_back;
+    uint32_t status_buffer;
+    uint32_t packed_buffer;
+    Gpu_Universe_Status *status_scratch;
+} Gl_Batch;
+
+static size_t get_packed_universe_size(const Batch_Engine *batch) {
+    return (size_t)((batch->grid_w + 63) / 64) * batch->grid_h * sizeof(uint64_t);
+}
+
+static void set_grid_size_uniform(uint32_t program, const Batch_Engine *batch) {
+    glUseProgram(program);
+    glUniform2i(glGetUniformLocation(program, "grid_size"), batch->grid_w, batch->grid_h);
+    glUseProgram(0);
+}
+
+static bool gl_batch_init(Batch_Engine *batch) {
+    // glad leaves every entry point NULL until a context has been loaded.
+    if (!glDispatchCompute) {
+        return false;
+    }
+    int max_layers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+    if (batch->universe_count > max_layers) {
+        trace_log("GL batches are limited to %d universes", max_layers);
+        return false;
+    }
+
+    Gl_Batch *gl = xcalloc(1, sizeof(Gl_Batch));
+    batch->impl = gl;
+
+    gl->step_shader = build_rule_compute_shader(&batch->rule, BATCH_STEP_COMPUTE_SHADER, "");
+    set_grid_size_uniform(gl->step_shader, batch);
+    gl->resolve_shader = build_compute_shader(BATCH_RESOLVE_COMPUTE_SHADER);
+    glUseProgram(gl->resolve_shader);
+    glUniform1i(glGetUniformLocation(gl->resolve_shader, "universe_count"), batch->universe_count);
+    glUniform1ui(glGetUniformLocation(gl->resolve_shader, "max_generations"),
+                 (uint32_t)batch->options.max_generations);
+    glUseProgram(0);
+    gl->unpack_grid_shader = build_compute_shader(UNPACK_GRID_COMPUTE_SHADER);
+    set_grid_size_uniform(gl->unpack_grid_shader, batch);
+    gl->pack_grid_shader = build_compute_shader(PACK_GRID_COMPUTE_SHADER);
+    set_grid_size_uniform(gl->pack_grid_shader, batch);
+
+    // glClearTexImage is GL 4.4, so the empty universes are uploaded.
+    uint8_t *empty_cells = xcalloc((size_t)batch->grid_w * batch->grid_h * batch->universe_count, 1);
+    uint32_t textures[2];
+    glGenTextures(2, textures);
+    for (int i = 0; i < 2; i++) {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, textures[i]);
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_R8, batch->grid_w, batch->grid_h, batch->universe_count);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, batch->grid_w, batch->grid_h, batch->universe_count,
+                        GL_RED, GL_UNSIGNED_BYTE, empty_cells);
+    }
+    free(empty_cells);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    gl->grid_tex_front = textures[0];
+    gl->grid_tex_back = textures[1];
+
+    // Empty universes have settled; they finish on the first step unless
+    // seeded before it.
+    size_t status_size = (size_t)batch->universe_count * sizeof(Gpu_Universe_Status);
+    gl->status_scratch = xcalloc(batch->universe_count, sizeof(Gpu_Universe_Status));
+    glGenBuffers(1, &gl->status_buffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, gl->status_buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, status_size, gl->status_scratch, GL_DYNAMIC_COPY);
+
+    glGenBuffers(1, &gl->packed_buffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, gl->packed_buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, get_packed_universe_size(batch), NULL, GL_STREAM_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    return true;
+}
+
+static void gl_batch_destroy(Batch_Engine *batch) {
+    Gl_Batch *gl = batch->impl;
+    uint32_t textures[2] = { gl->grid_tex_front, gl->grid_tex_back };
+    glDeleteTextures(2, textures);
+    uint32_t buffers[2] = { gl->status_buffer, gl->packed_buffer };
+    glDeleteBuffers(2, buffers);
+    glDeleteProgram(gl->step_shader);
+    glDeleteProgram(gl->resolve_shader);
+    glDeleteProgram(gl->unpack_grid_shader);
+    glDeleteProgram(gl->pack_grid_shader);
+    free(gl->status_scratch);
+    free(gl);
+}
+
+// The layer goes into both textures, so the first generation's "changed
+// since the previous one" compares against the seed itself.
+static void gl_batch_seed_universe(Batch_Engine *batch, int universe, const Bit_Grid *grid) {
+    Gl_Batch *gl = batch->impl;
+
+    int words_per_row_32 = grid->words_per_row * 2;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, gl->packed_buffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, get_packed_universe_size(batch), grid->words);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, gl->packed_buffer);
+    glUseProgram(gl->unpack_grid_shader);
+    glUniform1i(glGetUniformLocation(gl->unpack_grid_shader, "words_per_row"), words_per_row_32);
+    uint32_t textures[2] = { gl->grid_tex_front, gl->grid_tex_back };
+    for (int i = 0; i < 2; i++) {
+        glBindImageTexture(1, textures[i], 0, GL_FALSE, universe, GL_WRITE_ONLY, GL_R8);
+        glDispatchCompute((words_per_row_32 + 15) / 16, (batch->grid_h + 3) / 4, 1);
+    }
+    glUseProgram(0);
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    Gpu_Universe_Status status = {0};
+    status.population = (uint32_t)count_bit_grid_population(grid);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, gl->status_buffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, (size_t)universe * sizeof(status), sizeof(status), &status);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+static void gl_batch_step(Batch_Engine *batch, uint64_t generations) {
+    Gl_Batch *gl = batch->impl;
+
+    int work_groups_x = (batch->grid_w + TILE_SIZE - 1) / TILE_SIZE;
+    int work_groups_y = (batch->grid_h + TILE_SIZE - 1) / TILE_SIZE;
+    int resolve_groups = (batch->universe_count + RESOLVE_GROUP_SIZE - 1) / RESOLVE_GROUP_SIZE;
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, gl->status_buffer);
+    for (uint64_t i = 0; i < generations; i++) {
+        glUseProgram(gl->step_shader);
+        glBindImageTexture(0, gl->grid_tex_front, 0, GL_TRUE, 0, GL_READ_ONLY, GL_R8);
+        glBindImageTexture(1, gl->grid_tex_back, 0, GL_TRUE, 0, GL_READ_WRITE, GL_R8);
+        glDispatchCompute(work_groups_x, work_groups_y, batch->universe_count);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        glUseProgram(gl->resolve_shader);
+        glDispatchCompute(resolve_groups, 1, 1);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+        uint32_t temp = gl->grid_tex_front;
+        gl->grid_tex_front = gl->grid_tex_back;
+        gl->grid_tex_back = temp;
+    }
+    glUseProgram(0);
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+}
+
+static void gl_batch_read_universe(Batch_Engine *batch, int universe, Bit_Grid *grid) {
+    Gl_Batch *gl = batch->impl;
+
+    int words_per_row_32 = (batch->grid_w + 63) / 64 * 2;
+    glBindImageTexture(0, gl->grid_tex_front, 0, GL_FALSE, universe, GL_READ_ONLY, GL_R8);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, gl->packed_buffer);
+    glUseProgram(gl->pack_grid_shader);
+    glUniform1i(glGetUniformLocation(gl->pack_grid_shader, "words_per_row"), words_per_row_32);
+    glDispatchCompute((words_per_row_32 + 15) / 16, (batch->grid_h + 3) / 4, 1);
+    glUseProgram(0);
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, gl->packed_buffer);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, get_packed_universe_size(batch), grid->words);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+static void gl_batch_read_status(Batch_Engine *batch, Universe_Status *status) {
+    Gl_Batch *gl = batch->impl;
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, gl->status_buffer);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (size_t)batch->universe_count * sizeof(Gpu_Universe_Status),
+                       gl->status_scratch);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    for (int u = 0; u < batch->universe_count; u++) {
+        const Gpu_Universe_Status *gpu = &gl->status_scratch[u];
+        status[u] = (Universe_Status){
+            .generation = gpu->generation,
+            .population = gpu->population,
+            .period = gpu->period,
+            .finished = gpu->finished != 0,
+        };
+    }
+}
+
+static size_t gl_batch_memory_usage(Batch_Engine *batch) {
+    return 2 * (size_t)batch->grid_w * batch->grid_h * batch->universe_count
+        + 2 * (size_t)batch->universe_count * sizeof(Gpu_Universe_Status)
+        + get_packed_universe_size(batch);
+}
+
+const Batch_Engine_Api g_gl_batch_engine_api = {
+    .name = "gl",
+    .init = gl_batch_init,
+    .destroy = gl_batch_destroy,
+    .seed_universe = gl_batch_seed_universe,
+    .step = gl_batch_step,
+    .read_universe = gl_batch_read_universe,
+    .read_status = gl_batch_read_status,
+    .memory_usage = gl_batch_memory_usage,
+};
@@ -0,0 +1,629 @@
+// GPU engine: the original compute-shader stepper. Requires a current
+// GL 4.3 context on the calling thread (see main).
+//
+// Unless Engine_Options.dense is set, each generation is two dispatches: a
+// small pass over the 16x16 tiles collects those that may change (the tile or
+// a neighbour changed last generation) into a list whose header is an indirect
+// dispatch command, then glDispatchComputeIndirect steps only those tiles.
+// Skipped tiles hold the same cells in both textures, so they need no copy.
+//
+// Engine_Options.temporal_block_generations = k > 1 steps whole blocks of k
+// generations with game_of_life_temporal.comp.glsl, which keeps each 32x32
+// tile and its halo in shared memory for the whole block. Blocks step every
+// tile; the per-generation changed flags are reset to all-changed after one.
+//
+// A step of many generations is recorded as one batch: dispatches are only
+// separated by the image barrier each generation needs, and the barrier for
+// the renderer and readback comes once at the end. Readback packs the grid to
+// one bit per cell on the GPU; gl_engine_request_readback does that into one
+// of a few fenced staging buffers so the caller never waits on the pipeline.
+//
+// The rule is compiled into the stepping shaders: rule.glsl and the rule's
+// defines go in after #version, so each rule gets its own specialised
+// programs. Larger than Life rules step densely through the summed-area table
+// passes of larger_than_life.comp.glsl, without tile skipping or temporal
+// blocking.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glad/glad.h>
+
+#include "common.h"
+#include "engine.h"
+#include "gl_engine.h"
+#include "gl_util.h"
+#include "profiler.h"
+
+#define GOL_COMPUTE_SHADER "res/shaders/game_of_life.comp.glsl"
+#define GOL_SPARSE_COMPUTE_SHADER "res/shaders/game_of_life_sparse.comp.glsl"
+#define ACTIVE_TILES_COMPUTE_SHADER "res/shaders/active_tiles.comp.glsl"
+#define GOL_TEMPORAL_COMPUTE_SHADER "res/shaders/game_of_life_temporal.comp.glsl"
+#define UNPACK_GRID_COMPUTE_SHADER "res/shaders/unpack_grid.comp.glsl"
+#define PACK_GRID_COMPUTE_SHADER "res/shaders/pack_grid.comp.glsl"
+#define LARGER_THAN_LIFE_COMPUTE_SHADER "res/shaders/larger_than_life.comp.glsl"
+
+enum {
+    TILE_SIZE = 16,
+    // Output tile of the temporal shader; the halo must fit in shared memory.
+    TEMPORAL_TILE_SIZE = 32,
+    MAX_BLOCK_GENERATIONS = 8,
+    ACTIVE_TILES_GROUP_SIZE = 64,
+    // uints before tiles[] in the Active_Tiles buffer.
+    ACTIVE_TILES_HEADER_UINTS = 5,
+    LARGER_THAN_LIFE_PASSES = 3,
+    LARGER_THAN_LIFE_GROUP_SIZE = 64,
+    // Readbacks in flight; requests beyond this are refused, not queued.
+    READBACK_SLOTS = 3
+};
+
+typedef struct {
+    uint32_t buffer;
+    GLsync fence;
+    uint64_t generation;
+} Readback_Slot;
+
+typedef struct {
+    uint32_t gol_compute_shader;
+    uint32_t unpack_grid_shader;
+    uint32_t pack_grid_shader;
+    uint32_t grid_tex_front;
+    uint32_t grid_tex_back;
+
+    bool sparse;
+    int tiles_x;
+    int tiles_y;
+    uint32_t gol_sparse_compute_shader;
+    uint32_t active_tiles_shader;
+    uint32_t changed_tiles_buffer;
+    uint32_t next_changed_tiles_buffer;
+    uint32_t active_tiles_buffer;
+    uint64_t generations_since_seed;
+
+    int block_generations;
+    uint32_t gol_temporal_compute_shader;
+
+    bool larger_than_life;
+    uint32_t larger_than_life_shaders[LARGER_THAN_LIFE_PASSES];
+    uint32_t window_sums_buffer;
+    size_t window_sums_size;
+
+    // Slots [readback_head, readback_head + readback_count) are pending, oldest
+    // first. Buffers are created on the first request.
+    Readback_Slot readbacks[READBACK_SLOTS];
+    int readback_head;
+    int readback_count;
+} Game_Of_Life_State;
+
+static void create_compute_textures(Gol_Engine *engine) {
+    Game_Of_Life_State *gol = engine->impl;
+
+    uint32_t grid_state_texture[2];
+    glGenTextures(2, grid_state_texture);
+    for (int i = 0; i < 2; i++) {
+        glBindTexture(GL_TEXTURE_2D, grid_state_texture[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8,
+                     engine->grid_w, engine->grid_h,
+                     0, GL_RED, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    gol->grid_tex_front = grid_state_texture[0];
+    gol->grid_tex_back = grid_state_texture[1];
+}
+
+static void mark_all_tiles_changed(Game_Of_Life_State *gol) {
+    uint32_t one = 1;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, gol->changed_tiles_buffer);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &one);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+static void seed_gol_texture(Gol_Engine *engine, const Bit_Grid *grid) {
+    Game_Of_Life_State *gol = engine->impl;
+
+    // The packed words go up as-is and a shader expands them, so seeding never
+    // needs a byte-per-cell copy on the host.
+    int words_per_row_32 = grid->words_per_row * 2;
+    begin_gpu_profile_zone("gl_upload");
+    uint32_t packed_buffer;
+    glGenBuffers(1, &packed_buffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, packed_buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, (size_t)grid->words_per_row * grid->h * sizeof(uint64_t),
+                 grid->words, GL_STREAM_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, packed_buffer);
+    glBindImageTexture(1, gol->grid_tex_front, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R8);
+    glUseProgram(gol->unpack_grid_shader);
+    glUniform1i(glGetUniformLocation(gol->unpack_grid_shader, "words_per_row"), words_per_row_32);
+    glDispatchCompute((words_per_row_32 + 15) / 16, (engine->grid_h + 3) / 4, 1);
+    glUseProgram(0);
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+    end_gpu_profile_zone();
+
+    glDeleteBuffers(1, &packed_buffer);
+
+    if (gol->sparse) {
+        // Every tile counts as changed so the first generation steps them all.
+        mark_all_tiles_changed(gol);
+        uint32_t header[ACTIVE_TILES_HEADER_UINTS] = { 0, 1, 1, 0, 0 };
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, gol->active_tiles_buffer);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(header), header);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        gol->generations_since_seed = 0;
+    }
+}
+
+static void run_gol_compute_batch(Gol_Engine *engine, uint64_t generations) {
+    Game_Of_Life_State *gol = engine->impl;
+
+    int work_groups_x = (engine->grid_w + 15) / 16;
+    int work_groups_y = (engine->grid_h + 15) / 16;
+
+    glUseProgram(gol->gol_compute_shader);
+    for (uint64_t i = 0; i < generations; i++) {
+        glBindImageTexture(0, gol->grid_tex_front, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R8);
+        glBindImageTexture(1, gol->grid_tex_back, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R8);
+        glDispatchCompute(work_groups_x, work_groups_y, 1);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+        uint32_t temp = gol->grid_tex_front;
+        gol->grid_tex_front = gol->grid_tex_back;
+        gol->grid_tex_back = temp;
+    }
+    glUseProgram(0);
+}
+
+// One dense generation per iteration, as three passes over the window sums.
+static void run_larger_than_life_batch(Gol_Engine *engine, uint64_t generations) {
+    Game_Of_Life_State *gol = engine->impl;
+    int radius = engine->rule.radius;
+    int padded_w = engine->grid_w + 2 * radius;
+    int padded_h = engine->grid_h + 2 * radius;
+    int group_counts[LARGER_THAN_LIFE_PASSES][2] = {
+        { (padded_h + LARGER_THAN_LIFE_GROUP_SIZE - 1) / LARGER_THAN_LIFE_GROUP_SIZE, 1 },
+        { (padded_w + LARGER_THAN_LIFE_GROUP_SIZE - 1) / LARGER_THAN_LIFE_GROUP_SIZE, 1 },
+        { (engine->grid_w + 15) / 16, (engine->grid_h + 15) / 16 },
+    };
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, gol->window_sums_buffer);
+    for (uint64_t i = 0; i < generations; i++) {
+        glBindImageTexture(0, gol->grid_tex_front, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R8);
+        glBindImageTexture(1, gol->grid_tex_back, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R8);
+        for (int pass = 0; pass < LARGER_THAN_LIFE_PASSES; pass++) {
+            glUseProgram(gol->larger_than_life_shaders[pass]);
+            glDispatchCompute(group_counts[pass][0], group_counts[pass][1], 1);
+            glMemoryBarrier(pass + 1 < LARGER_THAN_LIFE_PASSES
+                            ? GL_SHADER_STORAGE_BARRIER_BIT
+                            : GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+
+        uint32_t temp = gol->grid_tex_front;
+        gol->grid_tex_front = gol->grid_tex_back;
+        gol->grid_tex_back = temp;
+    }
+    glUseProgram(0);
+}
+
+static void create_larger_than_life_passes(Gol_Engine *engine) {
+    Game_Of_Life_State *gol = engine->impl;
+    int radius = engine->rule.radius;
+
+    for (int pass = 0; pass < LARGER_THAN_LIFE_PASSES; pass++) {
+        char defines[32];
+        snprintf(defines, sizeof(defines), "#define PASS %d\n", pass + 1);
+        uint32_t program = build_rule_compute_shader(&engine->rule, LARGER_THAN_LIFE_COMPUTE_SHADER, defines);
+        glUseProgram(program);
+        glUniform2i(glGetUniformLocation(program, "grid_size"), engine->grid_w, engine->grid_h);
+        gol->larger_than_life_shaders[pass] = program;
+    }
+    glUseProgram(0);
+
+    // The zero first row and column are never written, so one clear lasts.
+    gol->window_sums_size = ((size_t)engine->grid_w + 2 * radius + 1) *
+                            ((size_t)engine->grid_h + 2 * radius + 1) * sizeof(uint32_t);
+    uint32_t zero = 0;
+    glGenBuffers(1, &gol->window_sums_buffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, gol->window_sums_buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, gol->window_sums_size, NULL, GL_DYNAMIC_COPY);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+static void run_temporal_gol_compute_procedure(Gol_Engine *engine) {
+    Game_Of_Life_State *gol = engine->impl;
+
+    glBindImageTexture(0, gol->grid_tex_front, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R8);
+    glBindImageTexture(1, gol->grid_tex_back, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R8);
+
+    glUseProgram(gol->gol_temporal_compute_shader);
+
+    int work_groups_x = (engine->grid_w + TEMPORAL_TILE_SIZE - 1) / TEMPORAL_TILE_SIZE;
+    int work_groups_y = (engine->grid_h + TEMPORAL_TILE_SIZE - 1) / TEMPORAL_TILE_SIZE;
+    glDispatchCompute(work_groups_x, work_groups_y, 1);
+
+    glUseProgram(0);
+
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+    uint32_t temp = gol->grid_tex_front;
+    gol->grid_tex_front = gol->grid_tex_back;
+    gol->grid_tex_back = temp;
+
+    if (gol->sparse) {
+        // The flags describe the last single generation, not this block.
+        mark_all_tiles_changed(gol);
+        gol->generations_since_seed += gol->block_generations;
+    }
+}
+
+static void run_sparse_gol_compute_procedure(Gol_Engine *engine) {
+    Game_Of_Life_State *gol = engine->impl;
+
+    uint32_t zero = 0;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, gol->active_tiles_buffer);
+    glClearBufferSubData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, 0, sizeof(uint32_t),
+                         GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, gol->changed_tiles_buffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, gol->next_changed_tiles_buffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, gol->active_tiles_buffer);
+
+    glUseProgram(gol->active_tiles_shader);
+    int tile_count = gol->tiles_x * gol->tiles_y;
+    glDispatchCompute((tile_count + ACTIVE_TILES_GROUP_SIZE - 1) / ACTIVE_TILES_GROUP_SIZE, 1, 1);
+
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+    glBindImageTexture(0, gol->grid_tex_front, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R8);
+    glBindImageTexture(1, gol->grid_tex_back, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R8);
+
+    glUseProgram(gol->gol_sparse_compute_shader);
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, gol->active_tiles_buffer);
+    glDispatchComputeIndirect(0);
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+
+    glUseProgram(0);
+
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT |
+                    GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    uint32_t temp = gol->grid_tex_front;
+    gol->grid_tex_front = gol->grid_tex_back;
+    gol->grid_tex_back = temp;
+
+    temp = gol->changed_tiles_buffer;
+    gol->changed_tiles_buffer = gol->next_changed_tiles_buffer;
+    gol->next_changed_tiles_buffer = temp;
+
+    gol->generations_since_seed++;
+}
+
+static void create_active_tile_buffers(Gol_Engine *engine) {
+    Game_Of_Life_State *gol = engine->impl;
+
+    size_t tile_count = (size_t)gol->tiles_x * gol->tiles_y;
+
+    uint32_t buffers[3];
+    glGenBuffers(3, buffers);
+    gol->changed_tiles_buffer = buffers[0];
+    gol->next_changed_tiles_buffer = buffers[1];
+    gol->active_tiles_buffer = buffers[2];
+
+    for (int i = 0; i < 2; i++) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[i]);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, tile_count * sizeof(uint32_t), NULL, GL_DYNAMIC_COPY);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, gol->active_tiles_buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, (ACTIVE_TILES_HEADER_UINTS + tile_count) * sizeof(uint32_t),
+                 NULL, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    gol->gol_sparse_compute_shader = build_rule_compute_shader(&engine->rule, GOL_SPARSE_COMPUTE_SHADER, "");
+    gol->active_tiles_shader = build_compute_shader(ACTIVE_TILES_COMPUTE_SHADER);
+
+    glUseProgram(gol->gol_sparse_compute_shader);
+    glUniform2i(glGetUniformLocation(gol->gol_sparse_compute_shader, "grid_size"),
+                engine->grid_w, engine->grid_h);
+    glUniform2i(glGetUniformLocation(gol->gol_sparse_compute_shader, "tile_count"),
+                gol->tiles_x, gol->tiles_y);
+    glUseProgram(gol->active_tiles_shader);
+    glUniform2i(glGetUniformLocation(gol->active_tiles_shader, "tile_count"),
+                gol->tiles_x, gol->tiles_y);
+    glUseProgram(0);
+}
+
+static bool gl_engine_supports_rule(const Rule *rule) {
+    (void)rule;
+    return true;
+}
+
+static bool gl_engine_init(Gol_Engine *engine) {
+    // glad leaves every entry point NULL until a context has been loaded.
+    if (!glDispatchCompute) {
+        trace_log("The GL engine needs a current OpenGL 4.3 context");
+        return false;
+    }
+
+    const Rule *rule = &engine->rule;
+    bool larger_than_life = rule->family == RULE_FAMILY_LARGER_THAN_LIFE;
+    if (larger_than_life &&
+        (engine->grid_w < 2 * rule->radius + 1 || engine->grid_h < 2 * rule->radius + 1)) {
+        trace_log("Rule %s needs a grid of at least %dx%d", rule->name, 2 * rule->radius + 1, 2 * rule->radius + 1);
+        return false;
+    }
+
+    Game_Of_Life_State *gol = xcalloc(1, sizeof(Game_Of_Life_State));
+    engine->impl = gol;
+    gol->larger_than_life = larger_than_life;
+
+    gol->gol_compute_shader = build_rule_compute_shader(&engine->rule, GOL_COMPUTE_SHADER, "");
+
+    glUseProgram(gol->gol_compute_shader);
+    glUniform2i(glGetUniformLocation(gol->gol_compute_shader, "grid_size"),
+                engine->grid_w, engine->grid_h);
+    glUseProgram(0);
+
+    gol->unpack_grid_shader = build_compute_shader(UNPACK_GRID_COMPUTE_SHADER);
+    glUseProgram(gol->unpack_grid_shader);
+    glUniform2i(glGetUniformLocation(gol->unpack_grid_shader, "grid_size"),
+                engine->grid_w, engine->grid_h);
+    glUseProgram(0);
+
+    gol->pack_grid_shader = build_compute_shader(PACK_GRID_COMPUTE_SHADER);
+    glUseProgram(gol->pack_grid_shader);
+    glUniform2i(glGetUniformLocation(gol->pack_grid_shader, "grid_size"),
+                engine->grid_w, engine->grid_h);
+    glUseProgram(0);
+
+    create_compute_textures(engine);
+
+    gol->tiles_x = (engine->grid_w + TILE_SIZE - 1) / TILE_SIZE;
+    gol->tiles_y = (engine->grid_h + TILE_SIZE - 1) / TILE_SIZE;
+    gol->sparse = !engine->options.dense && !larger_than_life;
+    if (gol->sparse) {
+        create_active_tile_buffers(engine);
+    }
+    if (larger_than_life) {
+        create_larger_than_life_passes(engine);
+    }
+
+    gol->block_generations = engine->options.temporal_block_generations > 1
+        ? engine->options.temporal_block_generations : 1;
+    if (gol->block_generations > 1 && larger_than_life) {
+        trace_log("GL temporal blocking doesn't apply to Larger than Life rules");
+        gol->block_generations = 1;
+    }
+    if (gol->block_generations > MAX_BLOCK_GENERATIONS) {
+        trace_log("GL temporal blocking is limited to %d generations per pass", MAX_BLOCK_GENERATIONS);
+        gol->block_generations = MAX_BLOCK_GENERATIONS;
+    }
+    if (gol->block_generations > 1) {
+        char defines[64];
+        snprintf(defines, sizeof(defines), "#define BLOCK_GENERATIONS %d\n", gol->block_generations);
+        gol->gol_temporal_compute_shader = build_rule_compute_shader(&engine->rule, GOL_TEMPORAL_COMPUTE_SHADER, defines);
+
+        glUseProgram(gol->gol_temporal_compute_shader);
+        glUniform2i(glGetUniformLocation(gol->gol_temporal_compute_shader, "grid_size"),
+                    engine->grid_w, engine->grid_h);
+        glUseProgram(0);
+    }
+
+    return true;
+}
+
+static void gl_engine_destroy(Gol_Engine *engine) {
+    Game_Of_Life_State *gol = engine->impl;
+    uint32_t textures[2] = { gol->grid_tex_front, gol->grid_tex_back };
+    glDeleteTextures(2, textures);
+    glDeleteProgram(gol->gol_compute_shader);
+    glDeleteProgram(gol->unpack_grid_shader);
+    glDeleteProgram(gol->pack_grid_shader);
+    for (int i = 0; i < READBACK_SLOTS; i++) {
+        if (gol->readbacks[i].fence) {
+            glDeleteSync(gol->readbacks[i].fence);
+        }
+        if (gol->readbacks[i].buffer) {
+            glDeleteBuffers(1, &gol->readbacks[i].buffer);
+        }
+    }
+    if (gol->block_generations > 1) {
+        glDeleteProgram(gol->gol_temporal_compute_shader);
+    }
+    if (gol->larger_than_life) {
+        for (int pass = 0; pass < LARGER_THAN_LIFE_PASSES; pass++) {
+            glDeleteProgram(gol->larger_than_life_shaders[pass]);
+        }
+        glDeleteBuffers(1, &gol->window_sums_buffer);
+    }
+    if (gol->sparse) {
+        uint32_t buffers[3] = { gol->changed_tiles_buffer, gol->next_changed_tiles_buffer, gol->active_tiles_buffer };
+        glDeleteBuffers(3, buffers);
+        glDeleteProgram(gol->gol_sparse_compute_shader);
+        glDeleteProgram(gol->active_tiles_shader);
+    }
+    free(gol);
+}
+
+static void gl_engine_step(Gol_Engine *engine, uint64_t generations) {
+    Game_Of_Life_State *gol = engine->impl;
+    begin_gpu_profile_zone("gl_compute");
+    uint64_t block = (uint64_t)gol->block_generations;
+    if (block > 1) {
+        for (uint64_t i = 0; i < generations / block; i++) {
+            run_temporal_gol_compute_procedure(engine);
+        }
+        generations %= block;
+    }
+    if (gol->larger_than_life) {
+        run_larger_than_life_batch(engine, generations);
+    } else if (gol->sparse) {
+        for (uint64_t i = 0; i < generations; i++) {
+            run_sparse_gol_compute_procedure(engine);
+        }
+    } else {
+        run_gol_compute_batch(engine, generations);
+    }
+
+    end_gpu_profile_zone();
+
+    // One barrier for everything that consumes the result outside the
+    // compute passes: the renderer's sampler and texture readback.
+    begin_gpu_profile_zone("gl_barrier");
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+    end_gpu_profile_zone();
+}
+
+// Reads the list header back, so this waits for the GPU to finish.
+static void gl_engine_get_stats(Gol_Engine *engine, Engine_Stats *stats) {
+    Game_Of_Life_State *gol = engine->impl;
+    memset(stats, 0, sizeof(*stats));
+    stats->total_tiles = (uint64_t)gol->tiles_x * gol->tiles_y;
+    if (!gol->sparse) {
+        return;
+    }
+
+    uint32_t header[ACTIVE_TILES_HEADER_UINTS];
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, gol->active_tiles_buffer);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(header), header);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    stats->active_tiles = gol->generations_since_seed > 0 ? header[0] : 0;
+    stats->active_tile_steps = (uint64_t)header[3] | ((uint64_t)header[4] << 32);
+    stats->generations = gol->generations_since_seed;
+}
+
+static size_t get_packed_grid_size(const Gol_Engine *engine) {
+    return (size_t)((engine->grid_w + 63) / 64) * engine->grid_h * sizeof(uint64_t);
+}
+
+// Bit_Grid rows are whole 64-bit words, i.e. an even number of shader words.
+static void pack_front_texture(Gol_Engine *engine, uint32_t buffer) {
+    Game_Of_Life_State *gol = engine->impl;
+
+    int words_per_row_32 = (engine->grid_w + 63) / 64 * 2;
+    begin_gpu_profile_zone("gl_pack");
+    glBindImageTexture(0, gol->grid_tex_front, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R8);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, buffer);
+    glUseProgram(gol->pack_grid_shader);
+    glUniform1i(glGetUniformLocation(gol->pack_grid_shader, "words_per_row"), words_per_row_32);
+    glDispatchCompute((words_per_row_32 + 15) / 16, (engine->grid_h + 3) / 4, 1);
+    glUseProgram(0);
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    end_gpu_profile_zone();
+}
+
+static void gl_engine_read_grid(Gol_Engine *engine, Bit_Grid *grid) {
+    size_t size = get_packed_grid_size(engine);
+
+    uint32_t buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, size, NULL, GL_STREAM_READ);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    pack_front_texture(engine, buffer);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, grid->words);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    glDeleteBuffers(1, &buffer);
+}
+
+bool gl_engine_request_readback(Gol_Engine *engine) {
+    Game_Of_Life_State *gol = engine->impl;
+    if (gol->readback_count == READBACK_SLOTS) {
+        return false;
+    }
+
+    Readback_Slot *slot = &gol->readbacks[(gol->readback_head + gol->readback_count) % READBACK_SLOTS];
+    if (!slot->buffer) {
+        glGenBuffers(1, &slot->buffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, slot->buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, get_packed_grid_size(engine), NULL, GL_STREAM_READ);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    pack_front_texture(engine, slot->buffer);
+    slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot->generation = engine->generation;
+    gol->readback_count++;
+
+    // Make sure the fence reaches the GPU even if nothing else flushes.
+    glFlush();
+    return true;
+}
+
+bool gl_engine_poll_readback(Gol_Engine *engine, Bit_Grid *grid, uint64_t *generation) {
+    Game_Of_Life_State *gol = engine->impl;
+    if (gol->readback_count == 0) {
+        return false;
+    }
+
+    Readback_Slot *slot = &gol->readbacks[gol->readback_head];
+    GLenum status = glClientWaitSync(slot->fence, 0, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+        return false;
+    }
+    glDeleteSync(slot->fence);
+    slot->fence = NULL;
+
+    size_t size = get_packed_grid_size(engine);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, slot->buffer);
+    const void *words = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, size, GL_MAP_READ_BIT);
+    if (words) {
+        memcpy(grid->words, words, size);
+        glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    *generation = slot->generation;
+    gol->readback_head = (gol->readback_head + 1) % READBACK_SLOTS;
+    gol->readback_count--;
+    return words != NULL;
+}
+
+// Device memory is estimated from the allocation sizes; drivers may pad.
+static size_t gl_engine_memory_usage(Gol_Engine *engine) {
+    Game_Of_Life_State *gol = engine->impl;
+    size_t bytes = sizeof(Game_Of_Life_State) + 2 * (size_t)engine->grid_w * engine->grid_h;
+    for (int i = 0; i < READBACK_SLOTS; i++) {
+        bytes += gol->readbacks[i].buffer ? get_packed_grid_size(engine) : 0;
+    }
+    if (gol->sparse) {
+        size_t tile_count = (size_t)gol->tiles_x * gol->tiles_y;
+        bytes += (3 * tile_count + ACTIVE_TILES_HEADER_UINTS) * sizeof(uint32_t);
+    }
+    bytes += gol->window_sums_size;
+    return bytes;
+}
+
+static void gl_engine_finish(Gol_Engine *engine) {
+    (void)engine;
+    glFinish();
+}
+
+uint32_t gl_engine_front_texture(Gol_Engine *engine) {
+    Game_Of_Life_State *gol = engine->impl;
+    return gol->grid_tex_front;
+}
+
+const Gol_Engine_Api g_gl_engine_api = {
+    .name = "gl",
+    .supports_rule = gl_engine_supports_rule,
+    .init = gl_engine_init,
+    .destroy = gl_engine_destroy,
+    .seed = seed_gol_texture,
+    .step = gl_engine_step,
+    .read_grid = gl_engine_read_grid,
+    .get_stats = gl_engine_get_stats,
+    .memory_usage = gl_engine_memory_usage,
+    .finish = gl_engine_finish,
+};
@@ -0,0 +1,21 @@
+#ifndef GL_ENGINE_H
+#define GL_ENGINE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bit_grid.h"
+#include "engine.h"
+
+// Texture holding the current generation, for the renderer to sample.
+uint32_t gl_engine_front_texture(Gol_Engine *engine);
+
+// Asynchronous readback. A request packs the current generation into a
+// staging buffer behind a fence and returns at once; false means every slot
+// is still in flight. Polling never waits: it returns false until the oldest
+// request has landed, then copies it into grid (engine-sized) and reports the
+// generation it was taken at.
+bool gl_engine_request_readback(Gol_Engine *engine);
+bool gl_engine_poll_readback(Gol_Engine *engine, Bit_Grid *grid, uint64_t *generation);
+
+#endif
@@ -0,0 +1,189 @@
+#include "gl_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <GLFW/glfw3.h>
+
+#include "common.h"
+
+#define RULE_SHADER_PRELUDE "res/shaders/rule.glsl"
+
+enum {
+    ONE_MB = 1024 * 1024
+};
+
+static char g_error_msg_buffer[ONE_MB];
+
+char *read_shader_file(const char *file_path) {
+    FILE *file = fopen(file_path, "r");
+    if (!file) {
+        exit_with_error("Failed to open shader file");
+    }
+
+    fseek(file, 0, SEEK_END);
+    size_t file_size = ftell(file);
+    rewind(file);
+
+    char *shader_src = xmalloc(file_size + 1);
+    fread(shader_src, file_size, 1, file);
+    fclose(file);
+    shader_src[file_size] = '\0';
+
+    return shader_src;
+}
+
+static uint32_t compile_shader(const char *shader_src, GLenum shader_type) {
+    uint32_t shader_id = glCreateShader(shader_type);
+    glShaderSource(shader_id, 1, &shader_src, NULL);
+    glCompileShader(shader_id);
+
+    int success;
+    glGetShaderiv(shader_id, GL_COMPILE_STATUS, &success);
+
+    if (!success) {
+        glGetShaderInfoLog(shader_id, ONE_MB, NULL, g_error_msg_buffer);
+        exit_with_error("Failed to compile shader (type 0x%04X). Error:\n  %s\nSource:\n%s\n",
+                        shader_type, g_error_msg_buffer, shader_src);
+    }
+
+    return shader_id;
+}
+
+uint32_t build_shader_from_file(const char *file_path, GLenum shader_type) {
+    char *shader_src = read_shader_file(file_path);
+    uint32_t shader_id = compile_shader(shader_src, shader_type);
+    free(shader_src);
+    return shader_id;
+}
+
+uint32_t link_vert_frag_shaders(uint32_t vert, uint32_t frag) {
+    uint32_t program_id = glCreateProgram();
+    glAttachShader(program_id, vert);
+    glAttachShader(program_id, frag);
+    glLinkProgram(program_id);
+
+    int success;
+    glGetProgramiv(program_id, GL_LINK_STATUS, &success);
+
+    if (!success) {
+        glGetProgramInfoLog(program_id, ONE_MB, NULL, g_error_msg_buffer);
+        exit_with_error("Failed to link vert-frag shader program. Error:\n  %s", g_error_msg_buffer);
+    }
+
+    return program_id;
+}
+
+uint32_t link_comp_shader(uint32_t comp) {
+    uint32_t program_id = glCreateProgram();
+    glAttachShader(program_id, comp);
+    glLinkProgram(program_id);
+
+    int success;
+    glGetProgramiv(program_id, GL_LINK_STATUS, &success);
+
+    if (!success) {
+        glGetProgramInfoLog(program_id, ONE_MB, NULL, g_error_msg_buffer);
+        exit_with_error("Failed to link comp shader program. Error:\n  %s", g_error_msg_buffer);
+    }
+
+    return program_id;
+}
+
+uint32_t build_shaders(const char *vert_file, const char *frag_file) {
+    uint32_t vert_shader = build_shader_from_file(vert_file, GL_VERTEX_SHADER);
+    uint32_t frag_shader = build_shader_from_file(frag_file, GL_FRAGMENT_SHADER);
+    uint32_t shader_program = link_vert_frag_shaders(vert_shader, frag_shader);
+    glDeleteShader(vert_shader);
+    glDeleteShader(frag_shader);
+    return shader_program;
+}
+
+uint32_t build_compute_shader(const char *file_path) {
+    uint32_t comp_shader = build_shader_from_file(file_path, GL_COMPUTE_SHADER);
+    uint32_t program = link_comp_shader(comp_shader);
+    glDeleteShader(comp_shader);
+    return program;
+}
+
+uint32_t build_compute_shader_with_defines(const char *file_path, const char *defines) {
+    char *file_src = read_shader_file(file_path);
+
+    // #version has to stay the first line, so the defines go right after it.
+    char *after_version = strchr(file_src, '\n');
+    size_t version_len = after_version ? (size_t)(after_version - file_src) + 1 : strlen(file_src);
+    size_t defines_len = strlen(defines);
+    char *shader_src = xmalloc(strlen(file_src) + defines_len + 2);
+    memcpy(shader_src, file_src, version_len);
+    shader_src[version_len] = '\0';
+    if (!after_version) {
+        strcat(shader_src, "\n");
+    }
+    strcat(shader_src, defines);
+    strcat(shader_src, file_src + version_len);
+    free(file_src);
+
+    uint32_t comp_shader = compile_shader(shader_src, GL_COMPUTE_SHADER);
+    free(shader_src);
+    uint32_t program = link_comp_shader(comp_shader);
+    glDeleteShader(comp_shader);
+    return program;
+}
+
+uint32_t build_rule_compute_shader(const Rule *rule, const char *file_path, const char *extra_defines) {
+    char defines[512];
+    if (rule->family == RULE_FAMILY_LARGER_THAN_LIFE) {
+        snprintf(defines, sizeof(defines),
+                 "%s#define STATES %d\n#define RADIUS %d\n#define INCLUDE_CENTER %d\n"
+                 "#define BIRTH_MIN %d\n#define BIRTH_MAX %d\n#define SURVIVAL_MIN %d\n#define SURVIVAL_MAX %d\n",
+                 extra_defines, rule->states, rule->radius, rule->include_center ? 1 : 0,
+                 rule->birth_min, rule->birth_max, rule->survival_min, rule->survival_max);
+    } else {
+        snprintf(defines, sizeof(defines), "%s#define STATES %d\n#define BIRTH_MASK %uu\n#define SURVIVAL_MASK %uu\n",
+                 extra_defines, rule->states, rule->birth, rule->survival);
+    }
+
+    char *prelude = read_shader_file(RULE_SHADER_PRELUDE);
+    char *header = xmalloc(strlen(defines) + strlen(prelude) + 1);
+    strcpy(header, defines);
+    strcat(header, prelude);
+    uint32_t program = build_compute_shader_with_defines(file_path, header);
+    free(header);
+    free(prelude);
+    return program;
+}
+
+bool init_offscreen_gl_context() {
+    if (glfwGetCurrentContext()) {
+        return true;
+    }
+    if (!glfwInit()) {
+        return false;
+    }
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow *window = glfwCreateWindow(1, 1, "offscreen", NULL, NULL);
+    if (!window) {
+        glfwTerminate();
+        return false;
+    }
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        return false;
+    }
+    trace_log("GL: %s (%s)", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+    return true;
+}
+
+void destroy_offscreen_gl_context() {
+    if (glfwGetCurrentContext()) {
+        glfwDestroyWindow(glfwGetCurrentContext());
+        glfwTerminate();
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef GL_UTIL_H
+#define GL_UTIL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <glad/glad.h>
+
+#include "rule.h"
+
+// Returns the file's contents, NUL-terminated, for the caller to free.
+char *read_shader_file(const char *file_path);
+uint32_t build_shader_from_file(const char *file_path, GLenum shader_type);
+uint32_t link_vert_frag_shaders(uint32_t vert, uint32_t frag);
+uint32_t link_comp_shader(uint32_t comp);
+uint32_t build_shaders(const char *vert_file, const char *frag_file);
+uint32_t build_compute_shader(const char *file_path);
+// Compiles a compute shader with `defines` (e.g. "#define K 4\n") inserted
+// after its #version line.
+uint32_t build_compute_shader_with_defines(const char *file_path, const char *defines);
+// Compiles a stepping shader for rule: res/shaders/rule.glsl and the rule's
+// defines go in after #version, with extra_defines (may be empty) ahead of
+// them.
+uint32_t build_rule_compute_shader(const Rule *rule, const char *file_path, const char *extra_defines);
+
+// Makes a hidden 1x1 window's GL 4.3 context current, for tools that run GL
+// engines without a window. Returns true at once if a context is current.
+bool init_offscreen_gl_context();
+void destroy_offscreen_gl_context();
+
+#endif
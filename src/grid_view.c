@@ -0,0 +1,201 @@
+#include "grid_view.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glad/glad.h>
+
+#include "common.h"
+#include "gl_util.h"
+#include "profiler.h"
+
+#define GRID_VIEW_VERT_SHADER "res/shaders/canvas.vert.glsl"
+#define GRID_VIEW_FRAG_SHADER "res/shaders/grid.frag.glsl"
+
+// The closest zoom: this many pixels per cell.
+enum { MAX_PIXELS_PER_CELL = 64 };
+
+static void allocate_grid_view_texture(Grid_View *view) {
+    // Blocks are at least a pixel wide, so a row of the window spans at most
+    // window_w + 2 texels counting the partial ones at each end.
+    int w = view->window_w + 2;
+    int h = view->window_h + 2;
+    if (w <= view->texture_w && h <= view->texture_h) {
+        return;
+    }
+    free(view->texels);
+    view->texture_w = w;
+    view->texture_h = h;
+    view->texels = xmalloc((size_t)w * h);
+    glBindTexture(GL_TEXTURE_2D, view->texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, w, h, 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    view->filled = false;
+}
+
+Grid_View create_grid_view(int grid_w, int grid_h, int top_level, int window_w, int window_h) {
+    Grid_View view = {0};
+    view.grid_w = grid_w;
+    view.grid_h = grid_h;
+    view.top_level = top_level;
+    view.window_w = window_w > 0 ? window_w : 1;
+    view.window_h = window_h > 0 ? window_h : 1;
+    view.shader = build_shaders(GRID_VIEW_VERT_SHADER, GRID_VIEW_FRAG_SHADER);
+    // The quad comes from gl_VertexID, but the core profile still wants a
+    // vertex array bound to draw.
+    glGenVertexArrays(1, &view.vao);
+
+    glGenTextures(1, &view.texture);
+    glBindTexture(GL_TEXTURE_2D, view.texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    allocate_grid_view_texture(&view);
+
+    fit_grid_view(&view);
+    return view;
+}
+
+void destroy_grid_view(Grid_View *view) {
+    glDeleteProgram(view->shader);
+    glDeleteVertexArrays(1, &view->vao);
+    glDeleteTextures(1, &view->texture);
+    free(view->texels);
+    memset(view, 0, sizeof(*view));
+}
+
+// Keeps the grid's centre in the window, so it can't be lost off screen.
+static void clamp_grid_view(Grid_View *view) {
+    double min_cells_per_pixel = 1.0 / MAX_PIXELS_PER_CELL;
+    double max_cells_per_pixel = ldexp(1.0, view->top_level);
+    if (view->cells_per_pixel < min_cells_per_pixel) {
+        view->cells_per_pixel = min_cells_per_pixel;
+    } else if (view->cells_per_pixel > max_cells_per_pixel) {
+        view->cells_per_pixel = max_cells_per_pixel;
+    }
+
+    double center_x = view->grid_w / 2.0;
+    double center_y = view->grid_h / 2.0;
+    double span_x = view->window_w * view->cells_per_pixel;
+    double span_y = view->window_h * view->cells_per_pixel;
+    view->origin_x = fmin(fmax(view->origin_x, center_x - span_x), center_x);
+    view->origin_y = fmin(fmax(view->origin_y, center_y - span_y), center_y);
+}
+
+void resize_grid_view(Grid_View *view, int window_w, int window_h) {
+    if (window_w <= 0 || window_h <= 0) {
+        return;
+    }
+    view->window_w = window_w;
+    view->window_h = window_h;
+    allocate_grid_view_texture(view);
+    clamp_grid_view(view);
+}
+
+void fit_grid_view(Grid_View *view) {
+    double fit_x = (double)view->grid_w / view->window_w;
+    double fit_y = (double)view->grid_h / view->window_h;
+    view->cells_per_pixel = fit_x > fit_y ? fit_x : fit_y;
+    view->origin_x = (view->grid_w - view->window_w * view->cells_per_pixel) / 2.0;
+    view->origin_y = (view->grid_h - view->window_h * view->cells_per_pixel) / 2.0;
+    clamp_grid_view(view);
+}
+
+void zoom_grid_view(Grid_View *view, double factor, double x, double y) {
+    double cell_x = view->origin_x + x * view->cells_per_pixel;
+    double cell_y = view->origin_y + y * view->cells_per_pixel;
+    view->cells_per_pixel /= factor;
+    clamp_grid_view(view);
+    view->origin_x = cell_x - x * view->cells_per_pixel;
+    view->origin_y = cell_y - y * view->cells_per_pixel;
+    clamp_grid_view(view);
+}
+
+void pan_grid_view(Grid_View *view, double dx, double dy) {
+    view->origin_x -= dx * view->cells_per_pixel;
+    view->origin_y -= dy * view->cells_per_pixel;
+    clamp_grid_view(view);
+}
+
+int get_grid_view_level(const Grid_View *view) {
+    int level = 0;
+    while (level < view->top_level && ldexp(1.0, level) < view->cells_per_pixel) {
+        level++;
+    }
+    return level;
+}
+
+// The texels of level covering the window.
+static void get_visible_texels(const Grid_View *view, int level, int *x, int *y, int *w, int *h) {
+    double block = ldexp(1.0, level);
+    double x0 = floor(view->origin_x / block);
+    double y0 = floor(view->origin_y / block);
+    double x1 = floor((view->origin_x + view->window_w * view->cells_per_pixel) / block);
+    double y1 = floor((view->origin_y + view->window_h * view->cells_per_pixel) / block);
+    *x = (int)x0;
+    *y = (int)y0;
+    *w = (int)(x1 - x0) + 1;
+    *h = (int)(y1 - y0) + 1;
+    if (*w > view->texture_w) {
+        *w = view->texture_w;
+    }
+    if (*h > view->texture_h) {
+        *h = view->texture_h;
+    }
+}
+
+static void fill_grid_view(Grid_View *view, const Density_Pyramid *pyramid, const Bit_Grid *grid, int level) {
+    int x, y, w, h;
+    get_visible_texels(view, level, &x, &y, &w, &h);
+    if (view->filled && view->filled_level == level && view->filled_version == pyramid->version &&
+        view->filled_x == x && view->filled_y == y && view->filled_w == w && view->filled_h == h) {
+        return;
+    }
+
+    Profile_Zone zone = begin_profile_zone("view_fill");
+    fill_density_texels(pyramid, grid, level, x, y, w, h, view->texels);
+    glBindTexture(GL_TEXTURE_2D, view->texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w, h, GL_RED, GL_UNSIGNED_BYTE, view->texels);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    end_profile_zone(zone);
+
+    view->filled = true;
+    view->filled_level = level;
+    view->filled_version = pyramid->version;
+    view->filled_x = x;
+    view->filled_y = y;
+    view->filled_w = w;
+    view->filled_h = h;
+}
+
+void draw_grid_view(Grid_View *view, const Density_Pyramid *pyramid, const Bit_Grid *grid, uint32_t state_texture) {
+    int level = get_grid_view_level(view);
+    bool sample_state = level == 0 && state_texture != 0;
+    if (!sample_state) {
+        fill_grid_view(view, pyramid, grid, level);
+    }
+    int texel_x = sample_state ? 0 : view->filled_x;
+    int texel_y = sample_state ? 0 : view->filled_y;
+
+    // Everything the shader sees is relative to the texture's first texel, so
+    // it stays precise however far into a huge grid the view is.
+    double block = ldexp(1.0, level);
+    uint32_t shader = view->shader;
+    glUseProgram(shader);
+    glUniform2f(glGetUniformLocation(shader, "window_size"), (float)view->window_w, (float)view->window_h);
+    glUniform1i(glGetUniformLocation(shader, "level"), level);
+    glUniform2f(glGetUniformLocation(shader, "texel_origin"),
+                (float)(view->origin_x / block - texel_x), (float)(view->origin_y / block - texel_y));
+    glUniform1f(glGetUniformLocation(shader, "texels_per_pixel"), (float)(view->cells_per_pixel / block));
+    glUniform4f(glGetUniformLocation(shader, "grid_rect"), (float)-texel_x, (float)-texel_y,
+                (float)(view->grid_w / block - texel_x), (float)(view->grid_h / block - texel_y));
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, sample_state ? state_texture : view->texture);
+    glBindVertexArray(view->vao);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glUseProgram(0);
+}
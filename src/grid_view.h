@@ -0,0 +1,64 @@
+#ifndef GRID_VIEW_H
+#define GRID_VIEW_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bit_grid.h"
+#include "density_pyramid.h"
+
+// Pan and zoom over a grid of any size. The view is the cell at the window's
+// top-left corner and a zoom in cells per pixel. It draws the density
+// pyramid level whose blocks are the smallest at least a pixel wide, and
+// only the texels on screen are filled, uploaded and sampled, so a frame
+// costs the same whatever the size of the grid.
+
+typedef struct {
+    uint32_t shader;
+    uint32_t vao;
+    // The visible texels of the current level, filled on the CPU.
+    uint32_t texture;
+    uint8_t *texels;
+    int texture_w;
+    int texture_h;
+
+    int grid_w;
+    int grid_h;
+    int top_level;
+    int window_w;
+    int window_h;
+    double origin_x;
+    double origin_y;
+    double cells_per_pixel;
+
+    // What the texture holds: a rectangle of texels of filled_level, taken
+    // from pyramid version filled_version.
+    bool filled;
+    int filled_level;
+    int filled_x;
+    int filled_y;
+    int filled_w;
+    int filled_h;
+    uint64_t filled_version;
+} Grid_View;
+
+// Starts fitted to the window. top_level is the density pyramid's.
+Grid_View create_grid_view(int grid_w, int grid_h, int top_level, int window_w, int window_h);
+void destroy_grid_view(Grid_View *view);
+void resize_grid_view(Grid_View *view, int window_w, int window_h);
+// Centres the whole grid in the window.
+void fit_grid_view(Grid_View *view);
+// factor > 1 zooms in, keeping the cell under window pixel (x, y) in place.
+void zoom_grid_view(Grid_View *view, double factor, double x, double y);
+// Moves the grid by (dx, dy) window pixels.
+void pan_grid_view(Grid_View *view, double dx, double dy);
+int get_grid_view_level(const Grid_View *view);
+
+// Draws the grid over the whole window, refilling the texture first if the
+// view moved or the pyramid changed. grid is the one the pyramid was last
+// updated from. At level 0 a nonzero state_texture (the GL engine's, one R8
+// texel per cell) is sampled directly instead, so the GPU engine's view is
+// live every frame and shows dying states.
+void draw_grid_view(Grid_View *view, const Density_Pyramid *pyramid, const Bit_Grid *grid, uint32_t state_texture);
+
+#endif
@@ -0,0 +1,758 @@
+// HashLife engine: the universe is a hash-consed quadtree, and the result of
+// advancing any node is memoised, so repeated structure in space and time is
+// computed once. Jumps of 2^j generations cost roughly the same as one, which
+// makes generation 10^9 of a structured pattern reachable.
+//
+// Topology:
+//   - Toroidal (default): the grid must be square with a power-of-two side
+//     2^k. The torus is the periodic tiling of the root, so a node made of
+//     4^m copies of the root is advanced and a root-sized window cut back out.
+//   - Unbounded (Engine_Options.unbounded): the grid is a window at (0, 0)
+//     into an infinite plane of dead cells. It matches the torus stepper for
+//     as long as the pattern stays clear of the window edges.
+//
+// Memory is budgeted by Engine_Options.memory_limit_mb. When the node store
+// fills up, unreachable nodes are garbage collected; every node a step frame
+// is still working with is on an explicit root stack, so collection can run
+// mid-step. Memoised results live in a separate direct-mapped cache, where a
+// colliding insert simply evicts the previous entry. The cache roots nothing,
+// so whatever survives a collection is live state; if that alone nearly fills
+// the budget, the store (and its hash buckets) grows past it rather than fail,
+// which makes the limit a soft one. Node ids are 32-bit, so growth stops at
+// MAX_NODE_COUNT.
+//
+// Incremental readback keeps the root it last read alive and walks it
+// alongside the current one: identical nodes are identical ids, so only the
+// subtrees that differ are rewritten.
+//
+// Any Life-like rule without B0 works; B0 would make empty nodes non-empty
+// after a step, which the empty-node shortcut relies on.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "bit_grid.h"
+#include "common.h"
+#include "engine.h"
+
+enum {
+    DEFAULT_MEMORY_LIMIT_MB = 512,
+    MAX_LEVEL = 63,
+    // A node store this full after a collection is grown past the cap rather
+    // than thrashing.
+    MIN_FREE_PERCENT_AFTER_GC = 10
+};
+
+typedef uint32_t Node_Id;
+
+#define NIL_NODE ((Node_Id)0xFFFFFFFFu)
+// Ids stop short of NIL_NODE, however far the store grows.
+#define MAX_NODE_COUNT 0xFFFFFFF0u
+#define FREE_LEVEL 0xFF
+
+typedef struct {
+    Node_Id nw, ne, sw, se;
+    Node_Id next;
+    uint8_t level;
+    uint8_t marked;
+    uint64_t population;
+} Hl_Node;
+
+typedef struct {
+    Node_Id node;
+    uint32_t step_log2;
+    Node_Id result;
+} Hl_Result;
+
+typedef struct {
+    Hl_Node *nodes;
+    uint32_t node_count;
+    uint32_t node_capacity;
+    uint32_t max_nodes;
+    Node_Id free_list;
+    uint32_t free_count;
+
+    Node_Id *buckets;
+    uint32_t bucket_mask;
+
+    Hl_Result *results;
+    uint32_t result_mask;
+
+    Node_Id *roots;
+    int root_count;
+    int root_capacity;
+
+    Node_Id empty[MAX_LEVEL + 1];
+
+    Node_Id root;
+    // The root as of the last read_grid_changes, or NIL_NODE.
+    Node_Id read_root;
+    uint16_t birth;
+    uint16_t survival;
+    bool unbounded;
+    bool warned_over_limit;
+    uint64_t gc_count;
+} Hashlife_Engine;
+
+static inline Hl_Node *get_node(Hashlife_Engine *hl, Node_Id id) {
+    return &hl->nodes[id];
+}
+
+static inline uint32_t hash_children(Node_Id nw, Node_Id ne, Node_Id sw, Node_Id se) {
+    uint64_t h = (uint64_t)nw * 0x9E3779B97F4A7C15ull;
+    h = (h ^ ne) * 0xC2B2AE3D27D4EB4Full;
+    h = (h ^ sw) * 0x165667B19E3779F9ull;
+    h = (h ^ se) * 0x27D4EB2F165667C5ull;
+    return (uint32_t)(h >> 32);
+}
+
+static inline uint32_t hash_result_key(Node_Id node, uint32_t step_log2) {
+    uint64_t h = ((uint64_t)node << 8 | step_log2) * 0x9E3779B97F4A7C15ull;
+    return (uint32_t)(h >> 32);
+}
+
+static void push_root(Hashlife_Engine *hl, Node_Id id) {
+    if (hl->root_count == hl->root_capacity) {
+        hl->root_capacity = hl->root_capacity ? hl->root_capacity * 2 : 256;
+        hl->roots = realloc(hl->roots, hl->root_capacity * sizeof(Node_Id));
+        if (!hl->roots) {
+            exit_with_error("Failed to grow HashLife root stack");
+        }
+    }
+    hl->roots[hl->root_count++] = id;
+}
+
+static void pop_roots(Hashlife_Engine *hl, int count) {
+    hl->root_count -= count;
+}
+
+static void mark_node(Hashlife_Engine *hl, Node_Id id) {
+    Hl_Node *node = get_node(hl, id);
+    if (node->marked) {
+        return;
+    }
+    node->marked = 1;
+    if (node->level > 0) {
+        mark_node(hl, node->nw);
+        mark_node(hl, node->ne);
+        mark_node(hl, node->sw);
+        mark_node(hl, node->se);
+    }
+}
+
+static void collect_garbage(Hashlife_Engine *hl) {
+    for (int i = 0; i < hl->root_count; i++) {
+        mark_node(hl, hl->roots[i]);
+    }
+    mark_node(hl, 1);
+    for (int level = 0; level <= MAX_LEVEL; level++) {
+        if (hl->empty[level] != NIL_NODE) {
+            mark_node(hl, hl->empty[level]);
+        }
+    }
+    if (hl->root != NIL_NODE) {
+        mark_node(hl, hl->root);
+    }
+    if (hl->read_root != NIL_NODE) {
+        mark_node(hl, hl->read_root);
+    }
+
+    // Keep the memoised results whose both ends survive.
+    for (uint32_t i = 0; i <= hl->result_mask; i++) {
+        Hl_Result *entry = &hl->results[i];
+        if (entry->node != NIL_NODE &&
+            (!get_node(hl, entry->node)->marked || !get_node(hl, entry->result)->marked)) {
+            entry->node = NIL_NODE;
+        }
+    }
+
+    for (uint32_t i = 0; i <= hl->bucket_mask; i++) {
+        hl->buckets[i] = NIL_NODE;
+    }
+    hl->free_list = NIL_NODE;
+    hl->free_count = 0;
+
+    for (Node_Id id = hl->node_count; id-- > 0;) {
+        Hl_Node *node = get_node(hl, id);
+        if (node->marked) {
+            node->marked = 0;
+            if (node->level > 0) {
+                uint32_t bucket = hash_children(node->nw, node->ne, node->sw, node->se) & hl->bucket_mask;
+                node->next = hl->buckets[bucket];
+                hl->buckets[bucket] = id;
+            }
+        } else {
+            node->level = FREE_LEVEL;
+            node->next = hl->free_list;
+            hl->free_list = id;
+            hl->free_count++;
+        }
+    }
+
+    hl->gc_count++;
+}
+
+// One bucket per node, as a power of two.
+static uint32_t get_bucket_count(uint32_t max_nodes) {
+    uint32_t bucket_count = 1;
+    while (bucket_count < max_nodes && bucket_count < (1u << 31)) {
+        bucket_count *= 2;
+    }
+    return bucket_count;
+}
+
+// Rechains every hashed node into a bucket array of bucket_count.
+static void resize_buckets(Hashlife_Engine *hl, uint32_t bucket_count) {
+    free(hl->buckets);
+    hl->bucket_mask = bucket_count - 1;
+    hl->buckets = xmalloc((size_t)bucket_count * sizeof(Node_Id));
+    memset(hl->buckets, 0xFF, (size_t)bucket_count * sizeof(Node_Id));
+    for (Node_Id id = hl->node_count; id-- > 0;) {
+        Hl_Node *node = get_node(hl, id);
+        if (node->level > 0 && node->level != FREE_LEVEL) {
+            uint32_t bucket = hash_children(node->nw, node->ne, node->sw, node->se) & hl->bucket_mask;
+            node->next = hl->buckets[bucket];
+            hl->buckets[bucket] = id;
+        }
+    }
+}
+
+static Node_Id allocate_node(Hashlife_Engine *hl) {
+    if (hl->free_list == NIL_NODE && hl->node_count == hl->max_nodes) {
+        collect_garbage(hl);
+        if (hl->free_count < hl->max_nodes / 100 * MIN_FREE_PERCENT_AFTER_GC) {
+            if (hl->max_nodes == MAX_NODE_COUNT) {
+                // Nowhere left to grow: thrash on what the collection freed.
+                if (hl->free_count == 0) {
+                    exit_with_error("HashLife: live nodes fill the largest node store (%u nodes)", MAX_NODE_COUNT);
+                }
+            } else {
+                if (!hl->warned_over_limit) {
+                    trace_log("HashLife: live nodes exceed the memory limit, growing past it");
+                    hl->warned_over_limit = true;
+                }
+                uint64_t grown = (uint64_t)hl->max_nodes + hl->max_nodes / 2;
+                hl->max_nodes = grown < MAX_NODE_COUNT ? (uint32_t)grown : MAX_NODE_COUNT;
+                // Keep chains short as the store outgrows the buckets sized
+                // for the cap.
+                uint32_t bucket_count = get_bucket_count(hl->max_nodes);
+                if (bucket_count > hl->bucket_mask + 1) {
+                    resize_buckets(hl, bucket_count);
+                }
+                trace_log("HashLife: node store grown to %u nodes (%.0f MB)", hl->max_nodes,
+                          (double)hl->max_nodes * (sizeof(Hl_Node) + sizeof(Node_Id)) / (1024.0 * 1024.0));
+            }
+        }
+    }
+
+    if (hl->free_list != NIL_NODE) {
+        Node_Id id = hl->free_list;
+        hl->free_list = get_node(hl, id)->next;
+        hl->free_count--;
+        return id;
+    }
+
+    if (hl->node_count == hl->node_capacity) {
+        uint64_t doubled = (uint64_t)hl->node_capacity * 2;
+        hl->node_capacity = doubled < hl->max_nodes ? (uint32_t)doubled : hl->max_nodes;
+        hl->nodes = realloc(hl->nodes, (size_t)hl->node_capacity * sizeof(Hl_Node));
+        if (!hl->nodes) {
+            exit_with_error("Failed to grow HashLife node store");
+        }
+    }
+    return hl->node_count++;
+}
+
+// Populations of huge tilings can exceed 64 bits; clamp rather than wrap, so
+// a full node never reads as empty.
+static inline uint64_t add_population(uint64_t a, uint64_t b) {
+    return a + b < a ? UINT64_MAX : a + b;
+}
+
+static Node_Id make_node(Hashlife_Engine *hl, Node_Id nw, Node_Id ne, Node_Id sw, Node_Id se) {
+    uint32_t bucket = hash_children(nw, ne, sw, se) & hl->bucket_mask;
+    for (Node_Id id = hl->buckets[bucket]; id != NIL_NODE; id = get_node(hl, id)->next) {
+        Hl_Node *node = get_node(hl, id);
+        if (node->nw == nw && node->ne == ne && node->sw == sw && node->se == se) {
+            return id;
+        }
+    }
+
+    // Allocation may collect garbage; the children aren't referenced by
+    // anything yet, so pin them for the duration.
+    push_root(hl, nw);
+    push_root(hl, ne);
+    push_root(hl, sw);
+    push_root(hl, se);
+    Node_Id id = allocate_node(hl);
+    pop_roots(hl, 4);
+
+    Hl_Node *node = get_node(hl, id);
+    node->nw = nw;
+    node->ne = ne;
+    node->sw = sw;
+    node->se = se;
+    node->level = get_node(hl, nw)->level + 1;
+    node->marked = 0;
+    node->population = add_population(add_population(get_node(hl, nw)->population, get_node(hl, ne)->population),
+                                      add_population(get_node(hl, sw)->population, get_node(hl, se)->population));
+    // Growing the store may have resized the buckets under the old mask.
+    bucket = hash_children(nw, ne, sw, se) & hl->bucket_mask;
+    node->next = hl->buckets[bucket];
+    hl->buckets[bucket] = id;
+    return id;
+}
+
+static Node_Id get_empty_node(Hashlife_Engine *hl, int level) {
+    if (hl->empty[level] == NIL_NODE) {
+        Node_Id child = get_empty_node(hl, level - 1);
+        hl->empty[level] = make_node(hl, child, child, child, child);
+    }
+    return hl->empty[level];
+}
+
+// Sub-nodes one level down, straddling the seams between quadrants.
+static Node_Id centered_horizontal(Hashlife_Engine *hl, Node_Id w, Node_Id e) {
+    Hl_Node west = *get_node(hl, w);
+    Hl_Node east = *get_node(hl, e);
+    return make_node(hl, west.ne, east.nw, west.se, east.sw);
+}
+
+static Node_Id centered_vertical(Hashlife_Engine *hl, Node_Id n, Node_Id s) {
+    Hl_Node north = *get_node(hl, n);
+    Hl_Node south = *get_node(hl, s);
+    return make_node(hl, north.sw, north.se, south.nw, south.ne);
+}
+
+static Node_Id centered_node(Hashlife_Engine *hl, Node_Id id) {
+    Hl_Node node = *get_node(hl, id);
+    return make_node(hl, get_node(hl, node.nw)->se, get_node(hl, node.ne)->sw,
+                     get_node(hl, node.sw)->ne, get_node(hl, node.se)->nw);
+}
+
+static inline int get_leaf(Hashlife_Engine *hl, Node_Id level1, int x, int y) {
+    Hl_Node *node = get_node(hl, level1);
+    Node_Id quadrant = y == 0 ? (x == 0 ? node->nw : node->ne) : (x == 0 ? node->sw : node->se);
+    return (int)get_node(hl, quadrant)->population;
+}
+
+// One generation of a 4x4 node, returning its centre 2x2.
+static Node_Id step_level2(Hashlife_Engine *hl, Node_Id id) {
+    Hl_Node node = *get_node(hl, id);
+    int cells[4][4];
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            Node_Id quadrant = y < 2 ? (x < 2 ? node.nw : node.ne) : (x < 2 ? node.sw : node.se);
+            cells[y][x] = get_leaf(hl, quadrant, x & 1, y & 1);
+        }
+    }
+
+    Node_Id next[2][2];
+    for (int y = 1; y <= 2; y++) {
+        for (int x = 1; x <= 2; x++) {
+            int alive_neighbors = 0;
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    if (dx != 0 || dy != 0) {
+                        alive_neighbors += cells[y + dy][x + dx];
+                    }
+                }
+            }
+            uint16_t mask = cells[y][x] ? hl->survival : hl->birth;
+            next[y - 1][x - 1] = (mask >> alive_neighbors) & 1;
+        }
+    }
+    return make_node(hl, next[0][0], next[0][1], next[1][0], next[1][1]);
+}
+
+// Advances a level-L node by 2^step_log2 generations (step_log2 <= L - 2) and
+// returns its centre, one level down.
+static Node_Id step_node(Hashlife_Engine *hl, Node_Id id, uint32_t step_log2) {
+    Hl_Node node = *get_node(hl, id);
+    if (node.population == 0) {
+        return get_empty_node(hl, node.level - 1);
+    }
+    if (node.level == 2) {
+        return step_level2(hl, id);
+    }
+
+    uint32_t slot = hash_result_key(id, step_log2) & hl->result_mask;
+    Hl_Result *cached = &hl->results[slot];
+    if (cached->node == id && cached->step_log2 == step_log2) {
+        return cached->result;
+    }
+
+    int base = hl->root_count;
+    bool full_speed = step_log2 == (uint32_t)node.level - 2;
+
+    Node_Id sub[9];
+    sub[0] = node.nw;
+    sub[1] = centered_horizontal(hl, node.nw, node.ne); push_root(hl, sub[1]);
+    sub[2] = node.ne;
+    sub[3] = centered_vertical(hl, node.nw, node.sw); push_root(hl, sub[3]);
+    sub[4] = centered_node(hl, id); push_root(hl, sub[4]);
+    sub[5] = centered_vertical(hl, node.ne, node.se); push_root(hl, sub[5]);
+    sub[6] = node.sw;
+    sub[7] = centered_horizontal(hl, node.sw, node.se); push_root(hl, sub[7]);
+    sub[8] = node.se;
+
+    // First half: nine overlapping sub-nodes, advanced 2^(L-3) generations at
+    // full speed, or just re-centred when the step is smaller.
+    Node_Id part[9];
+    for (int i = 0; i < 9; i++) {
+        part[i] = full_speed ? step_node(hl, sub[i], step_log2 - 1) : centered_node(hl, sub[i]);
+        push_root(hl, part[i]);
+    }
+
+    // Second half: regroup into four and advance the remainder.
+    uint32_t inner_step = full_speed ? step_log2 - 1 : step_log2;
+    Node_Id quad[4];
+    for (int i = 0; i < 4; i++) {
+        int row = i / 2;
+        int col = i % 2;
+        Node_Id group = make_node(hl, part[row * 3 + col], part[row * 3 + col + 1],
+                                  part[row * 3 + col + 3], part[row * 3 + col + 4]);
+        push_root(hl, group);
+        quad[i] = step_node(hl, group, inner_step);
+        push_root(hl, quad[i]);
+    }
+
+    Node_Id result = make_node(hl, quad[0], quad[1], quad[2], quad[3]);
+    pop_roots(hl, hl->root_count - base);
+
+    // The cache slot may have moved under a collection; recompute it.
+    cached = &hl->results[hash_result_key(id, step_log2) & hl->result_mask];
+    cached->node = id;
+    cached->step_log2 = step_log2;
+    cached->result = result;
+    return result;
+}
+
+// Builds the node for the square [x0, x0 + 2^level) x [y0, y0 + 2^level) of
+// grid; cells outside the grid are dead.
+static Node_Id build_from_grid(Hashlife_Engine *hl, const Bit_Grid *grid, int64_t x0, int64_t y0, int level) {
+    int64_t size = (int64_t)1 << level;
+    if (x0 >= grid->w || y0 >= grid->h || x0 + size <= 0 || y0 + size <= 0) {
+        return get_empty_node(hl, level);
+    }
+    if (level == 0) {
+        return get_bit_grid_cell(grid, (int)x0, (int)y0) ? 1 : 0;
+    }
+    if (level == 6 && x0 >= 0 && (x0 & 63) == 0 && y0 >= 0 && y0 + size <= grid->h) {
+        bool any = false;
+        for (int y = 0; y < 64 && !any; y++) {
+            any = get_bit_grid_row(grid, (int)y0 + y)[x0 >> 6] != 0;
+        }
+        if (!any) {
+            return get_empty_node(hl, level);
+        }
+    }
+
+    int64_t half = size / 2;
+    int base = hl->root_count;
+    Node_Id nw = build_from_grid(hl, grid, x0, y0, level - 1); push_root(hl, nw);
+    Node_Id ne = build_from_grid(hl, grid, x0 + half, y0, level - 1); push_root(hl, ne);
+    Node_Id sw = build_from_grid(hl, grid, x0, y0 + half, level - 1); push_root(hl, sw);
+    Node_Id se = build_from_grid(hl, grid, x0 + half, y0 + half, level - 1);
+    Node_Id result = make_node(hl, nw, ne, sw, se);
+    pop_roots(hl, hl->root_count - base);
+    return result;
+}
+
+static void write_to_grid(Hashlife_Engine *hl, Node_Id id, Bit_Grid *grid, int64_t x0, int64_t y0) {
+    Hl_Node *node = get_node(hl, id);
+    int64_t size = (int64_t)1 << node->level;
+    if (node->population == 0 || x0 >= grid->w || y0 >= grid->h || x0 + size <= 0 || y0 + size <= 0) {
+        return;
+    }
+    if (node->level == 0) {
+        set_bit_grid_cell(grid, (int)x0, (int)y0, true);
+        return;
+    }
+
+    int64_t half = size / 2;
+    Hl_Node copy = *node;
+    write_to_grid(hl, copy.nw, grid, x0, y0);
+    write_to_grid(hl, copy.ne, grid, x0 + half, y0);
+    write_to_grid(hl, copy.sw, grid, x0, y0 + half);
+    write_to_grid(hl, copy.se, grid, x0 + half, y0 + half);
+}
+
+static void clear_grid_cells(Bit_Grid *grid, int x_begin, int y_begin, int x_end, int y_end) {
+    for (int y = y_begin; y < y_end; y++) {
+        uint64_t *row = get_bit_grid_row(grid, y);
+        for (int x = x_begin; x < x_end;) {
+            int bit = x & 63;
+            int count = 64 - bit < x_end - x ? 64 - bit : x_end - x;
+            row[x >> 6] &= ~(count == 64 ? ~0ull : ((1ull << count) - 1) << bit);
+            x += count;
+        }
+    }
+}
+
+// Rewrites the square at (x0, y0) where current differs from previous, the
+// node read into the same square last time, flagging the blocks rewritten.
+static void write_changes_to_grid(Hashlife_Engine *hl, Node_Id previous, Node_Id current, Bit_Grid *grid,
+                                  int64_t x0, int64_t y0, uint8_t *changed_blocks) {
+    if (previous == current) {
+        return;
+    }
+    Hl_Node node = *get_node(hl, current);
+    int64_t size = (int64_t)1 << node.level;
+    if (x0 >= grid->w || y0 >= grid->h || x0 + size <= 0 || y0 + size <= 0) {
+        return;
+    }
+    if (size <= CHANGED_BLOCK_SIZE) {
+        int x_begin = x0 > 0 ? (int)x0 : 0;
+        int y_begin = y0 > 0 ? (int)y0 : 0;
+        int x_end = x0 + size < grid->w ? (int)(x0 + size) : grid->w;
+        int y_end = y0 + size < grid->h ? (int)(y0 + size) : grid->h;
+        clear_grid_cells(grid, x_begin, y_begin, x_end, y_end);
+        write_to_grid(hl, current, grid, x0, y0);
+        flag_changed_blocks(changed_blocks, grid->w, x_begin, y_begin, x_end, y_end);
+        return;
+    }
+
+    int64_t half = size / 2;
+    Hl_Node before = *get_node(hl, previous);
+    write_changes_to_grid(hl, before.nw, node.nw, grid, x0, y0, changed_blocks);
+    write_changes_to_grid(hl, before.ne, node.ne, grid, x0 + half, y0, changed_blocks);
+    write_changes_to_grid(hl, before.sw, node.sw, grid, x0, y0 + half, changed_blocks);
+    write_changes_to_grid(hl, before.se, node.se, grid, x0 + half, y0 + half, changed_blocks);
+}
+
+static int get_level_for_side(int side) {
+    int level = 0;
+    while (((int64_t)1 << level) < side) {
+        level++;
+    }
+    return level;
+}
+
+// Advances a torus of side 2^k by 2^step_log2 generations. A node of 4^m
+// copies of the root, m >= 2, is the periodic tiling of the torus; its result
+// starts at offset 2^(k+m-2), a multiple of the period, so descending north-
+// west to level k yields the torus again without any shift.
+static Node_Id step_torus(Hashlife_Engine *hl, Node_Id root, uint32_t step_log2) {
+    int k = get_node(hl, root)->level;
+    int m = (int)step_log2 - k + 2 > 2 ? (int)step_log2 - k + 2 : 2;
+    if (k + m > MAX_LEVEL) {
+        exit_with_error("HashLife: step 2^%u is too large for a torus of level %d", step_log2, k);
+    }
+
+    int base = hl->root_count;
+    Node_Id tiling = root;
+    for (int i = 0; i < m; i++) {
+        tiling = make_node(hl, tiling, tiling, tiling, tiling);
+        push_root(hl, tiling);
+    }
+
+    Node_Id result = step_node(hl, tiling, step_log2);
+    while (get_node(hl, result)->level > k) {
+        result = get_node(hl, result)->nw;
+    }
+    pop_roots(hl, hl->root_count - base);
+    return result;
+}
+
+// Plane roots are centred on the origin: a level-L root spans
+// [-2^(L-1), 2^(L-1)) on both axes.
+static Node_Id expand_plane_root(Hashlife_Engine *hl, Node_Id root) {
+    Hl_Node node = *get_node(hl, root);
+    Node_Id e = get_empty_node(hl, node.level - 1);
+    int base = hl->root_count;
+    Node_Id nw = make_node(hl, e, e, e, node.nw); push_root(hl, nw);
+    Node_Id ne = make_node(hl, e, e, node.ne, e); push_root(hl, ne);
+    Node_Id sw = make_node(hl, e, node.sw, e, e); push_root(hl, sw);
+    Node_Id se = make_node(hl, node.se, e, e, e);
+    Node_Id result = make_node(hl, nw, ne, sw, se);
+    pop_roots(hl, hl->root_count - base);
+    return result;
+}
+
+// True if all live cells lie in the centre quarter (per axis) of a root of
+// level >= 3.
+static bool is_plane_root_padded(Hashlife_Engine *hl, Node_Id root) {
+    Hl_Node node = *get_node(hl, root);
+    Node_Id nw = get_node(hl, get_node(hl, node.nw)->se)->se;
+    Node_Id ne = get_node(hl, get_node(hl, node.ne)->sw)->sw;
+    Node_Id sw = get_node(hl, get_node(hl, node.sw)->ne)->ne;
+    Node_Id se = get_node(hl, get_node(hl, node.se)->nw)->nw;
+    uint64_t inner = get_node(hl, nw)->population + get_node(hl, ne)->population +
+                     get_node(hl, sw)->population + get_node(hl, se)->population;
+    return inner == node.population;
+}
+
+static Node_Id step_plane(Hashlife_Engine *hl, Node_Id root, uint32_t step_log2) {
+    // After 2^j generations the pattern grows at most 2^j cells per side, so
+    // with the live cells in the centre quarter of a root of level >= j + 3
+    // they all stay inside the result (the centre half).
+    push_root(hl, root);
+    while (get_node(hl, root)->level < step_log2 + 3 || !is_plane_root_padded(hl, root)) {
+        root = expand_plane_root(hl, root);
+        hl->roots[hl->root_count - 1] = root;
+    }
+    Node_Id result = step_node(hl, root, step_log2);
+    pop_roots(hl, 1);
+    return result;
+}
+
+static bool hashlife_engine_supports_rule(const Rule *rule) {
+    return rule->family == RULE_FAMILY_LIFE && !(rule->birth & 1);
+}
+
+static bool hashlife_engine_init(Gol_Engine *engine) {
+    bool unbounded = engine->options.unbounded;
+    int level = get_level_for_side(engine->grid_w > engine->grid_h ? engine->grid_w : engine->grid_h);
+    if (!unbounded && (engine->grid_w != engine->grid_h || ((int64_t)1 << level) != engine->grid_w)) {
+        trace_log("HashLife: a toroidal grid must be square with a power-of-two side (got %dx%d); "
+                  "use an unbounded universe instead", engine->grid_w, engine->grid_h);
+        return false;
+    }
+
+    Hashlife_Engine *hl = xcalloc(1, sizeof(Hashlife_Engine));
+    hl->unbounded = unbounded;
+    hl->birth = engine->rule.birth;
+    hl->survival = engine->rule.survival;
+
+    size_t limit_mb = engine->options.memory_limit_mb > 0
+        ? engine->options.memory_limit_mb : DEFAULT_MEMORY_LIMIT_MB;
+    size_t limit_bytes = limit_mb * 1024 * 1024;
+
+    // A quarter of the budget goes to the result cache, the rest to nodes
+    // and their hash buckets (one bucket per node).
+    uint32_t result_slots = 1;
+    while ((size_t)result_slots * 2 * sizeof(Hl_Result) <= limit_bytes / 4 && result_slots < (1u << 30)) {
+        result_slots *= 2;
+    }
+    size_t node_bytes = limit_bytes - (size_t)result_slots * sizeof(Hl_Result);
+    size_t max_nodes = node_bytes / (sizeof(Hl_Node) + sizeof(Node_Id));
+    if (max_nodes > MAX_NODE_COUNT) {
+        max_nodes = MAX_NODE_COUNT;
+    }
+    if (max_nodes < 1024) {
+        max_nodes = 1024;
+    }
+
+    hl->max_nodes = (uint32_t)max_nodes;
+    hl->node_capacity = hl->max_nodes < 4096 ? hl->max_nodes : 4096;
+    hl->nodes = xmalloc((size_t)hl->node_capacity * sizeof(Hl_Node));
+    hl->free_list = NIL_NODE;
+    resize_buckets(hl, get_bucket_count(hl->max_nodes));
+    hl->result_mask = result_slots - 1;
+    hl->results = xmalloc((size_t)result_slots * sizeof(Hl_Result));
+    for (uint32_t i = 0; i < result_slots; i++) {
+        hl->results[i].node = NIL_NODE;
+    }
+    for (int i = 0; i <= MAX_LEVEL; i++) {
+        hl->empty[i] = NIL_NODE;
+    }
+    hl->root = NIL_NODE;
+    hl->read_root = NIL_NODE;
+
+    // Level-0 leaves: ids 0 (dead) and 1 (alive), outside the hash table.
+    for (int alive = 0; alive <= 1; alive++) {
+        Node_Id id = allocate_node(hl);
+        Hl_Node *leaf = get_node(hl, id);
+        memset(leaf, 0, sizeof(Hl_Node));
+        leaf->nw = leaf->ne = leaf->sw = leaf->se = NIL_NODE;
+        leaf->population = alive;
+    }
+    hl->empty[0] = 0;
+
+    engine->impl = hl;
+    hl->root = get_empty_node(hl, unbounded ? (level > 3 ? level + 1 : 4) : level);
+    return true;
+}
+
+static void hashlife_engine_destroy(Gol_Engine *engine) {
+    Hashlife_Engine *hl = engine->impl;
+    free(hl->nodes);
+    free(hl->buckets);
+    free(hl->results);
+    free(hl->roots);
+    free(hl);
+}
+
+static void hashlife_engine_seed(Gol_Engine *engine, const Bit_Grid *grid) {
+    Hashlife_Engine *hl = engine->impl;
+    int level = get_level_for_side(grid->w > grid->h ? grid->w : grid->h);
+
+    hl->root = NIL_NODE;
+    hl->read_root = NIL_NODE;
+    if (hl->unbounded) {
+        // The grid goes into the south-east quadrant of a root centred on 0.
+        Node_Id quadrant = build_from_grid(hl, grid, 0, 0, level);
+        push_root(hl, quadrant);
+        Node_Id e = get_empty_node(hl, level);
+        hl->root = make_node(hl, e, e, e, quadrant);
+        pop_roots(hl, 1);
+    } else {
+        hl->root = build_from_grid(hl, grid, 0, 0, level);
+    }
+}
+
+static void hashlife_engine_step(Gol_Engine *engine, uint64_t generations) {
+    Hashlife_Engine *hl = engine->impl;
+    for (uint32_t bit = 0; bit < 64; bit++) {
+        if (!(generations & (1ull << bit))) {
+            continue;
+        }
+        hl->root = hl->unbounded ? step_plane(hl, hl->root, bit) : step_torus(hl, hl->root, bit);
+    }
+}
+
+// Where the root's north-west corner lies in grid coordinates.
+static int64_t get_root_origin(Hashlife_Engine *hl, Node_Id root) {
+    return hl->unbounded ? -((int64_t)1 << (get_node(hl, root)->level - 1)) : 0;
+}
+
+static void hashlife_engine_read_grid(Gol_Engine *engine, Bit_Grid *grid) {
+    Hashlife_Engine *hl = engine->impl;
+    clear_bit_grid(grid);
+    int64_t origin = get_root_origin(hl, hl->root);
+    write_to_grid(hl, hl->root, grid, origin, origin);
+}
+
+// Roots of different levels (a plane that grew) share no positions, so
+// that read starts over.
+static void hashlife_engine_read_grid_changes(Gol_Engine *engine, Bit_Grid *grid, uint8_t *changed_blocks) {
+    Hashlife_Engine *hl = engine->impl;
+    size_t block_count = get_changed_block_count(grid->w, grid->h);
+    if (hl->read_root == NIL_NODE || get_node(hl, hl->read_root)->level != get_node(hl, hl->root)->level) {
+        hashlife_engine_read_grid(engine, grid);
+        memset(changed_blocks, 1, block_count);
+    } else {
+        memset(changed_blocks, 0, block_count);
+        int64_t origin = get_root_origin(hl, hl->root);
+        write_changes_to_grid(hl, hl->read_root, hl->root, grid, origin, origin, changed_blocks);
+    }
+    hl->read_root = hl->root;
+}
+
+static uint64_t hashlife_engine_population(Gol_Engine *engine) {
+    Hashlife_Engine *hl = engine->impl;
+    return get_node(hl, hl->root)->population;
+}
+
+static size_t hashlife_engine_memory_usage(Gol_Engine *engine) {
+    Hashlife_Engine *hl = engine->impl;
+    return sizeof(Hashlife_Engine)
+        + (size_t)hl->node_capacity * sizeof(Hl_Node)
+        + ((size_t)hl->bucket_mask + 1) * sizeof(Node_Id)
+        + ((size_t)hl->result_mask + 1) * sizeof(Hl_Result)
+        + (size_t)hl->root_capacity * sizeof(Node_Id);
+}
+
+const Gol_Engine_Api g_hashlife_engine_api = {
+    .name = "hashlife",
+    .supports_rule = hashlife_engine_supports_rule,
+    .init = hashlife_engine_init,
+    .destroy = hashlife_engine_destroy,
+    .seed = hashlife_engine_seed,
+    .step = hashlife_engine_step,
+    .read_grid = hashlife_engine_read_grid,
+    .read_grid_changes = hashlife_engine_read_grid_changes,
+    .population = hashlife_engine_population,
+    .memory_usage = hashlife_engine_memory_usage,
+};
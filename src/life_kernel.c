@@ -0,0 +1,721 @@
+#include "life_kernel.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LIFE_KERNEL_X86 1
+#include <immintrin.h>
+#endif
+
+// Neighbour counting as a full-adder network: the eight neighbour words are
+// summed into count bits s3 s2 s1 s0, where s3 is only set for a count of 8.
+// Written once over abstract AND/OR/XOR so the scalar and vector paths share
+// it.
+#define LIFE_COUNT(T, AND, OR, XOR, ul, uc, ur, ml, mr, dl, dc, dr, s0, s1, s2, s3) \
+    do {                                                                           \
+        T u0_ = XOR(XOR(ul, uc), ur);                                              \
+        T u1_ = OR(AND(ul, uc), AND(ur, XOR(ul, uc)));                             \
+        T m0_ = XOR(ml, mr);                                                       \
+        T m1_ = AND(ml, mr);                                                       \
+        T d0_ = XOR(XOR(dl, dc), dr);                                              \
+        T d1_ = OR(AND(dl, dc), AND(dr, XOR(dl, dc)));                             \
+        T c0_ = OR(AND(u0_, m0_), AND(d0_, XOR(u0_, m0_)));                        \
+        T x0_ = XOR(XOR(u1_, m1_), d1_);                                           \
+        T x1_ = OR(AND(u1_, m1_), AND(d1_, XOR(u1_, m1_)));                        \
+        T k_ = AND(x0_, c0_);                                                      \
+        (s0) = XOR(XOR(u0_, m0_), d0_);                                            \
+        (s1) = XOR(x0_, c0_);                                                      \
+        (s2) = XOR(x1_, k_);                                                       \
+        (s3) = AND(x1_, k_);                                                       \
+    } while (0)
+
+// B3/S23 reduced by hand: a cell lives iff the count is 2 or 3 and either the
+// count is odd or the cell is already alive. A count of 8 has s2..s0 clear, so
+// s3 never matters. ANDNOT(a, b) is (~a & b).
+#define CONWAY_OUTPUT(T, AND, OR, ANDNOT, ONES, s0, s1, s2, s3, mc, birth, survival, result) \
+    do {                                                                                   \
+        (void)(s3);                                                                        \
+        (result) = ANDNOT(s2, AND(s1, OR(s0, mc)));                                        \
+    } while (0)
+
+// Any B/S rule: the union over counts n in either mask of "count == n",
+// restricted to dead or live cells when n is in only one of them. With
+// constant masks the compiler drops every term the rule doesn't use.
+#define COUNT_TERM(T, AND, OR, ANDNOT, ONES, s0, s1, s2, s3, mc, birth, survival, result, n)  \
+    if ((((birth) | (survival)) >> (n)) & 1) {                                                \
+        T eq_ = AND(AND((n) & 1 ? (s0) : ANDNOT(s0, ONES), (n) & 2 ? (s1) : ANDNOT(s1, ONES)), \
+                    AND((n) & 4 ? (s2) : ANDNOT(s2, ONES), (n) & 8 ? (s3) : ANDNOT(s3, ONES))); \
+        if (!(((birth) >> (n)) & 1)) {                                                        \
+            eq_ = AND(eq_, mc);                                                               \
+        } else if (!(((survival) >> (n)) & 1)) {                                              \
+            eq_ = ANDNOT(mc, eq_);                                                            \
+        }                                                                                     \
+        (result) = OR(result, eq_);                                                           \
+    }
+
+#define BS_OUTPUT(T, AND, OR, ANDNOT, ONES, s0, s1, s2, s3, mc, birth, survival, result)       \
+    do {                                                                                       \
+        (result) = ANDNOT(ONES, ONES);                                                         \
+        COUNT_TERM(T, AND, OR, ANDNOT, ONES, s0, s1, s2, s3, mc, birth, survival, result, 0)   \
+        COUNT_TERM(T, AND, OR, ANDNOT, ONES, s0, s1, s2, s3, mc, birth, survival, result, 1)   \
+        COUNT_TERM(T, AND, OR, ANDNOT, ONES, s0, s1, s2, s3, mc, birth, survival, result, 2)   \
+        COUNT_TERM(T, AND, OR, ANDNOT, ONES, s0, s1, s2, s3, mc, birth, survival, result, 3)   \
+        COUNT_TERM(T, AND, OR, ANDNOT, ONES, s0, s1, s2, s3, mc, birth, survival, result, 4)   \
+        COUNT_TERM(T, AND, OR, ANDNOT, ONES, s0, s1, s2, s3, mc, birth, survival, result, 5)   \
+        COUNT_TERM(T, AND, OR, ANDNOT, ONES, s0, s1, s2, s3, mc, birth, survival, result, 6)   \
+        COUNT_TERM(T, AND, OR, ANDNOT, ONES, s0, s1, s2, s3, mc, birth, survival, result, 7)   \
+        COUNT_TERM(T, AND, OR, ANDNOT, ONES, s0, s1, s2, s3, mc, birth, survival, result, 8)   \
+    } while (0)
+
+#define LIFE_STEP(T, AND, OR, XOR, ANDNOT, ONES, OUTPUT, birth, survival,                      \
+                  ul, uc, ur, ml, mc, mr, dl, dc, dr, result)                                 \
+    do {                                                                                       \
+        T s0_, s1_, s2_, s3_;                                                                  \
+        T mc_ = (mc);                                                                          \
+        LIFE_COUNT(T, AND, OR, XOR, ul, uc, ur, ml, mr, dl, dc, dr, s0_, s1_, s2_, s3_);       \
+        OUTPUT(T, AND, OR, ANDNOT, ONES, s0_, s1_, s2_, s3_, mc_, birth, survival, result);    \
+    } while (0)
+
+// Rules with their own kernels: name, output network, birth and survival.
+#define SPECIALIZED_LIFE_RULES(X)                     \
+    X(conway, CONWAY_OUTPUT, 0x008, 0x00C)            \
+    X(highlife, BS_OUTPUT, 0x048, 0x00C)              \
+    X(day_and_night, BS_OUTPUT, 0x1C8, 0x1D8)         \
+    X(seeds, BS_OUTPUT, 0x004, 0x000)                 \
+    X(life_without_death, BS_OUTPUT, 0x008, 0x1FF)    \
+    X(replicator, BS_OUTPUT, 0x0AA, 0x0AA)            \
+    X(morley, BS_OUTPUT, 0x148, 0x034)                \
+    X(two_by_two, BS_OUTPUT, 0x048, 0x026)
+
+// Generations rules with their own kernels: name, output network, birth,
+// survival and state count.
+#define SPECIALIZED_GENERATIONS_RULES(X)              \
+    X(brians_brain, BS_OUTPUT, 0x004, 0x000, 3)       \
+    X(star_wars, BS_OUTPUT, 0x004, 0x038, 4)
+
+// Generations on top of the B/S result for the same cells: births into dying
+// cells are dropped, live cells that don't survive start decaying at 1, and
+// dying counters count up until they reach STATES - 1, when the cell is dead
+// again. Writes word i of the live row and of every plane, and ORs each bit
+// that changed into changed. With a constant STATES the plane loops unroll.
+#define GENERATIONS_STEP(T, AND, OR, XOR, ANDNOT, ONES, LOAD, STORE, STATES, args, i, mc, bs_result, changed) \
+    do {                                                                                                     \
+        int plane_count_ = get_generations_plane_count(STATES);                                              \
+        T planes_[MAX_GENERATIONS_PLANES];                                                                   \
+        T dying_ = ANDNOT(ONES, ONES);                                                                       \
+        for (int p_ = 0; p_ < plane_count_; p_++) {                                                          \
+            planes_[p_] = LOAD((args)->planes[p_] + (i));                                                    \
+            dying_ = OR(dying_, planes_[p_]);                                                                \
+        }                                                                                                    \
+        T alive_ = ANDNOT(dying_, bs_result);                                                                \
+        T died_ = ANDNOT(alive_, mc);                                                                        \
+        STORE((args)->life.out + (i), alive_);                                                               \
+        (changed) = OR(changed, XOR(alive_, mc));                                                            \
+        /* Add 1 to the dying counters and flag those that reach STATES - 1. */                              \
+        T carry_ = dying_;                                                                                   \
+        T expired_ = ONES;                                                                                   \
+        for (int p_ = 0; p_ < plane_count_; p_++) {                                                          \
+            T bit_ = XOR(planes_[p_], carry_);                                                               \
+            carry_ = AND(planes_[p_], carry_);                                                               \
+            expired_ = AND(expired_, (((STATES) - 1) >> p_) & 1 ? bit_ : ANDNOT(bit_, ONES));                \
+            planes_[p_] = bit_;                                                                              \
+        }                                                                                                    \
+        for (int p_ = 0; p_ < plane_count_; p_++) {                                                          \
+            T bit_ = ANDNOT(expired_, planes_[p_]);                                                          \
+            bit_ = p_ == 0 ? OR(bit_, died_) : bit_;                                                         \
+            (changed) = OR(changed, XOR(bit_, LOAD((args)->planes[p_] + (i))));                              \
+            STORE((args)->plane_out[p_] + (i), bit_);                                                        \
+        }                                                                                                    \
+    } while (0)
+
+#define SCALAR_AND(a, b) ((a) & (b))
+#define SCALAR_OR(a, b) ((a) | (b))
+#define SCALAR_XOR(a, b) ((a) ^ (b))
+#define SCALAR_ANDNOT(a, b) (~(a) & (b))
+#define SCALAR_ONES (~0ull)
+#define SCALAR_LOAD(p) (*(p))
+#define SCALAR_STORE(p, v) (*(p) = (v))
+
+struct Life_Row_Args {
+    const uint64_t *up;
+    const uint64_t *row;
+    const uint64_t *down;
+    uint64_t *out;
+    int grid_w;
+    int words_per_row;
+    uint64_t tail_mask;
+    // For the generic kernel and the edge words.
+    uint16_t birth;
+    uint16_t survival;
+};
+
+// Words whose neighbours sit in separate arrays: for the rows above (0), at
+// (1) and below (2) each output word, center[r][k] is the word in line with
+// out[k] and west[r][k] / east[r][k] the words to its left and right.
+struct Life_Words_Args {
+    const uint64_t *west[3];
+    const uint64_t *center[3];
+    const uint64_t *east[3];
+    uint64_t *out;
+    uint16_t birth;
+    uint16_t survival;
+};
+
+// A row of a Generations rule: life holds the live cells and masks as for a
+// Life-like row, and planes / plane_out the dying counters of the row.
+struct Generations_Row_Args {
+    Life_Row_Args life;
+    const uint64_t *planes[MAX_GENERATIONS_PLANES];
+    uint64_t *plane_out[MAX_GENERATIONS_PLANES];
+    // For the generic kernel and the edge words.
+    int states;
+};
+
+// Steps words [word_begin, word_end), all of which are strictly inside the row
+// (neither the first nor the last word), so neighbours never wrap. Returns
+// nonzero if any cell changed.
+typedef uint64_t (*Interior_Kernel)(const Life_Row_Args *args, int word_begin, int word_end);
+// Steps words [begin, end) of Life_Words_Args, vectorised along the arrays.
+typedef uint64_t (*Words_Kernel)(const Life_Words_Args *args, int begin, int end);
+// Steps words [word_begin, word_end) of a Generations row, which must be
+// strictly inside it as for Interior_Kernel. Returns nonzero if any cell
+// changed state.
+typedef uint64_t (*Generations_Interior_Kernel)(const Generations_Row_Args *args, int word_begin, int word_end);
+
+typedef enum {
+    LIFE_ISA_SCALAR,
+    LIFE_ISA_SSE2,
+    LIFE_ISA_AVX2,
+    LIFE_ISA_COUNT
+} Life_Isa;
+
+static const char *const g_isa_names[LIFE_ISA_COUNT] = { "scalar", "sse2", "avx2" };
+static int g_isa = -1;
+
+static inline uint64_t west_word(const uint64_t *row, int i, int grid_w) {
+    uint64_t carry = i > 0 ? row[i - 1] >> 63 : (row[(grid_w - 1) >> 6] >> ((grid_w - 1) & 63)) & 1;
+    return (row[i] << 1) | carry;
+}
+
+static inline uint64_t east_word(const uint64_t *row, int i, int grid_w, int words_per_row) {
+    if (i + 1 < words_per_row) {
+        return (row[i] >> 1) | (row[i + 1] << 63);
+    }
+    // Last word: the cell past grid_w - 1 is cell 0. Padding bits are zero, so
+    // the shifted-in slot at the tail is free for it.
+    int tail_bit = (grid_w - 1) & 63;
+    return (row[i] >> 1) | ((row[0] & 1) << tail_bit);
+}
+
+// Only two words a row, so these always take the generic network.
+static inline uint64_t step_edge_word(const Life_Row_Args *args, int i) {
+    int w = args->grid_w;
+    int n = args->words_per_row;
+    uint64_t result;
+    LIFE_STEP(uint64_t, SCALAR_AND, SCALAR_OR, SCALAR_XOR, SCALAR_ANDNOT, SCALAR_ONES,
+              BS_OUTPUT, args->birth, args->survival,
+              west_word(args->up, i, w), args->up[i], east_word(args->up, i, w, n),
+              west_word(args->row, i, w), args->row[i], east_word(args->row, i, w, n),
+              west_word(args->down, i, w), args->down[i], east_word(args->down, i, w, n),
+              result);
+    return i == n - 1 ? result & args->tail_mask : result;
+}
+
+static inline uint64_t step_generations_edge_word(const Generations_Row_Args *args, int i) {
+    uint64_t result = step_edge_word(&args->life, i);
+    uint64_t changed = 0;
+    GENERATIONS_STEP(uint64_t, SCALAR_AND, SCALAR_OR, SCALAR_XOR, SCALAR_ANDNOT, SCALAR_ONES,
+                     SCALAR_LOAD, SCALAR_STORE, args->states, args, i, args->life.row[i], result, changed);
+    return changed;
+}
+
+#define DEFINE_SCALAR_KERNEL(name, OUTPUT, BIRTH, SURVIVAL)                                                \
+    static uint64_t step_interior_scalar_##name(const Life_Row_Args *args, int word_begin, int word_end) { \
+        const uint64_t *up = args->up;                                                                    \
+        const uint64_t *row = args->row;                                                                  \
+        const uint64_t *down = args->down;                                                                \
+        uint64_t changed = 0;                                                                             \
+        (void)args->birth;                                                                                \
+                                                                                                          \
+        for (int i = word_begin; i < word_end; i++) {                                                     \
+            uint64_t result;                                                                              \
+            LIFE_STEP(uint64_t, SCALAR_AND, SCALAR_OR, SCALAR_XOR, SCALAR_ANDNOT, SCALAR_ONES,            \
+                      OUTPUT, BIRTH, SURVIVAL,                                                            \
+                      (up[i] << 1) | (up[i - 1] >> 63), up[i], (up[i] >> 1) | (up[i + 1] << 63),          \
+                      (row[i] << 1) | (row[i - 1] >> 63), row[i], (row[i] >> 1) | (row[i + 1] << 63),     \
+                      (down[i] << 1) | (down[i - 1] >> 63), down[i], (down[i] >> 1) | (down[i + 1] << 63), \
+                      result);                                                                            \
+            args->out[i] = result;                                                                        \
+            changed |= result ^ row[i];                                                                   \
+        }                                                                                                 \
+        return changed;                                                                                   \
+    }
+
+SPECIALIZED_LIFE_RULES(DEFINE_SCALAR_KERNEL)
+DEFINE_SCALAR_KERNEL(generic, BS_OUTPUT, args->birth, args->survival)
+
+#define SCALAR_WORDS_WEST(args, r, k) (((args)->center[r][k] << 1) | ((args)->west[r][k] >> 63))
+#define SCALAR_WORDS_EAST(args, r, k) (((args)->center[r][k] >> 1) | ((args)->east[r][k] << 63))
+
+#define DEFINE_SCALAR_WORDS_KERNEL(name, OUTPUT, BIRTH, SURVIVAL)                                               \
+    static uint64_t step_words_scalar_##name(const Life_Words_Args *args, int begin, int end) {                \
+        uint64_t changed = 0;                                                                                  \
+        (void)args->birth;                                                                                     \
+                                                                                                               \
+        for (int k = begin; k < end; k++) {                                                                    \
+            uint64_t result;                                                                                   \
+            LIFE_STEP(uint64_t, SCALAR_AND, SCALAR_OR, SCALAR_XOR, SCALAR_ANDNOT, SCALAR_ONES,                 \
+                      OUTPUT, BIRTH, SURVIVAL,                                                                 \
+                      SCALAR_WORDS_WEST(args, 0, k), args->center[0][k], SCALAR_WORDS_EAST(args, 0, k),        \
+                      SCALAR_WORDS_WEST(args, 1, k), args->center[1][k], SCALAR_WORDS_EAST(args, 1, k),        \
+                      SCALAR_WORDS_WEST(args, 2, k), args->center[2][k], SCALAR_WORDS_EAST(args, 2, k),        \
+                      result);                                                                                 \
+            args->out[k] = result;                                                                             \
+            changed |= result ^ args->center[1][k];                                                            \
+        }                                                                                                      \
+        return changed;                                                                                        \
+    }
+
+SPECIALIZED_LIFE_RULES(DEFINE_SCALAR_WORDS_KERNEL)
+DEFINE_SCALAR_WORDS_KERNEL(generic, BS_OUTPUT, args->birth, args->survival)
+
+#define DEFINE_SCALAR_GENERATIONS_KERNEL(name, OUTPUT, BIRTH, SURVIVAL, STATES)                                         \
+    static uint64_t step_generations_scalar_##name(const Generations_Row_Args *args, int word_begin, int word_end) {  \
+        const uint64_t *up = args->life.up;                                                                         \
+        const uint64_t *row = args->life.row;                                                                       \
+        const uint64_t *down = args->life.down;                                                                     \
+        uint64_t changed = 0;                                                                                       \
+        (void)args->states;                                                                                         \
+                                                                                                                    \
+        for (int i = word_begin; i < word_end; i++) {                                                               \
+            uint64_t result;                                                                                        \
+            LIFE_STEP(uint64_t, SCALAR_AND, SCALAR_OR, SCALAR_XOR, SCALAR_ANDNOT, SCALAR_ONES,                      \
+                      OUTPUT, BIRTH, SURVIVAL,                                                                      \
+                      (up[i] << 1) | (up[i - 1] >> 63), up[i], (up[i] >> 1) | (up[i + 1] << 63),                    \
+                      (row[i] << 1) | (row[i - 1] >> 63), row[i], (row[i] >> 1) | (row[i + 1] << 63),               \
+                      (down[i] << 1) | (down[i - 1] >> 63), down[i], (down[i] >> 1) | (down[i + 1] << 63),           \
+                      result);                                                                                      \
+            GENERATIONS_STEP(uint64_t, SCALAR_AND, SCALAR_OR, SCALAR_XOR, SCALAR_ANDNOT, SCALAR_ONES,               \
+                             SCALAR_LOAD, SCALAR_STORE, STATES, args, i, row[i], result, changed);                 \
+        }                                                                                                           \
+        return changed;                                                                                             \
+    }
+
+SPECIALIZED_GENERATIONS_RULES(DEFINE_SCALAR_GENERATIONS_KERNEL)
+DEFINE_SCALAR_GENERATIONS_KERNEL(generic, BS_OUTPUT, args->life.birth, args->life.survival, args->states)
+
+#ifdef LIFE_KERNEL_X86
+
+#define SSE2_WEST(p) _mm_or_si128(_mm_slli_epi64(_mm_loadu_si128((const __m128i *)(p)), 1), \
+                                  _mm_srli_epi64(_mm_loadu_si128((const __m128i *)((p) - 1)), 63))
+#define SSE2_EAST(p) _mm_or_si128(_mm_srli_epi64(_mm_loadu_si128((const __m128i *)(p)), 1), \
+                                  _mm_slli_epi64(_mm_loadu_si128((const __m128i *)((p) + 1)), 63))
+#define SSE2_LOAD(p) _mm_loadu_si128((const __m128i *)(p))
+#define SSE2_ONES _mm_set1_epi64x(-1)
+#define SSE2_STORE(p, v) _mm_storeu_si128((__m128i *)(p), (v))
+
+#define DEFINE_SSE2_KERNEL(name, OUTPUT, BIRTH, SURVIVAL)                                                \
+    static uint64_t step_interior_sse2_##name(const Life_Row_Args *args, int word_begin, int word_end) { \
+        __m128i changed = _mm_setzero_si128();                                                          \
+        int i = word_begin;                                                                             \
+        for (; i + 2 <= word_end; i += 2) {                                                             \
+            __m128i result;                                                                             \
+            LIFE_STEP(__m128i, _mm_and_si128, _mm_or_si128, _mm_xor_si128, _mm_andnot_si128, SSE2_ONES, \
+                      OUTPUT, BIRTH, SURVIVAL,                                                          \
+                      SSE2_WEST(args->up + i), SSE2_LOAD(args->up + i), SSE2_EAST(args->up + i),        \
+                      SSE2_WEST(args->row + i), SSE2_LOAD(args->row + i), SSE2_EAST(args->row + i),     \
+                      SSE2_WEST(args->down + i), SSE2_LOAD(args->down + i), SSE2_EAST(args->down + i),  \
+                      result);                                                                          \
+            _mm_storeu_si128((__m128i *)(args->out + i), result);                                       \
+            changed = _mm_or_si128(changed, _mm_xor_si128(result, SSE2_LOAD(args->row + i)));           \
+        }                                                                                               \
+        uint64_t lanes[2];                                                                              \
+        _mm_storeu_si128((__m128i *)lanes, changed);                                                    \
+        return lanes[0] | lanes[1] | step_interior_scalar_##name(args, i, word_end);                    \
+    }
+
+SPECIALIZED_LIFE_RULES(DEFINE_SSE2_KERNEL)
+DEFINE_SSE2_KERNEL(generic, BS_OUTPUT, args->birth, args->survival)
+
+#define SSE2_WORDS_WEST(args, r, k) _mm_or_si128(_mm_slli_epi64(SSE2_LOAD((args)->center[r] + (k)), 1), \
+                                                 _mm_srli_epi64(SSE2_LOAD((args)->west[r] + (k)), 63))
+#define SSE2_WORDS_EAST(args, r, k) _mm_or_si128(_mm_srli_epi64(SSE2_LOAD((args)->center[r] + (k)), 1), \
+                                                 _mm_slli_epi64(SSE2_LOAD((args)->east[r] + (k)), 63))
+
+#define DEFINE_SSE2_WORDS_KERNEL(name, OUTPUT, BIRTH, SURVIVAL)                                                 \
+    static uint64_t step_words_sse2_##name(const Life_Words_Args *args, int begin, int end) {                  \
+        __m128i changed = _mm_setzero_si128();                                                                 \
+        int k = begin;                                                                                         \
+        for (; k + 2 <= end; k += 2) {                                                                         \
+            __m128i result;                                                                                    \
+            LIFE_STEP(__m128i, _mm_and_si128, _mm_or_si128, _mm_xor_si128, _mm_andnot_si128, SSE2_ONES,        \
+                      OUTPUT, BIRTH, SURVIVAL,                                                                 \
+                      SSE2_WORDS_WEST(args, 0, k), SSE2_LOAD(args->center[0] + k), SSE2_WORDS_EAST(args, 0, k), \
+                      SSE2_WORDS_WEST(args, 1, k), SSE2_LOAD(args->center[1] + k), SSE2_WORDS_EAST(args, 1, k), \
+                      SSE2_WORDS_WEST(args, 2, k), SSE2_LOAD(args->center[2] + k), SSE2_WORDS_EAST(args, 2, k), \
+                      result);                                                                                 \
+            _mm_storeu_si128((__m128i *)(args->out + k), result);                                              \
+            changed = _mm_or_si128(changed, _mm_xor_si128(result, SSE2_LOAD(args->center[1] + k)));            \
+        }                                                                                                      \
+        uint64_t lanes[2];                                                                                     \
+        _mm_storeu_si128((__m128i *)lanes, changed);                                                           \
+        return lanes[0] | lanes[1] | step_words_scalar_##name(args, k, end);                                   \
+    }
+
+SPECIALIZED_LIFE_RULES(DEFINE_SSE2_WORDS_KERNEL)
+DEFINE_SSE2_WORDS_KERNEL(generic, BS_OUTPUT, args->birth, args->survival)
+
+#define DEFINE_SSE2_GENERATIONS_KERNEL(name, OUTPUT, BIRTH, SURVIVAL, STATES)                                         \
+    static uint64_t step_generations_sse2_##name(const Generations_Row_Args *args, int word_begin, int word_end) {  \
+        const Life_Row_Args *life = &args->life;                                                                  \
+        __m128i changed = _mm_setzero_si128();                                                                    \
+        int i = word_begin;                                                                                       \
+        for (; i + 2 <= word_end; i += 2) {                                                                       \
+            __m128i result;                                                                                       \
+            LIFE_STEP(__m128i, _mm_and_si128, _mm_or_si128, _mm_xor_si128, _mm_andnot_si128, SSE2_ONES,           \
+                      OUTPUT, BIRTH, SURVIVAL,                                                                    \
+                      SSE2_WEST(life->up + i), SSE2_LOAD(life->up + i), SSE2_EAST(life->up + i),                  \
+                      SSE2_WEST(life->row + i), SSE2_LOAD(life->row + i), SSE2_EAST(life->row + i),               \
+                      SSE2_WEST(life->down + i), SSE2_LOAD(life->down + i), SSE2_EAST(life->down + i),            \
+                      result);                                                                                    \
+            GENERATIONS_STEP(__m128i, _mm_and_si128, _mm_or_si128, _mm_xor_si128, _mm_andnot_si128, SSE2_ONES,    \
+                             SSE2_LOAD, SSE2_STORE, STATES, args, i, SSE2_LOAD(life->row + i), result, changed);  \
+        }                                                                                                         \
+        uint64_t lanes[2];                                                                                        \
+        _mm_storeu_si128((__m128i *)lanes, changed);                                                              \
+        return lanes[0] | lanes[1] | step_generations_scalar_##name(args, i, word_end);                           \
+    }
+
+SPECIALIZED_GENERATIONS_RULES(DEFINE_SSE2_GENERATIONS_KERNEL)
+DEFINE_SSE2_GENERATIONS_KERNEL(generic, BS_OUTPUT, args->life.birth, args->life.survival, args->states)
+
+#define AVX2_WEST(p) _mm256_or_si256(_mm256_slli_epi64(_mm256_loadu_si256((const __m256i *)(p)), 1), \
+                                     _mm256_srli_epi64(_mm256_loadu_si256((const __m256i *)((p) - 1)), 63))
+#define AVX2_EAST(p) _mm256_or_si256(_mm256_srli_epi64(_mm256_loadu_si256((const __m256i *)(p)), 1), \
+                                     _mm256_slli_epi64(_mm256_loadu_si256((const __m256i *)((p) + 1)), 63))
+#define AVX2_LOAD(p) _mm256_loadu_si256((const __m256i *)(p))
+#define AVX2_ONES _mm256_set1_epi64x(-1)
+#define AVX2_STORE(p, v) _mm256_storeu_si256((__m256i *)(p), (v))
+
+// The compiler doesn't clear the upper halves at the end, and any SSE code run
+// next (the scalar tail, the caller) would pay a transition stall.
+#define DEFINE_AVX2_KERNEL(name, OUTPUT, BIRTH, SURVIVAL)                                                 \
+    __attribute__((target("avx2")))                                                                       \
+    static uint64_t step_interior_avx2_##name(const Life_Row_Args *args, int word_begin, int word_end) {  \
+        __m256i changed = _mm256_setzero_si256();                                                        \
+        int i = word_begin;                                                                              \
+        for (; i + 4 <= word_end; i += 4) {                                                              \
+            __m256i result;                                                                              \
+            LIFE_STEP(__m256i, _mm256_and_si256, _mm256_or_si256, _mm256_xor_si256, _mm256_andnot_si256, \
+                      AVX2_ONES, OUTPUT, BIRTH, SURVIVAL,                                                \
+                      AVX2_WEST(args->up + i), AVX2_LOAD(args->up + i), AVX2_EAST(args->up + i),         \
+                      AVX2_WEST(args->row + i), AVX2_LOAD(args->row + i), AVX2_EAST(args->row + i),      \
+                      AVX2_WEST(args->down + i), AVX2_LOAD(args->down + i), AVX2_EAST(args->down + i),   \
+                      result);                                                                           \
+            _mm256_storeu_si256((__m256i *)(args->out + i), result);                                     \
+            changed = _mm256_or_si256(changed, _mm256_xor_si256(result, AVX2_LOAD(args->row + i)));      \
+        }                                                                                                \
+        uint64_t lanes[4];                                                                               \
+        _mm256_storeu_si256((__m256i *)lanes, changed);                                                  \
+        _mm256_zeroupper();                                                                              \
+        return lanes[0] | lanes[1] | lanes[2] | lanes[3] | step_interior_scalar_##name(args, i, word_end); \
+    }
+
+SPECIALIZED_LIFE_RULES(DEFINE_AVX2_KERNEL)
+DEFINE_AVX2_KERNEL(generic, BS_OUTPUT, args->birth, args->survival)
+
+#define AVX2_WORDS_WEST(args, r, k) _mm256_or_si256(_mm256_slli_epi64(AVX2_LOAD((args)->center[r] + (k)), 1), \
+                                                    _mm256_srli_epi64(AVX2_LOAD((args)->west[r] + (k)), 63))
+#define AVX2_WORDS_EAST(args, r, k) _mm256_or_si256(_mm256_srli_epi64(AVX2_LOAD((args)->center[r] + (k)), 1), \
+                                                    _mm256_slli_epi64(AVX2_LOAD((args)->east[r] + (k)), 63))
+
+#define DEFINE_AVX2_WORDS_KERNEL(name, OUTPUT, BIRTH, SURVIVAL)                                                  \
+    __attribute__((target("avx2")))                                                                             \
+    static uint64_t step_words_avx2_##name(const Life_Words_Args *args, int begin, int end) {                   \
+        __m256i changed = _mm256_setzero_si256();                                                               \
+        int k = begin;                                                                                          \
+        for (; k + 4 <= end; k += 4) {                                                                          \
+            __m256i result;                                                                                     \
+            LIFE_STEP(__m256i, _mm256_and_si256, _mm256_or_si256, _mm256_xor_si256, _mm256_andnot_si256,        \
+                      AVX2_ONES, OUTPUT, BIRTH, SURVIVAL,                                                       \
+                      AVX2_WORDS_WEST(args, 0, k), AVX2_LOAD(args->center[0] + k), AVX2_WORDS_EAST(args, 0, k), \
+                      AVX2_WORDS_WEST(args, 1, k), AVX2_LOAD(args->center[1] + k), AVX2_WORDS_EAST(args, 1, k), \
+                      AVX2_WORDS_WEST(args, 2, k), AVX2_LOAD(args->center[2] + k), AVX2_WORDS_EAST(args, 2, k), \
+                      result);                                                                                  \
+            _mm256_storeu_si256((__m256i *)(args->out + k), result);                                            \
+            changed = _mm256_or_si256(changed, _mm256_xor_si256(result, AVX2_LOAD(args->center[1] + k)));       \
+        }                                                                                                       \
+        uint64_t lanes[4];                                                                                      \
+        _mm256_storeu_si256((__m256i *)lanes, changed);                                                         \
+        _mm256_zeroupper();                                                                                     \
+        return lanes[0] | lanes[1] | lanes[2] | lanes[3] | step_words_scalar_##name(args, k, end);              \
+    }
+
+SPECIALIZED_LIFE_RULES(DEFINE_AVX2_WORDS_KERNEL)
+DEFINE_AVX2_WORDS_KERNEL(generic, BS_OUTPUT, args->birth, args->survival)
+
+#define DEFINE_AVX2_GENERATIONS_KERNEL(name, OUTPUT, BIRTH, SURVIVAL, STATES)                                          \
+    __attribute__((target("avx2")))                                                                                   \
+    static uint64_t step_generations_avx2_##name(const Generations_Row_Args *args, int word_begin, int word_end) {    \
+        const Life_Row_Args *life = &args->life;                                                                    \
+        __m256i changed = _mm256_setzero_si256();                                                                   \
+        int i = word_begin;                                                                                         \
+        for (; i + 4 <= word_end; i += 4) {                                                                         \
+            __m256i result;                                                                                         \
+            LIFE_STEP(__m256i, _mm256_and_si256, _mm256_or_si256, _mm256_xor_si256, _mm256_andnot_si256,            \
+                      AVX2_ONES, OUTPUT, BIRTH, SURVIVAL,                                                           \
+                      AVX2_WEST(life->up + i), AVX2_LOAD(life->up + i), AVX2_EAST(life->up + i),                    \
+                      AVX2_WEST(life->row + i), AVX2_LOAD(life->row + i), AVX2_EAST(life->row + i),                 \
+                      AVX2_WEST(life->down + i), AVX2_LOAD(life->down + i), AVX2_EAST(life->down + i),              \
+                      result);                                                                                      \
+            GENERATIONS_STEP(__m256i, _mm256_and_si256, _mm256_or_si256, _mm256_xor_si256, _mm256_andnot_si256,     \
+                             AVX2_ONES, AVX2_LOAD, AVX2_STORE, STATES, args, i, AVX2_LOAD(life->row + i),           \
+                             result, changed);                                                                      \
+        }                                                                                                           \
+        uint64_t lanes[4];                                                                                          \
+        _mm256_storeu_si256((__m256i *)lanes, changed);                                                             \
+        _mm256_zeroupper();                                                                                         \
+        return lanes[0] | lanes[1] | lanes[2] | lanes[3] | step_generations_scalar_##name(args, i, word_end);       \
+    }
+
+SPECIALIZED_GENERATIONS_RULES(DEFINE_AVX2_GENERATIONS_KERNEL)
+DEFINE_AVX2_GENERATIONS_KERNEL(generic, BS_OUTPUT, args->life.birth, args->life.survival, args->states)
+
+#define KERNELS_FOR(name) { step_interior_scalar_##name, step_interior_sse2_##name, step_interior_avx2_##name }
+#define WORDS_KERNELS_FOR(name) { step_words_scalar_##name, step_words_sse2_##name, step_words_avx2_##name }
+#define GENERATIONS_KERNELS_FOR(name) \
+    { step_generations_scalar_##name, step_generations_sse2_##name, step_generations_avx2_##name }
+
+#else
+
+#define KERNELS_FOR(name) { step_interior_scalar_##name, NULL, NULL }
+#define WORDS_KERNELS_FOR(name) { step_words_scalar_##name, NULL, NULL }
+#define GENERATIONS_KERNELS_FOR(name) { step_generations_scalar_##name, NULL, NULL }
+
+#endif
+
+typedef struct {
+    const char *name;
+    uint16_t birth;
+    uint16_t survival;
+    Interior_Kernel kernels[LIFE_ISA_COUNT];
+    Words_Kernel words_kernels[LIFE_ISA_COUNT];
+} Kernel_Table_Entry;
+
+#define KERNEL_TABLE_ENTRY(name, OUTPUT, BIRTH, SURVIVAL) \
+    { #name, BIRTH, SURVIVAL, KERNELS_FOR(name), WORDS_KERNELS_FOR(name) },
+
+static const Kernel_Table_Entry g_specialized_kernels[] = {
+    SPECIALIZED_LIFE_RULES(KERNEL_TABLE_ENTRY)
+};
+
+static const Kernel_Table_Entry g_generic_kernel = { "generic", 0, 0, KERNELS_FOR(generic),
+                                                WORDS_KERNELS_FOR(generic) };
+
+enum { SPECIALIZED_KERNEL_COUNT = sizeof(g_specialized_kernels) / sizeof(g_specialized_kernels[0]) };
+
+typedef struct {
+    const char *name;
+    uint16_t birth;
+    uint16_t survival;
+    int states;
+    Generations_Interior_Kernel kernels[LIFE_ISA_COUNT];
+} Generations_Table_Entry;
+
+#define GENERATIONS_TABLE_ENTRY(name, OUTPUT, BIRTH, SURVIVAL, STATES) \
+    { #name, BIRTH, SURVIVAL, STATES, GENERATIONS_KERNELS_FOR(name) },
+
+static const Generations_Table_Entry g_specialized_generations_kernels[] = {
+    SPECIALIZED_GENERATIONS_RULES(GENERATIONS_TABLE_ENTRY)
+};
+
+static const Generations_Table_Entry g_generic_generations_kernel = { "generic", 0, 0, 0,
+                                                                      GENERATIONS_KERNELS_FOR(generic) };
+
+enum {
+    SPECIALIZED_GENERATIONS_KERNEL_COUNT =
+        sizeof(g_specialized_generations_kernels) / sizeof(g_specialized_generations_kernels[0])
+};
+
+void init_life_kernel() {
+    if (g_isa >= 0) {
+        return;
+    }
+#ifdef LIFE_KERNEL_X86
+    if (select_life_kernel("avx2") || select_life_kernel("sse2")) {
+        return;
+    }
+#endif
+    select_life_kernel("scalar");
+}
+
+bool select_life_kernel(const char *name) {
+    if (strcmp(name, "scalar") == 0) {
+        g_isa = LIFE_ISA_SCALAR;
+#ifdef LIFE_KERNEL_X86
+    } else if (strcmp(name, "sse2") == 0 && __builtin_cpu_supports("sse2")) {
+        g_isa = LIFE_ISA_SSE2;
+    } else if (strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2")) {
+        g_isa = LIFE_ISA_AVX2;
+#endif
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char *get_life_kernel_name() {
+    return g_isa >= 0 ? g_isa_names[g_isa] : "none";
+}
+
+Life_Kernel get_life_kernel(uint16_t birth, uint16_t survival) {
+    init_life_kernel();
+
+    const Kernel_Table_Entry *entry = &g_generic_kernel;
+    for (int i = 0; i < SPECIALIZED_KERNEL_COUNT; i++) {
+        if (g_specialized_kernels[i].birth == birth && g_specialized_kernels[i].survival == survival) {
+            entry = &g_specialized_kernels[i];
+            break;
+        }
+    }
+
+    Life_Kernel kernel;
+    kernel.birth = birth;
+    kernel.survival = survival;
+    kernel.name = entry->name;
+    kernel.interior = entry->kernels[g_isa];
+    kernel.words = entry->words_kernels[g_isa];
+    return kernel;
+}
+
+Generations_Kernel get_generations_kernel(uint16_t birth, uint16_t survival, int states) {
+    init_life_kernel();
+
+    const Generations_Table_Entry *entry = &g_generic_generations_kernel;
+    for (int i = 0; i < SPECIALIZED_GENERATIONS_KERNEL_COUNT; i++) {
+        const Generations_Table_Entry *candidate = &g_specialized_generations_kernels[i];
+        if (candidate->birth == birth && candidate->survival == survival && candidate->states == states) {
+            entry = candidate;
+            break;
+        }
+    }
+
+    Generations_Kernel kernel;
+    kernel.birth = birth;
+    kernel.survival = survival;
+    kernel.states = states;
+    kernel.plane_count = get_generations_plane_count(states);
+    kernel.name = entry->name;
+    kernel.interior = entry->kernels[g_isa];
+    return kernel;
+}
+
+bool step_life_region(const Life_Kernel *kernel, const Bit_Grid *src, Bit_Grid *dst,
+                      int y_begin, int y_end, int word_begin, int word_end) {
+    uint64_t changed = 0;
+    Life_Row_Args args = {0};
+    args.birth = kernel->birth;
+    args.survival = kernel->survival;
+    args.grid_w = src->w;
+    args.words_per_row = src->words_per_row;
+    args.tail_mask = get_bit_grid_tail_mask(src);
+
+    int last_word = src->words_per_row - 1;
+    int interior_begin = word_begin > 1 ? word_begin : 1;
+    int interior_end = word_end < last_word ? word_end : last_word;
+
+    for (int y = y_begin; y < y_end; y++) {
+        args.up = get_bit_grid_row(src, y == 0 ? src->h - 1 : y - 1);
+        args.row = get_bit_grid_row(src, y);
+        args.down = get_bit_grid_row(src, y == src->h - 1 ? 0 : y + 1);
+        args.out = get_bit_grid_row(dst, y);
+
+        if (word_begin == 0) {
+            args.out[0] = step_edge_word(&args, 0);
+            changed |= args.out[0] ^ args.row[0];
+        }
+        if (interior_begin < interior_end) {
+            changed |= kernel->interior(&args, interior_begin, interior_end);
+        }
+        if (word_end == src->words_per_row && last_word > 0) {
+            args.out[last_word] = step_edge_word(&args, last_word);
+            changed |= args.out[last_word] ^ args.row[last_word];
+        }
+    }
+
+    return changed != 0;
+}
+
+bool step_generations_region(const Generations_Kernel *kernel, const Bit_Grid *src, const Bit_Grid *src_planes,
+                             Bit_Grid *dst, Bit_Grid *dst_planes, int y_begin, int y_end,
+                             int word_begin, int word_end) {
+    uint64_t changed = 0;
+    Generations_Row_Args args = {0};
+    args.life.birth = kernel->birth;
+    args.life.survival = kernel->survival;
+    args.life.grid_w = src->w;
+    args.life.words_per_row = src->words_per_row;
+    args.life.tail_mask = get_bit_grid_tail_mask(src);
+    args.states = kernel->states;
+
+    int last_word = src->words_per_row - 1;
+    int interior_begin = word_begin > 1 ? word_begin : 1;
+    int interior_end = word_end < last_word ? word_end : last_word;
+
+    for (int y = y_begin; y < y_end; y++) {
+        args.life.up = get_bit_grid_row(src, y == 0 ? src->h - 1 : y - 1);
+        args.life.row = get_bit_grid_row(src, y);
+        args.life.down = get_bit_grid_row(src, y == src->h - 1 ? 0 : y + 1);
+        args.life.out = get_bit_grid_row(dst, y);
+        for (int p = 0; p < kernel->plane_count; p++) {
+            args.planes[p] = get_bit_grid_row(&src_planes[p], y);
+            args.plane_out[p] = get_bit_grid_row(&dst_planes[p], y);
+        }
+
+        if (word_begin == 0) {
+            changed |= step_generations_edge_word(&args, 0);
+        }
+        if (interior_begin < interior_end) {
+            changed |= kernel->interior(&args, interior_begin, interior_end);
+        }
+        if (word_end == src->words_per_row && last_word > 0) {
+            changed |= step_generations_edge_word(&args, last_word);
+        }
+    }
+
+    return changed != 0;
+}
+
+void step_life_row_unwrapped(const Life_Kernel *kernel, const uint64_t *up, const uint64_t *row,
+                             const uint64_t *down, uint64_t *out, int word_count) {
+    Life_Row_Args args = {0};
+    args.birth = kernel->birth;
+    args.survival = kernel->survival;
+    args.up = up;
+    args.row = row;
+    args.down = down;
+    args.out = out;
+    kernel->interior(&args, 0, word_count);
+}
+
+bool step_life_words(const Life_Kernel *kernel, const uint64_t *const west[3], const uint64_t *const center[3],
+                     const uint64_t *const east[3], uint64_t *out, int count) {
+    Life_Words_Args args = {0};
+    args.birth = kernel->birth;
+    args.survival = kernel->survival;
+    for (int r = 0; r < 3; r++) {
+        args.west[r] = west[r];
+        args.center[r] = center[r];
+        args.east[r] = east[r];
+    }
+    args.out = out;
+    return kernel->words(&args, 0, count) != 0;
+}
+
+bool step_life_column(const Life_Kernel *kernel, const uint64_t *west, const uint64_t *center,
+                      const uint64_t *east, uint64_t *out, int row_count) {
+    const uint64_t *const wests[3] = { west - 1, west, west + 1 };
+    const uint64_t *const centers[3] = { center - 1, center, center + 1 };
+    const uint64_t *const easts[3] = { east - 1, east, east + 1 };
+    return step_life_words(kernel, wests, centers, easts, out, row_count);
+}
@@ -0,0 +1,117 @@
+#ifndef LIFE_KERNEL_H
+#define LIFE_KERNEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bit_grid.h"
+
+// Bit-sliced stepping of Life-like (B/S) rules on packed grids. Neighbour
+// counts are summed with full-adder logic across whole words, so one pass
+// handles 64 cells (256 with AVX2). Results are bit-identical to the shader's
+// toroidal rule.
+//
+// Kernels are stamped out per rule from one macro template, so the birth and
+// survival masks are compile-time constants and each rule folds to a few
+// bitwise ops per word. Rules missing from the table in life_kernel.c get a
+// generic kernel that tests the masks at run time, which is correct but
+// several times slower.
+
+typedef struct Life_Row_Args Life_Row_Args;
+typedef struct Life_Words_Args Life_Words_Args;
+
+// A rule bound to the kernels that step it on the selected instruction set.
+typedef struct {
+    uint16_t birth;
+    uint16_t survival;
+    // The specialised kernel's rule name, or "generic".
+    const char *name;
+    uint64_t (*interior)(const Life_Row_Args *args, int word_begin, int word_end);
+    uint64_t (*words)(const Life_Words_Args *args, int begin, int end);
+} Life_Kernel;
+
+// Picks the widest instruction set the CPU supports. Safe to call more than
+// once.
+void init_life_kernel();
+// Forces a specific instruction set ("scalar", "sse2", "avx2"). Returns false
+// if the name is unknown or the CPU lacks the instructions. Kernels bound
+// earlier keep theirs.
+bool select_life_kernel(const char *name);
+const char *get_life_kernel_name();
+
+// Bit n of birth / survival: a dead cell with n live neighbours is born, a
+// live one survives.
+Life_Kernel get_life_kernel(uint16_t birth, uint16_t survival);
+
+// Steps rows [y_begin, y_end) and words [word_begin, word_end) of src into dst,
+// wrapping toroidally at the grid edges. src and dst must not alias. Returns
+// true if any cell in the region changed.
+bool step_life_region(const Life_Kernel *kernel, const Bit_Grid *src, Bit_Grid *dst,
+                      int y_begin, int y_end, int word_begin, int word_end);
+
+// Steps one row of a standalone buffer of word_count words, with no wrap.
+// Each input row must have a readable zero word just before its first and
+// after its last word. Used on scratch tiles that carry their own halo.
+void step_life_row_unwrapped(const Life_Kernel *kernel, const uint64_t *up, const uint64_t *row,
+                             const uint64_t *down, uint64_t *out, int word_count);
+
+// Steps count words whose neighbours come from separate arrays rather than
+// from the words beside them: center[0], [1] and [2] hold the words above, in
+// line with and below each output word, and west[] / east[] the words to the
+// left and right of those. Vectorises along the arrays, so layouts where
+// horizontal neighbours aren't adjacent in memory (a chunk's single column,
+// universes interleaved word by word) still step at full width. Returns true
+// if any cell changed.
+bool step_life_words(const Life_Kernel *kernel, const uint64_t *const west[3], const uint64_t *const center[3],
+                     const uint64_t *const east[3], uint64_t *out, int count);
+
+// step_life_words for a column of row_count one-word rows. west and east hold
+// each row's neighbouring words; all three arrays must be readable at index
+// -1 and row_count (the rows above and below).
+bool step_life_column(const Life_Kernel *kernel, const uint64_t *west, const uint64_t *center,
+                      const uint64_t *east, uint64_t *out, int row_count);
+
+static inline bool step_life_grid(const Life_Kernel *kernel, const Bit_Grid *src, Bit_Grid *dst) {
+    return step_life_region(kernel, src, dst, 0, src->h, 0, src->words_per_row);
+}
+
+// Generations rules (B/S/C) on packed grids. Live cells sit in one grid as
+// above; how far each dying cell has decayed is a counter bit-sliced across
+// plane_count more grids. A cell in dying state s (2..C-1) holds s - 1 in the
+// planes, and every other cell holds 0. Only live cells count as neighbours,
+// so plane words are read in place and never shifted.
+//
+// Kernels are stamped out from the same template as the Life-like ones, with
+// the state count a compile-time constant too; other rules get a generic
+// kernel.
+
+enum { MAX_GENERATIONS_PLANES = 8 };
+
+typedef struct Generations_Row_Args Generations_Row_Args;
+
+typedef struct {
+    uint16_t birth;
+    uint16_t survival;
+    int states;
+    int plane_count;
+    // The specialised kernel's rule name, or "generic".
+    const char *name;
+    uint64_t (*interior)(const Generations_Row_Args *args, int word_begin, int word_end);
+} Generations_Kernel;
+
+// Enough planes to count up to states - 1, the value at which a cell is dead
+// again.
+static inline int get_generations_plane_count(int states) {
+    return 32 - __builtin_clz((unsigned)(states - 1));
+}
+
+Generations_Kernel get_generations_kernel(uint16_t birth, uint16_t survival, int states);
+
+// step_life_region for a Generations rule: src_planes and dst_planes each
+// hold the kernel's plane_count planes. Returns true if any cell changed
+// state.
+bool step_generations_region(const Generations_Kernel *kernel, const Bit_Grid *src, const Bit_Grid *src_planes,
+                             Bit_Grid *dst, Bit_Grid *dst_planes, int y_begin, int y_end,
+                             int word_begin, int word_end);
+
+#endif
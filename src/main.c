@@ -1,82 +1,566 @@
-#include <assert.h>
-#include <stdarg.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
-#include <cglm/cglm.h>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
-#define VERT_SHADER "res/shaders/canvas.vert.glsl"
-#define FRAG_SHADER "res/shaders/grid.frag.glsl"
-#define GOL_COMPUTE_SHADER "res/shaders/game_of_life.comp.glsl"
+#include "common.h"
+#include "cycle_detector.h"
+#include "density_pyramid.h"
+#include "engine.h"
+#include "gl_engine.h"
+#include "gl_util.h"
+#include "grid_view.h"
+#include "life_kernel.h"
+#include "pattern.h"
+#include "profiler.h"
+#include "rule.h"
+#include "snapshot.h"
+#include "text_overlay.h"
 
 enum {
     SCREEN_WIDTH = 800,
     SCREEN_HEIGHT = 600,
 
-    MAX_VERT = 4096,
-    MAX_IDX = 16384,
-
-    ONE_MB = 1024 * 1024,
-
-    CANVAS_WIDTH = 200,
-    CANVAS_HEIGHT = CANVAS_WIDTH,
     GRID_WIDTH = 20,
-    GRID_HEIGHT = GRID_WIDTH
+    GRID_HEIGHT = GRID_WIDTH,
+
+    HEADLESS_GRID_WIDTH = 1024,
+    HEADLESS_GRID_HEIGHT = HEADLESS_GRID_WIDTH,
+    HEADLESS_GENERATIONS = 1000,
+
+    DEFAULT_GENERATIONS_PER_SECOND = 30,
+    READBACK_INTERVAL_MS = 250,
+    // Readbacks feed the density pyramid whenever the view isn't drawn from
+    // the GL engine's texture, so they come more often then.
+    VIEW_READBACK_INTERVAL_MS = 50,
+    SCROLL_STEPS_PER_DOUBLING = 4,
+    // A frame's batch is sized to take at most this much wall time at the
+    // engine's measured throughput (and to cover at most this much sim time);
+    // generations owed beyond that are dropped rather than stalling the window.
+    MAX_FRAME_SIM_MS = 50,
+    // The overlay averages stage timings over this window.
+    OVERLAY_PROFILE_WINDOW_MS = 1000,
+    MAX_PROFILE_STAGES = 16
 };
 
 typedef struct {
     int w, h;
     GLFWwindow *glfw_window;
+    // Left-button drags pan the view.
+    bool dragging;
+    double cursor_x, cursor_y;
 } Window_State;
 
 typedef struct {
-    uint32_t vbo;
-    uint32_t ebo;
-    uint32_t vao;
-    uint32_t render_shader;
-    uint32_t gol_compute_shader;
-    char error_msg_buffer[ONE_MB];
+    Grid_View grid_view;
+    Text_Overlay text_overlay;
+    bool show_overlay;
 } Gl_State;
 
+// The windowed simulation runs on wall-clock time, independent of the frame
+// rate: each frame steps however many generations the target rate owes, as one
+// batch, and statistics come from asynchronous readbacks. Batches are timed
+// (on the GPU for the GL engine, whose next batch waits for the last to
+// finish) so that none is given more than the engine did in MAX_FRAME_SIM_MS.
+typedef struct {
+    bool running;
+    double target_generations_per_second;
+    double owed_generations;
+    uint64_t last_frame_ns;
+    // Over the last timed batch; 0 until one completes.
+    double measured_generations_per_second;
+    // GL engine: timestamps around the batch in flight.
+    uint32_t batch_queries[2];
+    bool batch_in_flight;
+    uint64_t batch_generations;
+    uint64_t batch_submit_ns;
+
+    Bit_Grid readback_grid;
+    // Blocks of readback_grid rewritten by the last synchronous readback,
+    // which are the pyramid's base tiles.
+    uint8_t *changed_blocks;
+    Density_Pyramid pyramid;
+    uint64_t next_readback_ns;
+    // Synchronous engines are only read back after a step or seed.
+    bool state_changed;
+    uint64_t next_report_ns;
+    uint64_t reported_generation;
+    uint64_t reported_ns;
+
+    Checkpointer *checkpointer;
+    uint64_t next_checkpoint_generation;
+    // Checkpoint the first readback taken at or after save_generation.
+    bool save_pending;
+    uint64_t save_generation;
+} Sim_State;
+
 typedef struct {
+    bool headless;
+    const char *engine_name;
+    const char *kernel_name;
+    int thread_count;
+    size_t memory_limit_mb;
+    bool unbounded;
+    bool dense;
+    int temporal_block_generations;
+    int process_count;
+    // From --rule, else the snapshot's or pattern's, else B3/S23.
+    bool has_rule;
+    Rule rule;
     int grid_w;
     int grid_h;
-    uint32_t grid_tex_front;
-    uint32_t grid_tex_back;
-} Game_Of_Life_State;
+    uint64_t generations;
+    // Stop a headless run once the grid repeats within this many generations.
+    int stop_on_cycle_period;
+    bool has_seed;
+    unsigned int seed;
+    const char *load_path;
+    const char *pattern_path;
+    const char *save_path;
+    uint64_t checkpoint_every;
+    bool compress;
+    double target_generations_per_second;
+    uint64_t frame_limit;
+    const char *profile_path;
+    bool overlay;
+} Options;
+
+typedef char changed_block_size_check[CHANGED_BLOCK_SIZE == 1 << DENSITY_PYRAMID_BASE_LEVEL ? 1 : -1];
 
 static Window_State g_window_state;
 static Gl_State g_gl_state;
-static Game_Of_Life_State g_game_of_life_state;
-
-void exit_with_error(const char *msg, ...);
-void trace_log(const char *msg, ...);
-void *xmalloc(size_t size);
+static Gol_Engine *g_engine;
+static Sim_State g_sim_state;
 
 void keyboard_callback(GLFWwindow *window, int key, int scancode, int action, int mods);
 void window_size_callback(GLFWwindow *window, int width, int height);
+void scroll_callback(GLFWwindow *window, double x_offset, double y_offset);
+void mouse_button_callback(GLFWwindow *window, int button, int action, int mods);
+void cursor_pos_callback(GLFWwindow *window, double x, double y);
 
 void set_window_size(int width, int height);
-void set_ortho_projection(int width, int height);
 
-Gl_State initialize_gl_state();
-uint32_t build_shader_from_file(const char *file_path, GLenum shader_type);
-uint32_t link_vert_frag_shaders(uint32_t vert, uint32_t frag);
-uint32_t link_comp_shader(uint32_t comp);
-uint32_t build_shaders(const char *vert_file, const char *frag_file);
-uint32_t build_compute_shader(const char *file_path);
-void sub_vertex_data(float screen_width, float screen_height);
+void record_batch_time(uint64_t generations, uint64_t elapsed_ns);
+void poll_batch_time();
+void advance_simulation(uint64_t now_ns);
+void update_readback(uint64_t now_ns);
+void report_readback(uint64_t now_ns, uint64_t generation, const uint8_t *changed_blocks);
+void request_save(void);
+void refresh_readback(void);
+void update_overlay_text(uint64_t now_ns, uint64_t generation, uint64_t population, double rate);
+
+Options parse_options(int argc, char **argv);
+void print_usage(const char *program);
+const Gol_Engine_Api *require_engine_api(const char *name);
+Engine_Options get_engine_options(const Options *options);
+void seed_engine_randomly(Gol_Engine *engine);
+void seed_engine_initially(Gol_Engine *engine, const Snapshot *snapshot);
+void parse_rule_or_exit(const char *text, const char *source, Rule *rule);
+void load_pattern_snapshot(Options *options, Snapshot *snapshot);
+void save_engine_snapshot(Gol_Engine *engine, const Options *options);
+void write_profile(const char *path);
+void log_profile_summary();
+int run_headless(const Options *options, const Snapshot *snapshot);
+int run_windowed(const Options *options, const Snapshot *snapshot);
+
+int main(int argc, char **argv) {
+    Options options = parse_options(argc, argv);
+
+    if (options.has_seed) {
+        srand(options.seed);
+    }
+    if (options.profile_path || options.overlay) {
+        enable_profiler();
+    }
+    if (options.kernel_name && !select_life_kernel(options.kernel_name)) {
+        exit_with_error("Kernel '%s' is unknown or unsupported on this CPU", options.kernel_name);
+    }
+
+    Snapshot snapshot = {0};
+    if (options.load_path) {
+        if (!open_snapshot(options.load_path, &snapshot)) {
+            exit_with_error("Failed to load snapshot '%s'", options.load_path);
+        }
+        if (!options.has_rule) {
+            parse_rule_or_exit(snapshot.info.rule, "Snapshot", &options.rule);
+        }
+        options.grid_w = snapshot.info.w;
+        options.grid_h = snapshot.info.h;
+    } else if (options.pattern_path) {
+        load_pattern_snapshot(&options, &snapshot);
+    }
+    // Snapshots hold live cells only: a Generations run saved and resumed
+    // would lose its dying cells and follow a different trajectory.
+    if (options.rule.family == RULE_FAMILY_GENERATIONS && (options.save_path || options.load_path)) {
+        exit_with_error("Snapshots don't keep the dying states of %s, so --save, --checkpoint-every and "
+                        "--load can't be used with it", options.rule.name);
+    }
+
+    bool has_snapshot = options.load_path || options.pattern_path;
+    int result = options.headless
+        ? run_headless(&options, has_snapshot ? &snapshot : NULL)
+        : run_windowed(&options, has_snapshot ? &snapshot : NULL);
+
+    if (has_snapshot) {
+        close_snapshot(&snapshot);
+    }
+    return result;
+}
+
+Options parse_options(int argc, char **argv) {
+    Options options = {0};
+    options.grid_w = -1;
+    options.grid_h = -1;
+    options.generations = HEADLESS_GENERATIONS;
+    options.rule = get_conway_rule();
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (strcmp(arg, "--headless") == 0) {
+            options.headless = true;
+        } else if (strcmp(arg, "--engine") == 0 && has_value) {
+            options.engine_name = argv[++i];
+        } else if (strcmp(arg, "--size") == 0 && has_value) {
+            if (sscanf(argv[++i], "%dx%d", &options.grid_w, &options.grid_h) != 2 ||
+                options.grid_w <= 0 || options.grid_h <= 0) {
+                exit_with_error("Invalid --size '%s', expected WxH", argv[i]);
+            }
+        } else if (strcmp(arg, "--generations") == 0 && has_value) {
+            options.generations = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--stop-on-cycle") == 0 && has_value) {
+            options.stop_on_cycle_period = atoi(argv[++i]);
+            if (options.stop_on_cycle_period <= 0) {
+                exit_with_error("Invalid --stop-on-cycle '%s', expected a period of at least 1", argv[i]);
+            }
+        } else if (strcmp(arg, "--threads") == 0 && has_value) {
+            options.thread_count = atoi(argv[++i]);
+        } else if (strcmp(arg, "--memory-mb") == 0 && has_value) {
+            options.memory_limit_mb = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--unbounded") == 0) {
+            options.unbounded = true;
+        } else if (strcmp(arg, "--dense") == 0) {
+            options.dense = true;
+        } else if (strcmp(arg, "--temporal-block") == 0 && has_value) {
+            options.temporal_block_generations = atoi(argv[++i]);
+        } else if (strcmp(arg, "--processes") == 0 && has_value) {
+            options.process_count = atoi(argv[++i]);
+        } else if (strcmp(arg, "--kernel") == 0 && has_value) {
+            options.kernel_name = argv[++i];
+        } else if (strcmp(arg, "--rule") == 0 && has_value) {
+            parse_rule_or_exit(argv[++i], "Requested", &options.rule);
+            options.has_rule = true;
+        } else if (strcmp(arg, "--seed") == 0 && has_value) {
+            options.has_seed = true;
+            options.seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--load") == 0 && has_value) {
+            options.load_path = argv[++i];
+        } else if (strcmp(arg, "--pattern") == 0 && has_value) {
+            options.pattern_path = argv[++i];
+        } else if (strcmp(arg, "--save") == 0 && has_value) {
+            options.save_path = argv[++i];
+        } else if (strcmp(arg, "--checkpoint-every") == 0 && has_value) {
+            options.checkpoint_every = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--compress") == 0) {
+            options.compress = true;
+        } else if (strcmp(arg, "--gps") == 0 && has_value) {
+            options.target_generations_per_second = atof(argv[++i]);
+        } else if (strcmp(arg, "--frames") == 0 && has_value) {
+            options.frame_limit = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(arg, "--profile") == 0 && has_value) {
+            options.profile_path = argv[++i];
+        } else if (strcmp(arg, "--overlay") == 0) {
+            options.overlay = true;
+        } else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            print_usage(argv[0]);
+            exit(0);
+        } else {
+            print_usage(argv[0]);
+            exit_with_error("Unknown or incomplete argument '%s'", arg);
+        }
+    }
+
+    if (!options.engine_name) {
+        options.engine_name = options.headless ? "cpu" : "gl";
+    }
+    if (options.checkpoint_every > 0 && !options.save_path) {
+        exit_with_error("--checkpoint-every needs --save PATH");
+    }
+    if (options.load_path && options.pattern_path) {
+        exit_with_error("--load and --pattern can't be used together");
+    }
+    // With --pattern and no --size, the grid is sized to fit the pattern.
+    if (options.grid_w < 0 && !options.pattern_path) {
+        options.grid_w = options.headless ? HEADLESS_GRID_WIDTH : GRID_WIDTH;
+        options.grid_h = options.headless ? HEADLESS_GRID_HEIGHT : GRID_HEIGHT;
+    }
+
+    return options;
+}
+
+void print_usage(const char *program) {
+    char engine_names[256];
+    list_engine_names(engine_names, sizeof(engine_names));
+
+    printf("Usage: %s [options]\n", program);
+    printf("  --headless          Step without a window and report throughput\n");
+    printf("  --engine NAME       Simulation engine (%s)\n", engine_names);
+    printf("  --kernel NAME       Packed CPU kernel: scalar, sse2 or avx2 (default: best supported)\n");
+    printf("  --threads N         Worker threads for tiled CPU engines (default: one per CPU)\n");
+    printf("  --memory-mb N       Soft memory cap for caching engines (HashLife): exceeded only when the\n");
+    printf("                      live state alone doesn't fit\n");
+    printf("  --unbounded         Treat the grid as a window onto an infinite plane\n");
+    printf("  --dense             Step every tile, disabling active-tile tracking\n");
+    printf("  --temporal-block K  Advance K generations per pass over each tile\n");
+    printf("  --processes N       Worker processes for the distributed engine (default: one per CPU)\n");
+    printf("  --rule RULE         B3/S23 (default), Generations B2/S/C3 or Larger than Life R5,C0,M1,S34..58,B34..45,NM\n");
+    printf("  --size WxH          Grid size in cells\n");
+    printf("  --generations N     Generations to run in headless mode (default %d)\n", HEADLESS_GENERATIONS);
+    printf("  --stop-on-cycle P   End a headless run early once it settles into a still life or an\n");
+    printf("                      oscillator of period at most P\n");
+    printf("  --seed N            Seed for the random initial grid\n");
+    printf("  --load PATH         Start from a snapshot instead of a random grid (sets the size)\n");
+    printf("  --pattern PATH      Start from an RLE, plaintext, Life 1.06 or macrocell pattern, centred\n");
+    printf("  --save PATH         Write a snapshot when the run ends (S in the window saves one too);\n");
+    printf("                      not for Generations rules, whose dying states snapshots don't keep\n");
+    printf("  --checkpoint-every N  Also checkpoint to --save PATH every N generations, in the background\n");
+    printf("  --compress          Run-length encode snapshots\n");
+    printf("  --gps N             Start the window running at N generations per second (P pauses)\n");
+    printf("  --frames N          Close the window after N frames\n");
+    printf("  --profile PATH      Time each stage and write a Chrome trace (chrome://tracing) on exit\n");
+    printf("  --overlay           Show generations/s and ms per stage in the window (O toggles it)\n");
+    printf("In the window, drag to pan, scroll or +/- to zoom and Home to fit the grid.\n");
+}
+
+const Gol_Engine_Api *require_engine_api(const char *name) {
+    const Gol_Engine_Api *api = find_engine_api(name);
+    if (!api) {
+        char engine_names[256];
+        list_engine_names(engine_names, sizeof(engine_names));
+        exit_with_error("Unknown engine '%s' (available: %s)", name, engine_names);
+    }
+    return api;
+}
+
+Engine_Options get_engine_options(const Options *options) {
+    Engine_Options engine_options = {0};
+    engine_options.thread_count = options->thread_count;
+    engine_options.memory_limit_mb = options->memory_limit_mb;
+    engine_options.unbounded = options->unbounded;
+    engine_options.dense = options->dense;
+    engine_options.temporal_block_generations = options->temporal_block_generations;
+    engine_options.process_count = options->process_count;
+    engine_options.rule = &options->rule;
+    return engine_options;
+}
 
-void create_compute_textures();
-void seed_gol_texture();
-void run_gol_compute_procedure();
+void seed_engine_randomly(Gol_Engine *engine) {
+    Bit_Grid grid = create_bit_grid(engine->grid_w, engine->grid_h);
+    fill_random_bit_grid(&grid);
+    seed_engine(engine, &grid);
+    free_bit_grid(&grid);
+}
+
+void seed_engine_initially(Gol_Engine *engine, const Snapshot *snapshot) {
+    if (!snapshot) {
+        seed_engine_randomly(engine);
+        return;
+    }
+    seed_engine(engine, &snapshot->grid);
+    engine->generation = snapshot->info.generation;
+}
+
+void parse_rule_or_exit(const char *text, const char *source, Rule *rule) {
+    if (!parse_rule(text, rule)) {
+        exit_with_error("%s rule '%s' is not supported", source, text);
+    }
+}
+
+// Decodes the pattern into an unmapped snapshot at generation 0, so it seeds
+// engines the same way a loaded snapshot does.
+void load_pattern_snapshot(Options *options, Snapshot *snapshot) {
+    Pattern_Info info;
+    if (!read_pattern_info(options->pattern_path, &info)) {
+        exit_with_error("Failed to read pattern '%s'", options->pattern_path);
+    }
+    if (!options->has_rule) {
+        parse_rule_or_exit(info.rule, "Pattern", &options->rule);
+    }
 
-int main() {
+    if (options->grid_w < 0) {
+        // Square power of two with room for the pattern to grow.
+        int64_t extent = 2 * (info.w > info.h ? info.w : info.h);
+        int64_t side = 64;
+        while (side < extent && side <= INT32_MAX / 2) {
+            side *= 2;
+        }
+        if (side < extent) {
+            exit_with_error("Pattern '%s' is too large (%lldx%lld)", options->pattern_path,
+                            (long long)info.w, (long long)info.h);
+        }
+        options->grid_w = (int)side;
+        options->grid_h = (int)side;
+    }
+
+    snapshot->grid = create_bit_grid(options->grid_w, options->grid_h);
+    if (!load_pattern(options->pattern_path, &snapshot->grid, &info)) {
+        exit_with_error("Failed to load pattern '%s'", options->pattern_path);
+    }
+    snapshot->info.w = options->grid_w;
+    snapshot->info.h = options->grid_h;
+    snprintf(snapshot->info.rule, sizeof(snapshot->info.rule), "%.*s",
+             (int)sizeof(snapshot->info.rule) - 1, options->rule.name);
+    trace_log("Loaded %s pattern '%s' (%lldx%lld) into a %dx%d grid", get_pattern_format_name(info.format),
+              options->pattern_path, (long long)info.w, (long long)info.h, options->grid_w, options->grid_h);
+}
+
+void save_engine_snapshot(Gol_Engine *engine, const Options *options) {
+    Bit_Grid grid = create_bit_grid(engine->grid_w, engine->grid_h);
+    read_engine_grid(engine, &grid);
+    if (save_snapshot(options->save_path, &grid, engine->generation, options->rule.name,
+                      options->compress ? SNAPSHOT_ENCODING_RLE : SNAPSHOT_ENCODING_RAW)) {
+        trace_log("Saved generation %llu to %s", (unsigned long long)engine->generation, options->save_path);
+    }
+    free_bit_grid(&grid);
+}
+
+void write_profile(const char *path) {
+    // GPU zones still in flight would be missing from the trace.
+    collect_gpu_profile_zones(true);
+    if (write_chrome_trace(path)) {
+        trace_log("Wrote the profile to %s", path);
+    } else {
+        trace_log("Failed to write the profile to %s", path);
+    }
+}
+
+void log_profile_summary() {
+    Profile_Stage_Summary summaries[MAX_PROFILE_STAGES];
+    int count = summarize_profile(0, summaries, MAX_PROFILE_STAGES);
+    for (int i = 0; i < count; i++) {
+        const Profile_Stage_Summary *summary = &summaries[i];
+        trace_log("  %-12s %s %8llu x %.3f ms mean, %.3f ms max, %.1f ms total", summary->name,
+                  summary->gpu ? "gpu" : "cpu", (unsigned long long)summary->count,
+                  summary->total_ms / summary->count, summary->max_ms, summary->total_ms);
+    }
+}
+
+int run_headless(const Options *options, const Snapshot *snapshot) {
+    const Gol_Engine_Api *api = require_engine_api(options->engine_name);
+
+    Engine_Options engine_options = get_engine_options(options);
+    Gol_Engine *engine = create_engine(api, options->grid_w, options->grid_h, &engine_options);
+    if (!engine) {
+        exit_with_error("Failed to initialize engine '%s'", api->name);
+    }
+
+    trace_log("Headless run: engine=%s kernel=%s rule=%s grid=%dx%d generations=%llu",
+              api->name, get_life_kernel_name(), options->rule.name, engine->grid_w, engine->grid_h,
+              (unsigned long long)options->generations);
+
+    seed_engine_initially(engine, snapshot);
+
+    Checkpointer *checkpointer = NULL;
+    if (options->checkpoint_every > 0) {
+        checkpointer = create_checkpointer(options->save_path, engine->grid_w, engine->grid_h, options->rule.name,
+                                           options->compress ? SNAPSHOT_ENCODING_RLE : SNAPSHOT_ENCODING_RAW);
+        if (!checkpointer) {
+            exit_with_error("Failed to start checkpointing to '%s'", options->save_path);
+        }
+    }
+
+    Cycle_Detector detector = {0};
+    if (options->stop_on_cycle_period > 0) {
+        if (!can_hash_engine_state(engine)) {
+            exit_with_error("Engine '%s' can't hash the dying states of %s for --stop-on-cycle",
+                            api->name, options->rule.name);
+        }
+        detector = create_cycle_detector(options->stop_on_cycle_period);
+        record_cycle_state(&detector, engine->generation, get_engine_state_hash(engine));
+    }
+
+    uint64_t start_ns = get_time_ns();
+    uint64_t stepped = 0;
+    uint64_t next_checkpoint = checkpointer ? options->checkpoint_every : UINT64_MAX;
+    uint64_t period = 0;
+    while (stepped < options->generations && period == 0) {
+        // Cycle detection needs every generation's state; otherwise step up to
+        // the next checkpoint at once.
+        uint64_t chunk = options->generations - stepped;
+        if (detector.capacity > 0) {
+            chunk = 1;
+        } else if (next_checkpoint - stepped < chunk) {
+            chunk = next_checkpoint - stepped;
+        }
+        step_engine(engine, chunk);
+        stepped += chunk;
+
+        if (stepped == next_checkpoint && stepped < options->generations) {
+            next_checkpoint += options->checkpoint_every;
+            if (!request_checkpoint(checkpointer, engine)) {
+                trace_log("Skipped the checkpoint at generation %llu: the previous one is still being written",
+                          (unsigned long long)engine->generation);
+            }
+        }
+        if (detector.capacity > 0) {
+            period = record_cycle_state(&detector, engine->generation, get_engine_state_hash(engine));
+        }
+    }
+    // Asynchronous engines (GL, distributed) may still be working through
+    // the queued steps.
+    finish_engine(engine);
+    uint64_t elapsed_ns = get_time_ns() - start_ns;
+
+    destroy_checkpointer(checkpointer);
+
+    uint64_t population = get_engine_population(engine);
+
+    double seconds = (double)elapsed_ns / 1e9;
+    double cell_updates = (double)engine->grid_w * engine->grid_h * (double)stepped;
+    trace_log("Generation %llu: population %llu",
+              (unsigned long long)engine->generation, (unsigned long long)population);
+    if (period == 1) {
+        trace_log("Stable since generation %llu", (unsigned long long)(engine->generation - 1));
+    } else if (period > 1) {
+        trace_log("Period %llu since generation %llu", (unsigned long long)period,
+                  (unsigned long long)(engine->generation - period));
+    }
+    free_cycle_detector(&detector);
+    trace_log("Elapsed %.3f s, %.1f generations/s, %.3e cell-updates/s",
+              seconds,
+              seconds > 0.0 ? (double)stepped / seconds : 0.0,
+              seconds > 0.0 ? cell_updates / seconds : 0.0);
+
+    Engine_Stats stats;
+    if (get_engine_stats(engine, &stats) && stats.generations > 0) {
+        trace_log("Active tiles: %llu of %llu in the last generation, %.1f%% on average",
+                  (unsigned long long)stats.active_tiles, (unsigned long long)stats.total_tiles,
+                  100.0 * (double)stats.active_tile_steps / ((double)stats.total_tiles * stats.generations));
+    }
+
+    if (options->save_path) {
+        save_engine_snapshot(engine, options);
+    }
+
+    if (options->profile_path) {
+        write_profile(options->profile_path);
+        trace_log("Stage timings:");
+        log_profile_summary();
+    }
+    destroy_gpu_profiler();
+
+    destroy_engine(engine);
+    return 0;
+}
+
+int run_windowed(const Options *options, const Snapshot *snapshot) {
     if (!glfwInit()) {
         exit_with_error("Failed to initialize GLFW");
     }
@@ -94,6 +578,9 @@ int main() {
 
     glfwSetKeyCallback(g_window_state.glfw_window, keyboard_callback);
     glfwSetWindowSizeCallback(g_window_state.glfw_window, window_size_callback);
+    glfwSetScrollCallback(g_window_state.glfw_window, scroll_callback);
+    glfwSetMouseButtonCallback(g_window_state.glfw_window, mouse_button_callback);
+    glfwSetCursorPosCallback(g_window_state.glfw_window, cursor_pos_callback);
 
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
         exit_with_error("Fail to load GL function pointers");
@@ -105,323 +592,350 @@ int main() {
     trace_log("  Vendor:   %s", glGetString(GL_VENDOR));
     trace_log("  Renderer: %s", glGetString(GL_RENDERER));
 
-    g_gl_state = initialize_gl_state();
-
+    // Any engine can drive the window: the view draws from readbacks of its
+    // state, and only samples the GL engine's texture directly.
+    const Gol_Engine_Api *api = require_engine_api(options->engine_name);
+    Engine_Options engine_options = get_engine_options(options);
+    g_engine = create_engine(api, options->grid_w, options->grid_h, &engine_options);
+    if (!g_engine) {
+        exit_with_error("Failed to initialize engine '%s'", api->name);
+    }
+    seed_engine_initially(g_engine, snapshot);
+
+    g_sim_state.pyramid = create_density_pyramid(g_engine->grid_w, g_engine->grid_h);
+    g_gl_state.grid_view = create_grid_view(g_engine->grid_w, g_engine->grid_h,
+                                            get_density_pyramid_top_level(&g_sim_state.pyramid),
+                                            SCREEN_WIDTH, SCREEN_HEIGHT);
+    g_gl_state.text_overlay = create_text_overlay();
+    g_gl_state.show_overlay = options->overlay;
     set_window_size(SCREEN_WIDTH, SCREEN_HEIGHT);
 
-    sub_vertex_data((float)CANVAS_WIDTH, (float)CANVAS_HEIGHT);
-
-    glUseProgram(g_gl_state.render_shader);
-    glUniform1f(glGetUniformLocation(g_gl_state.render_shader, "canvas_w"), (float)CANVAS_WIDTH);
-    glUniform1f(glGetUniformLocation(g_gl_state.render_shader, "canvas_h"), (float)CANVAS_HEIGHT);
-    glUseProgram(0);
-
-    g_game_of_life_state.grid_w = GRID_WIDTH;
-    g_game_of_life_state.grid_h = GRID_HEIGHT;
-
-    glUseProgram(g_gl_state.gol_compute_shader);
-    glUniform2i(glGetUniformLocation(g_gl_state.gol_compute_shader, "grid_size"),
-                g_game_of_life_state.grid_w, g_game_of_life_state.grid_h);
-    glUseProgram(0);
-
-    create_compute_textures();
-    seed_gol_texture();
+    g_sim_state.running = options->target_generations_per_second > 0.0;
+    g_sim_state.target_generations_per_second = g_sim_state.running
+        ? options->target_generations_per_second : DEFAULT_GENERATIONS_PER_SECOND;
+    g_sim_state.last_frame_ns = get_time_ns();
+    glGenQueries(2, g_sim_state.batch_queries);
+    g_sim_state.reported_ns = g_sim_state.last_frame_ns;
+    g_sim_state.reported_generation = g_engine->generation;
+    g_sim_state.readback_grid = create_bit_grid(g_engine->grid_w, g_engine->grid_h);
+    g_sim_state.changed_blocks = xmalloc(get_changed_block_count(g_engine->grid_w, g_engine->grid_h));
+    g_sim_state.state_changed = true;
+    if (options->save_path) {
+        g_sim_state.checkpointer = create_checkpointer(options->save_path, g_engine->grid_w, g_engine->grid_h,
+                                                       options->rule.name,
+                                                       options->compress ? SNAPSHOT_ENCODING_RLE : SNAPSHOT_ENCODING_RAW);
+        if (!g_sim_state.checkpointer) {
+            exit_with_error("Failed to start checkpointing to '%s'", options->save_path);
+        }
+    }
+    g_sim_state.next_checkpoint_generation = options->checkpoint_every > 0
+        ? g_engine->generation + options->checkpoint_every : UINT64_MAX;
 
+    glfwSwapInterval(1);
     glClearColor(0.09f, 0.07f, 0.07f, 1.0f);
 
     trace_log("Entering main loop...");
 
+    uint64_t frame_count = 0;
     while (!glfwWindowShouldClose(g_window_state.glfw_window)) {
+        uint64_t now_ns = get_time_ns();
+        Profile_Zone simulate_zone = begin_profile_zone("simulate");
+        advance_simulation(now_ns);
+        end_profile_zone(simulate_zone);
+        if (g_engine->generation >= g_sim_state.next_checkpoint_generation) {
+            request_save();
+            g_sim_state.next_checkpoint_generation = g_engine->generation + options->checkpoint_every;
+        }
+        Profile_Zone readback_zone = begin_profile_zone("readback");
+        update_readback(now_ns);
+        end_profile_zone(readback_zone);
+
+        Profile_Zone render_zone = begin_profile_zone("render");
+        begin_gpu_profile_zone("gl_render");
         glClear(GL_COLOR_BUFFER_BIT);
+        draw_grid_view(&g_gl_state.grid_view, &g_sim_state.pyramid, &g_sim_state.readback_grid,
+                       g_engine->api == &g_gl_engine_api ? gl_engine_front_texture(g_engine) : 0);
+        end_gpu_profile_zone();
 
-        glUseProgram(g_gl_state.render_shader);
-        glBindVertexArray(g_gl_state.vao);
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-        glUseProgram(0);
+        if (g_gl_state.show_overlay) {
+            draw_text_overlay(&g_gl_state.text_overlay, g_window_state.w, g_window_state.h);
+        }
+        end_profile_zone(render_zone);
 
+        Profile_Zone swap_zone = begin_profile_zone("swap");
         glfwSwapBuffers(g_window_state.glfw_window);
+        end_profile_zone(swap_zone);
         glfwPollEvents();
+        collect_gpu_profile_zones(false);
+
+        if (options->frame_limit > 0 && ++frame_count >= options->frame_limit) {
+            glfwSetWindowShouldClose(g_window_state.glfw_window, true);
+        }
+    }
+
+    trace_log("Exiting gracefully at generation %llu...", (unsigned long long)g_engine->generation);
+
+    destroy_checkpointer(g_sim_state.checkpointer);
+    if (options->save_path) {
+        save_engine_snapshot(g_engine, options);
     }
+    free_bit_grid(&g_sim_state.readback_grid);
+    free(g_sim_state.changed_blocks);
+    free_density_pyramid(&g_sim_state.pyramid);
+    glDeleteQueries(2, g_sim_state.batch_queries);
 
-    trace_log("Exiting gracefully...");
+    if (options->profile_path) {
+        write_profile(options->profile_path);
+    }
+    destroy_gpu_profiler();
+    destroy_text_overlay(&g_gl_state.text_overlay);
+    destroy_grid_view(&g_gl_state.grid_view);
 
+    destroy_engine(g_engine);
     glfwDestroyWindow(g_window_state.glfw_window);
     glfwTerminate();
     return 0;
 }
 
-void exit_with_error(const char *msg, ...) {
-    fprintf(stderr, "FATAL: ");
-    va_list ap;
-    va_start(ap, msg);
-    vfprintf(stderr, msg, ap);
-    va_end(ap);
-    fprintf(stderr, "\n");
+void record_batch_time(uint64_t generations, uint64_t elapsed_ns) {
+    g_sim_state.measured_generations_per_second = (double)generations * 1e9 / (double)(elapsed_ns > 0 ? elapsed_ns : 1);
 }
 
-void trace_log(const char *msg, ...) {
-    printf("INFO: ");
-    va_list ap;
-    va_start(ap, msg);
-    vprintf(msg, ap);
-    va_end(ap);
-    printf("\n");
-}
-
-void *xmalloc(size_t size) {
-    void *d = malloc(size);
-    if (!d) {
-        exit_with_error("Failed to malloc");
+// Never waits: the GL engine's batch is only timed once its end timestamp
+// has landed.
+void poll_batch_time() {
+    if (!g_sim_state.batch_in_flight) {
+        return;
     }
-    return d;
-}
-
-void keyboard_callback(GLFWwindow *window, int key, int scancode, int action, int mods) {
-    (void)window; (void)key; (void)scancode; (void)action; (void)mods;
-
-    if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
-        trace_log("Received ESC. Terminating...");
-        glfwSetWindowShouldClose(window, true);
-    } else if (key == GLFW_KEY_SPACE && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
-        run_gol_compute_procedure();
-    } else if (key == GLFW_KEY_ENTER && action == GLFW_PRESS) {
-        seed_gol_texture();
+    GLint available = 0;
+    glGetQueryObjectiv(g_sim_state.batch_queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+        return;
     }
+    GLuint64 begin_ns = 0;
+    GLuint64 end_ns = 0;
+    glGetQueryObjectui64v(g_sim_state.batch_queries[0], GL_QUERY_RESULT, &begin_ns);
+    glGetQueryObjectui64v(g_sim_state.batch_queries[1], GL_QUERY_RESULT, &end_ns);
+    // Drivers that run compute as it's submitted spend the time on the CPU.
+    uint64_t gpu_ns = end_ns > begin_ns ? end_ns - begin_ns : 0;
+    record_batch_time(g_sim_state.batch_generations,
+                      gpu_ns > g_sim_state.batch_submit_ns ? gpu_ns : g_sim_state.batch_submit_ns);
+    g_sim_state.batch_in_flight = false;
 }
 
-void window_size_callback(GLFWwindow *window, int width, int height) {
-    (void)window; (void)width; (void)height;
-
-    set_window_size(width, height);
-}
-
-void set_window_size(int width, int height) {
-    g_window_state.w = width;
-    g_window_state.h = height;
-
-    glViewport(0, 0, width, height);
-    set_ortho_projection(width, height);
-}
-
-void set_ortho_projection(int width, int height) {
-    mat4 projection;
-    glm_ortho(0.0f, width, height, 0.0f, -1.0f, 1.0f, projection);
-
-    glUseProgram(g_gl_state.render_shader);
-    glUniformMatrix4fv(glGetUniformLocation(g_gl_state.render_shader, "projection"), 1, GL_FALSE, (float *)projection);
-    glUseProgram(0);
-}
-
-Gl_State initialize_gl_state() {
-    Gl_State result = {0};
-
-    glGenVertexArrays(1, &result.vao);
-    glGenBuffers(1, &result.vbo);
-    glGenBuffers(1, &result.ebo);
-
-    glBindVertexArray(result.vao);
-
-    glBindBuffer(GL_ARRAY_BUFFER, result.vbo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, result.ebo);
-
-    size_t total_size = MAX_VERT * (2) * sizeof(float);
-    glBufferData(GL_ARRAY_BUFFER, total_size, NULL, GL_STREAM_DRAW);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, MAX_IDX * sizeof(uint32_t), NULL, GL_STREAM_DRAW);
-
-    // Positions -- vec2
-    size_t stride = 2 * sizeof(float);
-    size_t offset = 0;
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, (void *)offset);
-    glEnableVertexAttribArray(0);
-
-    offset += stride * MAX_VERT;
-    assert(offset == total_size);
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
-    result.render_shader = build_shaders(VERT_SHADER, FRAG_SHADER);
-    result.gol_compute_shader = build_compute_shader(GOL_COMPUTE_SHADER);
-
-    return result;
-}
-
-uint32_t build_shader_from_file(const char *file_path, GLenum shader_type) {
-    FILE *file = fopen(file_path, "r");
-    if (!file) {
-        exit_with_error("Failed to open shader file");
+void advance_simulation(uint64_t now_ns) {
+    double seconds = (double)(now_ns - g_sim_state.last_frame_ns) / 1e9;
+    g_sim_state.last_frame_ns = now_ns;
+    poll_batch_time();
+    if (!g_sim_state.running) {
+        g_sim_state.owed_generations = 0.0;
+        return;
     }
 
-    fseek(file, 0, SEEK_END);
-    size_t file_size = ftell(file);
-    rewind(file);
-
-    char *shader_src = xmalloc(file_size + 1);
-    fread(shader_src, file_size, 1, file);
-    fclose(file);
-    shader_src[file_size] = '\0';
-
-    uint32_t shader_id = glCreateShader(shader_type);
-    glShaderSource(shader_id, 1, (const char **)&shader_src, NULL);
-    glCompileShader(shader_id);
-
-    int success;
-    glGetShaderiv(shader_id, GL_COMPILE_STATUS, &success);
-
-    if (!success) {
-        glGetShaderInfoLog(shader_id, ONE_MB, NULL, g_gl_state.error_msg_buffer);
-        exit_with_error("Failed to compile shader (type 0x%04X). Error:\n  %s\nSource:\n%s\n",
-                        shader_type, g_gl_state.error_msg_buffer, shader_src);
+    // Until a batch has been timed, probe with a single generation.
+    double rate = g_sim_state.target_generations_per_second;
+    double measured = g_sim_state.measured_generations_per_second;
+    double max_owed = rate * MAX_FRAME_SIM_MS / 1000.0;
+    double max_batch = measured > 0.0 ? measured * MAX_FRAME_SIM_MS / 1000.0 : 1.0;
+    if (max_owed > max_batch) {
+        max_owed = max_batch;
+    }
+    if (max_owed < 1.0) {
+        max_owed = 1.0;
+    }
+    g_sim_state.owed_generations += seconds * rate;
+    if (g_sim_state.owed_generations > max_owed) {
+        g_sim_state.owed_generations = max_owed;
     }
 
-    free(shader_src);
-
-    return shader_id;
+    uint64_t generations = (uint64_t)g_sim_state.owed_generations;
+    if (generations == 0 || g_sim_state.batch_in_flight) {
+        return;
+    }
+    g_sim_state.owed_generations -= (double)generations;
+    uint64_t start_ns = get_time_ns();
+    if (g_engine->api == &g_gl_engine_api) {
+        glQueryCounter(g_sim_state.batch_queries[0], GL_TIMESTAMP);
+        step_engine(g_engine, generations);
+        glQueryCounter(g_sim_state.batch_queries[1], GL_TIMESTAMP);
+        g_sim_state.batch_in_flight = true;
+        g_sim_state.batch_generations = generations;
+        g_sim_state.batch_submit_ns = get_time_ns() - start_ns;
+    } else {
+        step_engine(g_engine, generations);
+        record_batch_time(generations, get_time_ns() - start_ns);
+    }
+    g_sim_state.state_changed = true;
 }
 
-uint32_t link_vert_frag_shaders(uint32_t vert, uint32_t frag) {
-    uint32_t program_id = glCreateProgram();
-    glAttachShader(program_id, vert);
-    glAttachShader(program_id, frag);
-    glLinkProgram(program_id);
-
-    int success;
-    glGetProgramiv(program_id, GL_LINK_STATUS, &success);
+// The GL engine's readbacks are polled and queued without ever waiting on the
+// GPU. Other engines step synchronously and are read straight into the
+// readback grid, at most once per interval; those that can tell what changed
+// rewrite only that, and the pyramid recounts only those blocks.
+void update_readback(uint64_t now_ns) {
+    if (g_engine->api != &g_gl_engine_api) {
+        if (g_sim_state.state_changed && now_ns >= g_sim_state.next_readback_ns) {
+            read_engine_grid_changes(g_engine, &g_sim_state.readback_grid, g_sim_state.changed_blocks);
+            g_sim_state.state_changed = false;
+            g_sim_state.next_readback_ns = now_ns + (uint64_t)VIEW_READBACK_INTERVAL_MS * 1000000;
+            report_readback(now_ns, g_engine->generation, g_sim_state.changed_blocks);
+        }
+        return;
+    }
 
-    if (!success) {
-        glGetProgramInfoLog(program_id, ONE_MB, NULL, g_gl_state.error_msg_buffer);
-        exit_with_error("Failed to link vert-frag shader program. Error:\n  %s", g_gl_state.error_msg_buffer);
+    uint64_t generation;
+    while (gl_engine_poll_readback(g_engine, &g_sim_state.readback_grid, &generation)) {
+        report_readback(now_ns, generation, NULL);
     }
 
-    return program_id;
+    int interval_ms = get_grid_view_level(&g_gl_state.grid_view) > 0
+        ? VIEW_READBACK_INTERVAL_MS : READBACK_INTERVAL_MS;
+    if (now_ns >= g_sim_state.next_readback_ns && gl_engine_request_readback(g_engine)) {
+        g_sim_state.next_readback_ns = now_ns + (uint64_t)interval_ms * 1000000;
+    }
 }
 
-uint32_t link_comp_shader(uint32_t comp) {
-    uint32_t program_id = glCreateProgram();
-    glAttachShader(program_id, comp);
-    glLinkProgram(program_id);
-
-    int success;
-    glGetProgramiv(program_id, GL_LINK_STATUS, &success);
+// changed_blocks NULL means the whole grid may have changed.
+void report_readback(uint64_t now_ns, uint64_t generation, const uint8_t *changed_blocks) {
+    Profile_Zone pyramid_zone = begin_profile_zone("pyramid");
+    update_density_pyramid(&g_sim_state.pyramid, &g_sim_state.readback_grid, changed_blocks);
+    end_profile_zone(pyramid_zone);
 
-    if (!success) {
-        glGetProgramInfoLog(program_id, ONE_MB, NULL, g_gl_state.error_msg_buffer);
-        exit_with_error("Failed to link comp shader program. Error:\n  %s", g_gl_state.error_msg_buffer);
+    if (g_sim_state.save_pending && generation >= g_sim_state.save_generation &&
+        request_checkpoint_of_grid(g_sim_state.checkpointer, &g_sim_state.readback_grid, generation)) {
+        g_sim_state.save_pending = false;
     }
 
-    return program_id;
+    // The title and overlay keep their own pace.
+    if (now_ns < g_sim_state.next_report_ns) {
+        return;
+    }
+    g_sim_state.next_report_ns = now_ns + (uint64_t)READBACK_INTERVAL_MS * 1000000;
+
+    uint64_t population = g_sim_state.pyramid.population;
+    double seconds = (double)(now_ns - g_sim_state.reported_ns) / 1e9;
+    double rate = seconds > 0.0 ? (double)(generation - g_sim_state.reported_generation) / seconds : 0.0;
+    g_sim_state.reported_generation = generation;
+    g_sim_state.reported_ns = now_ns;
+
+    char title[128];
+    snprintf(title, sizeof(title), "Game of Life - generation %llu, population %llu, %.0f gen/s%s",
+             (unsigned long long)generation, (unsigned long long)population, rate,
+             g_sim_state.running ? "" : " (paused)");
+    glfwSetWindowTitle(g_window_state.glfw_window, title);
+    if (g_gl_state.show_overlay) {
+        update_overlay_text(now_ns, generation, population, rate);
+    }
 }
 
-uint32_t build_shaders(const char *vert_file, const char *frag_file) {
-    uint32_t vert_shader = build_shader_from_file(vert_file, GL_VERTEX_SHADER);
-    uint32_t frag_shader = build_shader_from_file(frag_file, GL_FRAGMENT_SHADER);
-    uint32_t shader_program = link_vert_frag_shaders(vert_shader, frag_shader);
-    glDeleteShader(vert_shader);
-    glDeleteShader(frag_shader);
-    return shader_program;
+void update_overlay_text(uint64_t now_ns, uint64_t generation, uint64_t population, double rate) {
+    char text[1024];
+    int length = snprintf(text, sizeof(text), "generation %llu\npopulation %llu\n%.0f gen/s%s\n",
+                          (unsigned long long)generation, (unsigned long long)population, rate,
+                          g_sim_state.running ? "" : " (paused)");
+
+    uint64_t window_ns = (uint64_t)OVERLAY_PROFILE_WINDOW_MS * 1000000;
+    Profile_Stage_Summary summaries[MAX_PROFILE_STAGES];
+    int count = summarize_profile(now_ns > window_ns ? now_ns - window_ns : 0, summaries, MAX_PROFILE_STAGES);
+    for (int i = 0; i < count && length < (int)sizeof(text); i++) {
+        const Profile_Stage_Summary *summary = &summaries[i];
+        length += snprintf(text + length, sizeof(text) - length, "%-12s %s %7.3f ms\n", summary->name,
+                           summary->gpu ? "gpu" : "cpu", summary->total_ms / summary->count);
+    }
+    set_text_overlay_text(&g_gl_state.text_overlay, text);
 }
 
-uint32_t build_compute_shader(const char *file_path) {
-    uint32_t comp_shader = build_shader_from_file(file_path, GL_COMPUTE_SHADER);
-    uint32_t program = link_comp_shader(comp_shader);
-    glDeleteShader(comp_shader);
-    return program;
+void request_save(void) {
+    if (!g_sim_state.checkpointer) {
+        trace_log("Saving needs --save PATH");
+        return;
+    }
+    g_sim_state.save_pending = true;
+    g_sim_state.save_generation = g_engine->generation;
+    g_sim_state.next_readback_ns = 0;
+    g_sim_state.state_changed = true;
 }
 
-void sub_vertex_data(float screen_width, float screen_height) {
-    glBindBuffer(GL_ARRAY_BUFFER, g_gl_state.vbo);
-
-    size_t total_size = MAX_VERT * (2) * sizeof(float);
-    size_t vert_to_sub_count = 4;
-    size_t idx_to_sub_count = 6;
-    assert(vert_to_sub_count < MAX_VERT);
-    assert(idx_to_sub_count < MAX_IDX);
-    size_t stride, offset;
-
-    // Positions -- vex2
-    offset = 0;
-    stride = 2 * sizeof(float);
-    float positions[] = {
-        0.0f, 0.0f,
-        0.0f, screen_height,
-        screen_width, 0.0f,
-        screen_width, screen_height,
-    };
-    assert(sizeof(positions) == stride * vert_to_sub_count);
-    glBufferSubData(GL_ARRAY_BUFFER, offset, sizeof(positions), positions);
-
-    offset += stride * MAX_VERT;
-    assert(offset == total_size);
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_gl_state.ebo);
-
-    uint32_t indices[] = {
-        0, 1, 2,
-        2, 1, 3
-    };
-    assert(sizeof(indices) / sizeof(indices[0]) == idx_to_sub_count);
-    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, sizeof(indices), indices);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+// Forces a readback and a title update on the next frame.
+void refresh_readback(void) {
+    g_sim_state.next_readback_ns = 0;
+    g_sim_state.next_report_ns = 0;
+    g_sim_state.state_changed = true;
 }
 
-void create_compute_textures() {
-    uint32_t grid_state_texture[2];
-    glGenTextures(2, grid_state_texture);
-    for (int i = 0; i < 2; i++) {
-        glBindTexture(GL_TEXTURE_2D, grid_state_texture[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8,
-                     g_game_of_life_state.grid_w, g_game_of_life_state.grid_h,
-                     0, GL_RED, GL_UNSIGNED_BYTE, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    }
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    g_game_of_life_state.grid_tex_front = grid_state_texture[0];
-    g_game_of_life_state.grid_tex_back = grid_state_texture[1];
-}
+void keyboard_callback(GLFWwindow *window, int key, int scancode, int action, int mods) {
+    (void)window; (void)key; (void)scancode; (void)action; (void)mods;
 
-void seed_gol_texture()
-{
-    int cell_count = g_game_of_life_state.grid_w * g_game_of_life_state.grid_h;
-    uint8_t *r8grid = malloc(cell_count);
-    for (int j = 0; j < cell_count; j++) {
-        r8grid[j] = (rand() % 10 == 0) * 255;
+    Grid_View *view = &g_gl_state.grid_view;
+    if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
+        trace_log("Received ESC. Terminating...");
+        glfwSetWindowShouldClose(window, true);
+    } else if (key == GLFW_KEY_SPACE && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
+        step_engine(g_engine, 1);
+        g_sim_state.state_changed = true;
+    } else if (key == GLFW_KEY_ENTER && action == GLFW_PRESS) {
+        seed_engine_randomly(g_engine);
+        refresh_readback();
+    } else if (key == GLFW_KEY_P && action == GLFW_PRESS) {
+        g_sim_state.running = !g_sim_state.running;
+        refresh_readback();
+    } else if (key == GLFW_KEY_UP && action == GLFW_PRESS) {
+        g_sim_state.target_generations_per_second *= 2.0;
+        trace_log("Target %.0f generations/s", g_sim_state.target_generations_per_second);
+    } else if (key == GLFW_KEY_DOWN && action == GLFW_PRESS && g_sim_state.target_generations_per_second > 1.0) {
+        g_sim_state.target_generations_per_second /= 2.0;
+        trace_log("Target %.0f generations/s", g_sim_state.target_generations_per_second);
+    } else if (key == GLFW_KEY_S && action == GLFW_PRESS) {
+        request_save();
+    } else if (key == GLFW_KEY_O && action == GLFW_PRESS) {
+        // Timings start when the overlay is first shown.
+        enable_profiler();
+        g_gl_state.show_overlay = !g_gl_state.show_overlay;
+        refresh_readback();
+    } else if (key == GLFW_KEY_EQUAL && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
+        zoom_grid_view(view, 2.0, g_window_state.w / 2.0, g_window_state.h / 2.0);
+    } else if (key == GLFW_KEY_MINUS && (action == GLFW_PRESS || action == GLFW_REPEAT)) {
+        zoom_grid_view(view, 0.5, g_window_state.w / 2.0, g_window_state.h / 2.0);
+    } else if (key == GLFW_KEY_HOME && action == GLFW_PRESS) {
+        fit_grid_view(view);
     }
+}
 
-    glBindTexture(GL_TEXTURE_2D, g_game_of_life_state.grid_tex_front);
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0,
-                    g_game_of_life_state.grid_w, g_game_of_life_state.grid_h,
-                    GL_RED, GL_UNSIGNED_BYTE, r8grid);
+void scroll_callback(GLFWwindow *window, double x_offset, double y_offset) {
+    (void)window; (void)x_offset;
 
-    free(r8grid);
+    double factor = pow(2.0, y_offset / SCROLL_STEPS_PER_DOUBLING);
+    zoom_grid_view(&g_gl_state.grid_view, factor, g_window_state.cursor_x, g_window_state.cursor_y);
 }
 
-void run_gol_compute_procedure() {
+void mouse_button_callback(GLFWwindow *window, int button, int action, int mods) {
+    (void)window; (void)mods;
 
-    glBindImageTexture(0, g_game_of_life_state.grid_tex_front, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R8);
-    glBindImageTexture(1, g_game_of_life_state.grid_tex_back, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R8);
+    if (button == GLFW_MOUSE_BUTTON_LEFT) {
+        g_window_state.dragging = action == GLFW_PRESS;
+    }
+}
 
-    glUseProgram(g_gl_state.gol_compute_shader);
+void cursor_pos_callback(GLFWwindow *window, double x, double y) {
+    (void)window;
 
-    int work_groups_x = (g_game_of_life_state.grid_w + 15) / 16;
-    int work_groups_y = (g_game_of_life_state.grid_h + 15) / 16;
-    glDispatchCompute(work_groups_x, work_groups_y, 1);
+    if (g_window_state.dragging) {
+        pan_grid_view(&g_gl_state.grid_view, x - g_window_state.cursor_x, y - g_window_state.cursor_y);
+    }
+    g_window_state.cursor_x = x;
+    g_window_state.cursor_y = y;
+}
 
-    glUseProgram(0);
+void window_size_callback(GLFWwindow *window, int width, int height) {
+    (void)window; (void)width; (void)height;
 
-    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    set_window_size(width, height);
+}
 
-    uint32_t temp = g_game_of_life_state.grid_tex_front;
-    g_game_of_life_state.grid_tex_front = g_game_of_life_state.grid_tex_back;
-    g_game_of_life_state.grid_tex_back = temp;
+void set_window_size(int width, int height) {
+    g_window_state.w = width;
+    g_window_state.h = height;
 
-    glBindTexture(GL_TEXTURE_2D, g_game_of_life_state.grid_tex_front);
+    glViewport(0, 0, width, height);
+    resize_grid_view(&g_gl_state.grid_view, width, height);
 }
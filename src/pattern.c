@@ -0,0 +1,589 @@
+#include "pattern.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+
+#define DEFAULT_RULE "B3/S23"
+
+enum {
+    READ_BUFFER_SIZE = 64 * 1024,
+    MAX_LINE_SIZE = 256,
+    // Macrocell leaves are 8x8.
+    MACROCELL_LEAF_LEVEL = 3,
+    MAX_MACROCELL_LEVEL = 62
+};
+
+typedef struct {
+    FILE *file;
+    const char *path;
+    int line;
+    size_t pos;
+    size_t len;
+    unsigned char buffer[READ_BUFFER_SIZE];
+} Pattern_Reader;
+
+static Pattern_Reader *open_pattern_reader(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        trace_log("Failed to open pattern '%s': %s", path, strerror(errno));
+        return NULL;
+    }
+    Pattern_Reader *reader = xmalloc(sizeof(Pattern_Reader));
+    reader->file = file;
+    reader->path = path;
+    reader->line = 1;
+    reader->pos = 0;
+    reader->len = 0;
+    return reader;
+}
+
+static void close_pattern_reader(Pattern_Reader *reader) {
+    fclose(reader->file);
+    free(reader);
+}
+
+static void rewind_pattern_reader(Pattern_Reader *reader) {
+    rewind(reader->file);
+    reader->line = 1;
+    reader->pos = 0;
+    reader->len = 0;
+}
+
+static inline int peek_char(Pattern_Reader *reader) {
+    if (reader->pos == reader->len) {
+        reader->len = fread(reader->buffer, 1, READ_BUFFER_SIZE, reader->file);
+        reader->pos = 0;
+        if (reader->len == 0) {
+            return EOF;
+        }
+    }
+    return reader->buffer[reader->pos];
+}
+
+static inline int next_char(Pattern_Reader *reader) {
+    int c = peek_char(reader);
+    if (c != EOF) {
+        reader->pos++;
+        reader->line += c == '\n';
+    }
+    return c;
+}
+
+static void skip_line(Pattern_Reader *reader) {
+    int c;
+    do {
+        c = next_char(reader);
+    } while (c != '\n' && c != EOF);
+}
+
+// Reads one line without its terminator into line. Returns false at end of
+// file or if the line doesn't fit.
+static bool read_line(Pattern_Reader *reader, char *line, size_t line_size, bool *too_long) {
+    size_t len = 0;
+    int c = next_char(reader);
+    if (c == EOF) {
+        return false;
+    }
+    *too_long = false;
+    while (c != '\n' && c != EOF) {
+        if (c != '\r') {
+            if (len + 1 < line_size) {
+                line[len++] = (char)c;
+            } else {
+                *too_long = true;
+            }
+        }
+        c = next_char(reader);
+    }
+    line[len] = '\0';
+    return true;
+}
+
+static bool fail_pattern(const Pattern_Reader *reader, const char *problem) {
+    trace_log("Pattern '%s', line %d: %s", reader->path, reader->line, problem);
+    return false;
+}
+
+// Larger than Life rules contain commas, so only whitespace ends a rule.
+static void copy_rule(char *dst, const char *src) {
+    size_t len = strcspn(src, " \t\r\n");
+    if (len >= PATTERN_RULE_SIZE) {
+        len = PATTERN_RULE_SIZE - 1;
+    }
+    memcpy(dst, src, len);
+    dst[len] = '\0';
+}
+
+const char *get_pattern_format_name(Pattern_Format format) {
+    switch (format) {
+    case PATTERN_FORMAT_RLE: return "RLE";
+    case PATTERN_FORMAT_PLAINTEXT: return "plaintext";
+    case PATTERN_FORMAT_LIFE_106: return "Life 1.06";
+    case PATTERN_FORMAT_MACROCELL: return "macrocell";
+    }
+    return "unknown";
+}
+
+static Pattern_Format sniff_pattern_format(Pattern_Reader *reader) {
+    char line[MAX_LINE_SIZE];
+    bool too_long;
+    Pattern_Format format = PATTERN_FORMAT_PLAINTEXT;
+
+    while (read_line(reader, line, sizeof(line), &too_long)) {
+        if (strncmp(line, "[M2]", 4) == 0) {
+            format = PATTERN_FORMAT_MACROCELL;
+            break;
+        }
+        if (strncmp(line, "#Life 1.06", 10) == 0) {
+            format = PATTERN_FORMAT_LIFE_106;
+            break;
+        }
+        const char *p = line;
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+        if (*p == '#' || *p == '\0') {
+            continue;
+        }
+        format = *p == 'x' ? PATTERN_FORMAT_RLE : PATTERN_FORMAT_PLAINTEXT;
+        break;
+    }
+
+    rewind_pattern_reader(reader);
+    return format;
+}
+
+// RLE
+
+// Parses "x = m, y = n, rule = r" after skipping comment lines. Leaves the
+// reader at the start of the cell data.
+static bool read_rle_header(Pattern_Reader *reader, Pattern_Info *info) {
+    char line[MAX_LINE_SIZE];
+    bool too_long;
+    while (read_line(reader, line, sizeof(line), &too_long)) {
+        if (line[0] == '#') {
+            if (line[1] == 'r') {
+                copy_rule(info->rule, line + 2 + strspn(line + 2, " "));
+            }
+            continue;
+        }
+
+        info->x = 0;
+        info->y = 0;
+        info->w = -1;
+        info->h = -1;
+        // The rule is the last field and may contain commas itself, so it
+        // takes the rest of the line.
+        char *rule_field = strstr(line, "rule");
+        if (rule_field && strchr(rule_field, '=')) {
+            char *value = strchr(rule_field, '=') + 1;
+            copy_rule(info->rule, value + strspn(value, " \t"));
+            *rule_field = '\0';
+        }
+        for (char *field = strtok(line, ","); field; field = strtok(NULL, ",")) {
+            field += strspn(field, " \t");
+            char *value = strchr(field, '=');
+            if (!value) {
+                continue;
+            }
+            value++;
+            value += strspn(value, " \t");
+            if (field[0] == 'x') {
+                info->w = strtoll(value, NULL, 10);
+            } else if (field[0] == 'y') {
+                info->h = strtoll(value, NULL, 10);
+            }
+        }
+        if (info->w < 0 || info->h < 0) {
+            return fail_pattern(reader, "expected an RLE header 'x = <w>, y = <h>'");
+        }
+        return true;
+    }
+    return fail_pattern(reader, "missing RLE header");
+}
+
+static bool read_rle_cells(Pattern_Reader *reader, Bit_Grid *grid, int64_t offset_x, int64_t offset_y) {
+    int64_t x = 0;
+    int64_t y = 0;
+    uint64_t count = 0;
+
+    for (;;) {
+        int c = next_char(reader);
+        if (c == EOF || c == '!') {
+            return true;
+        }
+        if (c >= '0' && c <= '9') {
+            if (count > (UINT64_MAX - 9) / 10) {
+                return fail_pattern(reader, "run count overflows");
+            }
+            count = count * 10 + (uint64_t)(c - '0');
+            continue;
+        }
+        if (isspace(c)) {
+            continue;
+        }
+        if (c == '#') {
+            skip_line(reader);
+            continue;
+        }
+
+        uint64_t run = count ? count : 1;
+        count = 0;
+        if (c == '$') {
+            y += (int64_t)run;
+            x = 0;
+        } else if (c == 'b' || c == '.') {
+            x += (int64_t)run;
+        } else if (c == 'o' || c == 'A') {
+            set_bit_grid_run(grid, x + offset_x, y + offset_y, run);
+            x += (int64_t)run;
+        } else if ((c >= 'B' && c <= 'X') || (c >= 'p' && c <= 'y')) {
+            // Multi-state tags above A (B..X, or p..y plus a letter) are dying
+            // Generations cells. A Bit_Grid holds only alive/dead, so they load
+            // as dead rather than seeding extra live cells.
+            if (c >= 'p' && c <= 'y' && !isupper(next_char(reader))) {
+                return fail_pattern(reader, "malformed multi-state cell");
+            }
+            x += (int64_t)run;
+        } else {
+            return fail_pattern(reader, "unexpected character in RLE data");
+        }
+    }
+}
+
+// Plaintext: '!' comment lines, then one row per line of '.' and 'O' (or '*').
+
+static bool read_plaintext_cells(Pattern_Reader *reader, Bit_Grid *grid, int64_t offset_x, int64_t offset_y,
+                                 Pattern_Info *info) {
+    int64_t x = 0;
+    int64_t y = 0;
+    int64_t w = 0;
+    bool line_start = true;
+
+    for (;;) {
+        int c = next_char(reader);
+        if (c == EOF) {
+            break;
+        }
+        if (line_start && c == '!') {
+            skip_line(reader);
+            continue;
+        }
+        line_start = false;
+
+        if (c == '\n') {
+            w = x > w ? x : w;
+            x = 0;
+            y++;
+            line_start = true;
+        } else if (c == 'O' || c == '*') {
+            if (grid) {
+                set_bit_grid_run(grid, x + offset_x, y + offset_y, 1);
+            }
+            x++;
+        } else if (c == '.') {
+            x++;
+        } else if (c != '\r' && c != ' ' && c != '\t') {
+            return fail_pattern(reader, "unexpected character in plaintext pattern");
+        }
+    }
+
+    info->x = 0;
+    info->y = 0;
+    info->w = x > w ? x : w;
+    info->h = x > 0 ? y + 1 : y;
+    return true;
+}
+
+// Life 1.06: a "#Life 1.06" line, then one "x y" pair per live cell.
+
+static bool read_life_106_cells(Pattern_Reader *reader, Bit_Grid *grid, int64_t offset_x, int64_t offset_y,
+                                Pattern_Info *info) {
+    char line[MAX_LINE_SIZE];
+    bool too_long;
+    int64_t min_x = INT64_MAX, min_y = INT64_MAX;
+    int64_t max_x = INT64_MIN, max_y = INT64_MIN;
+
+    while (read_line(reader, line, sizeof(line), &too_long)) {
+        if (line[0] == '#' || line[strspn(line, " \t")] == '\0') {
+            continue;
+        }
+        int64_t x, y;
+        if (too_long || sscanf(line, "%" SCNd64 " %" SCNd64, &x, &y) != 2) {
+            return fail_pattern(reader, "expected 'x y'");
+        }
+        if (grid) {
+            set_bit_grid_run(grid, x + offset_x, y + offset_y, 1);
+        }
+        min_x = x < min_x ? x : min_x;
+        min_y = y < min_y ? y : min_y;
+        max_x = x > max_x ? x : max_x;
+        max_y = y > max_y ? y : max_y;
+    }
+
+    bool empty = min_x > max_x;
+    info->x = empty ? 0 : min_x;
+    info->y = empty ? 0 : min_y;
+    info->w = empty ? 0 : max_x - min_x + 1;
+    info->h = empty ? 0 : max_y - min_y + 1;
+    return true;
+}
+
+// Macrocell: "[M2]", '#' lines ("#R rule"), then one node per line, children
+// before parents and the root last. A level-3 node is an 8x8 leaf written as
+// rows of '.' and '*' separated by '$'; a higher node is "level nw ne sw se"
+// with 1-based indices of earlier nodes and 0 for empty.
+
+typedef struct {
+    uint32_t level;
+    uint32_t children[4];
+    uint64_t leaf_rows;
+    // Bounding box of the live cells relative to the node's corner;
+    // min > max when empty.
+    int64_t min_x, min_y, max_x, max_y;
+} Macrocell_Node;
+
+typedef struct {
+    Macrocell_Node *nodes;
+    uint32_t count;
+    uint32_t capacity;
+} Macrocell;
+
+static Macrocell_Node *append_macrocell_node(Macrocell *mc) {
+    if (mc->count == mc->capacity) {
+        mc->capacity = mc->capacity ? mc->capacity * 2 : 1024;
+        Macrocell_Node *nodes = realloc(mc->nodes, (size_t)mc->capacity * sizeof(Macrocell_Node));
+        if (!nodes) {
+            exit_with_error("Failed to grow the macrocell node table");
+        }
+        mc->nodes = nodes;
+    }
+    Macrocell_Node *node = &mc->nodes[mc->count++];
+    memset(node, 0, sizeof(*node));
+    node->min_x = node->min_y = INT64_MAX;
+    node->max_x = node->max_y = INT64_MIN;
+    return node;
+}
+
+static void include_in_bounds(Macrocell_Node *node, int64_t min_x, int64_t min_y, int64_t max_x, int64_t max_y) {
+    node->min_x = min_x < node->min_x ? min_x : node->min_x;
+    node->min_y = min_y < node->min_y ? min_y : node->min_y;
+    node->max_x = max_x > node->max_x ? max_x : node->max_x;
+    node->max_y = max_y > node->max_y ? max_y : node->max_y;
+}
+
+static bool parse_macrocell_leaf(Pattern_Reader *reader, const char *line, Macrocell_Node *node) {
+    node->level = MACROCELL_LEAF_LEVEL;
+    int x = 0;
+    int y = 0;
+    for (const char *p = line; *p; p++) {
+        if (*p == '$') {
+            x = 0;
+            y++;
+        } else if (*p == '.' || *p == '*') {
+            if (x >= 8 || y >= 8) {
+                return fail_pattern(reader, "macrocell leaf is larger than 8x8");
+            }
+            if (*p == '*') {
+                node->leaf_rows |= 1ull << (y * 8 + x);
+                include_in_bounds(node, x, y, x, y);
+            }
+            x++;
+        } else {
+            return fail_pattern(reader, "unexpected character in macrocell leaf");
+        }
+    }
+    return true;
+}
+
+static bool parse_macrocell_branch(Pattern_Reader *reader, const char *line, Macrocell *mc, Macrocell_Node *node) {
+    uint32_t level;
+    uint32_t children[4];
+    if (sscanf(line, "%" SCNu32 " %" SCNu32 " %" SCNu32 " %" SCNu32 " %" SCNu32,
+               &level, &children[0], &children[1], &children[2], &children[3]) != 5) {
+        return fail_pattern(reader, "expected 'level nw ne sw se'");
+    }
+    if (level <= MACROCELL_LEAF_LEVEL || level > MAX_MACROCELL_LEVEL) {
+        return fail_pattern(reader, level == 1 ? "multi-state macrocell is not supported"
+                                               : "macrocell level out of range");
+    }
+
+    node->level = level;
+    int64_t half = (int64_t)1 << (level - 1);
+    for (int i = 0; i < 4; i++) {
+        // The node being parsed is the last one, so valid children come before it.
+        if (children[i] >= mc->count) {
+            return fail_pattern(reader, "macrocell child refers to a later node");
+        }
+        const Macrocell_Node *child = children[i] ? &mc->nodes[children[i] - 1] : NULL;
+        if (child && child->level != level - 1) {
+            return fail_pattern(reader, "macrocell child has the wrong level");
+        }
+        node->children[i] = children[i];
+        if (child && child->min_x <= child->max_x) {
+            int64_t dx = (i & 1) ? half : 0;
+            int64_t dy = (i & 2) ? half : 0;
+            include_in_bounds(node, child->min_x + dx, child->min_y + dy, child->max_x + dx, child->max_y + dy);
+        }
+    }
+    return true;
+}
+
+static bool read_macrocell(Pattern_Reader *reader, Macrocell *mc, Pattern_Info *info) {
+    char line[MAX_LINE_SIZE];
+    bool too_long;
+
+    while (read_line(reader, line, sizeof(line), &too_long)) {
+        if (too_long) {
+            return fail_pattern(reader, "line too long");
+        }
+        if (line[0] == '[') {
+            continue;
+        }
+        if (line[0] == '#') {
+            if (line[1] == 'R') {
+                copy_rule(info->rule, line + 2 + strspn(line + 2, " "));
+            }
+            continue;
+        }
+        if (line[0] == '\0') {
+            continue;
+        }
+
+        Macrocell_Node *node = append_macrocell_node(mc);
+        bool ok = isdigit((unsigned char)line[0])
+            ? parse_macrocell_branch(reader, line, mc, node)
+            : parse_macrocell_leaf(reader, line, node);
+        if (!ok) {
+            return false;
+        }
+    }
+    if (mc->count == 0) {
+        return fail_pattern(reader, "macrocell has no nodes");
+    }
+
+    // Golly puts the centre of the root at the origin.
+    const Macrocell_Node *root = &mc->nodes[mc->count - 1];
+    int64_t origin = -((int64_t)1 << (root->level - 1));
+    bool empty = root->min_x > root->max_x;
+    info->x = empty ? 0 : origin + root->min_x;
+    info->y = empty ? 0 : origin + root->min_y;
+    info->w = empty ? 0 : root->max_x - root->min_x + 1;
+    info->h = empty ? 0 : root->max_y - root->min_y + 1;
+    return true;
+}
+
+// Places node (1-based index) with its corner at (x, y) in grid coordinates,
+// skipping anything outside the grid.
+static void place_macrocell_node(const Macrocell *mc, uint32_t index, int64_t x, int64_t y, Bit_Grid *grid) {
+    if (index == 0) {
+        return;
+    }
+    const Macrocell_Node *node = &mc->nodes[index - 1];
+    if (node->min_x > node->max_x ||
+        x + node->max_x < 0 || y + node->max_y < 0 ||
+        x + node->min_x >= grid->w || y + node->min_y >= grid->h) {
+        return;
+    }
+
+    if (node->level == MACROCELL_LEAF_LEVEL) {
+        for (int row = 0; row < 8; row++) {
+            uint64_t bits = (node->leaf_rows >> (row * 8)) & 0xFF;
+            int64_t cell_y = y + row;
+            for (int col = 0; bits && col < 8; col++, bits >>= 1) {
+                int64_t cell_x = x + col;
+                if ((bits & 1) && cell_x >= 0 && cell_x < grid->w && cell_y >= 0 && cell_y < grid->h) {
+                    set_bit_grid_run(grid, cell_x, cell_y, 1);
+                }
+            }
+        }
+        return;
+    }
+
+    int64_t half = (int64_t)1 << (node->level - 1);
+    for (int i = 0; i < 4; i++) {
+        place_macrocell_node(mc, node->children[i], x + ((i & 1) ? half : 0), y + ((i & 2) ? half : 0), grid);
+    }
+}
+
+static bool read_pattern(Pattern_Reader *reader, Bit_Grid *grid, Pattern_Info *info) {
+    memset(info, 0, sizeof(*info));
+    snprintf(info->rule, sizeof(info->rule), "%s", DEFAULT_RULE);
+    info->format = sniff_pattern_format(reader);
+
+    // Placement puts the bounding box's corner at (offset_x, offset_y) once
+    // the pattern coordinates are shifted by -info->x, -info->y.
+    switch (info->format) {
+    case PATTERN_FORMAT_RLE: {
+        if (!read_rle_header(reader, info)) {
+            return false;
+        }
+        if (!grid) {
+            return true;
+        }
+        return read_rle_cells(reader, grid, (grid->w - info->w) / 2, (grid->h - info->h) / 2);
+    }
+    case PATTERN_FORMAT_PLAINTEXT: {
+        if (!read_plaintext_cells(reader, NULL, 0, 0, info)) {
+            return false;
+        }
+        if (!grid) {
+            return true;
+        }
+        rewind_pattern_reader(reader);
+        Pattern_Info measured = *info;
+        return read_plaintext_cells(reader, grid, (grid->w - measured.w) / 2, (grid->h - measured.h) / 2, info);
+    }
+    case PATTERN_FORMAT_LIFE_106: {
+        if (!read_life_106_cells(reader, NULL, 0, 0, info)) {
+            return false;
+        }
+        if (!grid) {
+            return true;
+        }
+        rewind_pattern_reader(reader);
+        Pattern_Info measured = *info;
+        return read_life_106_cells(reader, grid, (grid->w - measured.w) / 2 - measured.x,
+                                   (grid->h - measured.h) / 2 - measured.y, info);
+    }
+    case PATTERN_FORMAT_MACROCELL: {
+        Macrocell mc = {0};
+        bool ok = read_macrocell(reader, &mc, info);
+        if (ok && grid) {
+            const Macrocell_Node *root = &mc.nodes[mc.count - 1];
+            int64_t origin = -((int64_t)1 << (root->level - 1));
+            place_macrocell_node(&mc, mc.count, origin - info->x + (grid->w - info->w) / 2,
+                                 origin - info->y + (grid->h - info->h) / 2, grid);
+        }
+        free(mc.nodes);
+        return ok;
+    }
+    }
+    return false;
+}
+
+bool read_pattern_info(const char *path, Pattern_Info *info) {
+    Pattern_Reader *reader = open_pattern_reader(path);
+    if (!reader) {
+        return false;
+    }
+    bool ok = read_pattern(reader, NULL, info);
+    close_pattern_reader(reader);
+    return ok;
+}
+
+bool load_pattern(const char *path, Bit_Grid *grid, Pattern_Info *info) {
+    Pattern_Reader *reader = open_pattern_reader(path);
+    if (!reader) {
+        return false;
+    }
+    bool ok = read_pattern(reader, grid, info);
+    close_pattern_reader(reader);
+    return ok;
+}
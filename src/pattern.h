@@ -0,0 +1,50 @@
+#ifndef PATTERN_H
+#define PATTERN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bit_grid.h"
+
+// Pattern files: RLE, plaintext (.cells), Life 1.06 and two-state Golly
+// macrocell. The format is sniffed from the contents. Files are read through a
+// fixed buffer and live cells go straight into the Bit_Grid a run at a time,
+// so nothing proportional to the cell count is allocated besides the grid
+// itself; macrocell keeps its node table, which is what makes it compact.
+
+typedef enum {
+    PATTERN_FORMAT_RLE,
+    PATTERN_FORMAT_PLAINTEXT,
+    PATTERN_FORMAT_LIFE_106,
+    PATTERN_FORMAT_MACROCELL
+} Pattern_Format;
+
+enum {
+    PATTERN_RULE_SIZE = 64
+};
+
+typedef struct {
+    Pattern_Format format;
+    // Bounding box of the pattern in its own coordinates. For RLE this is the
+    // header's x and y; for the other formats it's measured.
+    int64_t x;
+    int64_t y;
+    int64_t w;
+    int64_t h;
+    // As written in the file; "B3/S23" if the file doesn't say.
+    char rule[PATTERN_RULE_SIZE];
+} Pattern_Info;
+
+const char *get_pattern_format_name(Pattern_Format format);
+
+// Returns false (and logs) if the file can't be read or parsed. Formats
+// without a size header are scanned once to measure them.
+bool read_pattern_info(const char *path, Pattern_Info *info);
+
+// Sets the pattern's live cells in grid (which is not cleared first) with its
+// bounding box centred. Cells past the edges wrap around, except for
+// macrocell, where anything outside the grid is clipped so huge sparse
+// universes don't have to be walked in full.
+bool load_pattern(const char *path, Bit_Grid *grid, Pattern_Info *info);
+
+#endif
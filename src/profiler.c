@@ -0,0 +1,278 @@
+#include "profiler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glad/glad.h>
+
+#include "common.h"
+
+enum {
+    PROFILE_RING_CAPACITY = 16384,
+    // GL_TIME_ELAPSED queries in flight; zones beyond this are dropped.
+    GPU_QUERY_COUNT = 64
+};
+
+typedef struct {
+    const char *name;
+    uint64_t start_ns;
+    uint64_t duration_ns;
+} Profile_Event;
+
+typedef struct Profile_Ring {
+    struct Profile_Ring *next;
+    // Trace thread id; the GPU ring is 0.
+    int thread_index;
+    bool gpu;
+    // Events ever recorded; only the owner writes it.
+    uint64_t head;
+    Profile_Event events[PROFILE_RING_CAPACITY];
+} Profile_Ring;
+
+typedef struct {
+    uint32_t queries[GPU_QUERY_COUNT];
+    const char *names[GPU_QUERY_COUNT];
+    uint64_t issued_ns[GPU_QUERY_COUNT];
+    // Queries [first, first + count) are issued or, the last one, active.
+    int first;
+    int count;
+    bool active;
+    uint64_t dropped;
+} Gpu_Profiler;
+
+static bool g_profiler_enabled;
+static Profile_Ring *g_profile_rings;
+static int g_next_thread_index = 1;
+static __thread Profile_Ring *t_profile_ring;
+static Profile_Ring *g_gpu_ring;
+static Gpu_Profiler g_gpu_profiler;
+
+void enable_profiler() {
+    __atomic_store_n(&g_profiler_enabled, true, __ATOMIC_RELAXED);
+}
+
+bool is_profiler_enabled() {
+    return __atomic_load_n(&g_profiler_enabled, __ATOMIC_RELAXED);
+}
+
+static Profile_Ring *create_profile_ring(bool gpu) {
+    Profile_Ring *ring = xcalloc(1, sizeof(Profile_Ring));
+    ring->gpu = gpu;
+    ring->thread_index = gpu ? 0 : __atomic_fetch_add(&g_next_thread_index, 1, __ATOMIC_RELAXED);
+    ring->next = __atomic_load_n(&g_profile_rings, __ATOMIC_ACQUIRE);
+    while (!__atomic_compare_exchange_n(&g_profile_rings, &ring->next, ring, true,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+    }
+    return ring;
+}
+
+static void push_profile_event(Profile_Ring *ring, const char *name, uint64_t start_ns, uint64_t duration_ns) {
+    uint64_t head = ring->head;
+    Profile_Event *event = &ring->events[head % PROFILE_RING_CAPACITY];
+    event->name = name;
+    event->start_ns = start_ns;
+    event->duration_ns = duration_ns;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+Profile_Zone begin_profile_zone(const char *name) {
+    Profile_Zone zone = { name, 0 };
+    if (is_profiler_enabled()) {
+        zone.start_ns = get_time_ns();
+    }
+    return zone;
+}
+
+void end_profile_zone(Profile_Zone zone) {
+    if (!is_profiler_enabled() || zone.start_ns == 0) {
+        return;
+    }
+    uint64_t end_ns = get_time_ns();
+    if (!t_profile_ring) {
+        t_profile_ring = create_profile_ring(false);
+    }
+    push_profile_event(t_profile_ring, zone.name, zone.start_ns, end_ns - zone.start_ns);
+}
+
+void begin_gpu_profile_zone(const char *name) {
+    Gpu_Profiler *gpu = &g_gpu_profiler;
+    if (!is_profiler_enabled() || gpu->active) {
+        return;
+    }
+    if (gpu->count == GPU_QUERY_COUNT) {
+        gpu->dropped++;
+        return;
+    }
+    if (!gpu->queries[0]) {
+        glGenQueries(GPU_QUERY_COUNT, gpu->queries);
+        g_gpu_ring = create_profile_ring(true);
+    }
+
+    int slot = (gpu->first + gpu->count) % GPU_QUERY_COUNT;
+    gpu->names[slot] = name;
+    gpu->issued_ns[slot] = get_time_ns();
+    gpu->count++;
+    gpu->active = true;
+    glBeginQuery(GL_TIME_ELAPSED, gpu->queries[slot]);
+}
+
+void end_gpu_profile_zone() {
+    if (!g_gpu_profiler.active) {
+        return;
+    }
+    glEndQuery(GL_TIME_ELAPSED);
+    g_gpu_profiler.active = false;
+}
+
+void collect_gpu_profile_zones(bool wait) {
+    Gpu_Profiler *gpu = &g_gpu_profiler;
+    // Queries finish in order, so stop at the first one still running.
+    int ready = gpu->count - (gpu->active ? 1 : 0);
+    while (ready > 0) {
+        int slot = gpu->first;
+        if (!wait) {
+            GLint available = 0;
+            glGetQueryObjectiv(gpu->queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) {
+                break;
+            }
+        }
+        GLuint64 elapsed_ns = 0;
+        glGetQueryObjectui64v(gpu->queries[slot], GL_QUERY_RESULT, &elapsed_ns);
+        push_profile_event(g_gpu_ring, gpu->names[slot], gpu->issued_ns[slot], elapsed_ns);
+        gpu->first = (gpu->first + 1) % GPU_QUERY_COUNT;
+        gpu->count--;
+        ready--;
+    }
+}
+
+void destroy_gpu_profiler() {
+    Gpu_Profiler *gpu = &g_gpu_profiler;
+    if (gpu->queries[0]) {
+        glDeleteQueries(GPU_QUERY_COUNT, gpu->queries);
+    }
+    if (gpu->dropped > 0) {
+        trace_log("Profiler dropped %llu GPU zones with every query in flight", (unsigned long long)gpu->dropped);
+    }
+    memset(gpu, 0, sizeof(*gpu));
+}
+
+// Copies the ring's retained events into events (PROFILE_RING_CAPACITY long)
+// and returns how many survived the copy.
+static int copy_profile_ring(const Profile_Ring *ring, Profile_Event *events) {
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint64_t begin = head > PROFILE_RING_CAPACITY ? head - PROFILE_RING_CAPACITY : 0;
+    for (uint64_t i = begin; i < head; i++) {
+        events[i - begin] = ring->events[i % PROFILE_RING_CAPACITY];
+    }
+    // The owner may have lapped the oldest ones while they were copied, and
+    // may be writing event new_head, over slot new_head - capacity, before it
+    // publishes the head; events from new_head + 1 - capacity on are intact.
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    uint64_t new_head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint64_t overwritten = new_head + 1 > PROFILE_RING_CAPACITY ? new_head + 1 - PROFILE_RING_CAPACITY : 0;
+    if (overwritten <= begin) {
+        return (int)(head - begin);
+    }
+    if (overwritten >= head) {
+        return 0;
+    }
+    int skip = (int)(overwritten - begin);
+    memmove(events, events + skip, (size_t)(head - overwritten) * sizeof(Profile_Event));
+    return (int)(head - overwritten);
+}
+
+static int find_stage_summary(Profile_Stage_Summary *summaries, int count, const char *name, bool gpu) {
+    for (int i = 0; i < count; i++) {
+        if (summaries[i].gpu == gpu && strcmp(summaries[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int summarize_profile(uint64_t since_ns, Profile_Stage_Summary *summaries, int max_summaries) {
+    Profile_Event *events = xmalloc(PROFILE_RING_CAPACITY * sizeof(Profile_Event));
+    int count = 0;
+    // CPU rings first so their stages come first.
+    for (int pass = 0; pass < 2; pass++) {
+        bool gpu = pass == 1;
+        for (Profile_Ring *ring = __atomic_load_n(&g_profile_rings, __ATOMIC_ACQUIRE); ring; ring = ring->next) {
+            if (ring->gpu != gpu) {
+                continue;
+            }
+            int event_count = copy_profile_ring(ring, events);
+            for (int e = 0; e < event_count; e++) {
+                const Profile_Event *event = &events[e];
+                if (event->start_ns < since_ns) {
+                    continue;
+                }
+                int s = find_stage_summary(summaries, count, event->name, gpu);
+                if (s < 0) {
+                    if (count == max_summaries) {
+                        continue;
+                    }
+                    s = count++;
+                    memset(&summaries[s], 0, sizeof(summaries[s]));
+                    summaries[s].name = event->name;
+                    summaries[s].gpu = gpu;
+                }
+                double ms = (double)event->duration_ns / 1e6;
+                summaries[s].count++;
+                summaries[s].total_ms += ms;
+                if (ms > summaries[s].max_ms) {
+                    summaries[s].max_ms = ms;
+                }
+            }
+        }
+    }
+    free(events);
+    return count;
+}
+
+bool write_chrome_trace(const char *path) {
+    FILE *out = fopen(path, "w");
+    if (!out) {
+        return false;
+    }
+
+    Profile_Event *events = xmalloc(PROFILE_RING_CAPACITY * sizeof(Profile_Event));
+    // Timestamps are microseconds from the earliest event.
+    uint64_t origin_ns = UINT64_MAX;
+    for (Profile_Ring *ring = __atomic_load_n(&g_profile_rings, __ATOMIC_ACQUIRE); ring; ring = ring->next) {
+        int event_count = copy_profile_ring(ring, events);
+        for (int e = 0; e < event_count; e++) {
+            if (events[e].start_ns < origin_ns) {
+                origin_ns = events[e].start_ns;
+            }
+        }
+    }
+
+    fprintf(out, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+    bool first = true;
+    for (Profile_Ring *ring = __atomic_load_n(&g_profile_rings, __ATOMIC_ACQUIRE); ring; ring = ring->next) {
+        char thread_name[32];
+        if (ring->gpu) {
+            snprintf(thread_name, sizeof(thread_name), "GPU");
+        } else {
+            snprintf(thread_name, sizeof(thread_name), "CPU thread %d", ring->thread_index);
+        }
+        fprintf(out, "%s\n  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, "
+                "\"args\": {\"name\": \"%s\"}}",
+                first ? "" : ",", ring->thread_index, thread_name);
+        first = false;
+
+        int event_count = copy_profile_ring(ring, events);
+        for (int e = 0; e < event_count; e++) {
+            const Profile_Event *event = &events[e];
+            fprintf(out, ",\n  {\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, "
+                    "\"ts\": %.3f, \"dur\": %.3f}",
+                    event->name, ring->gpu ? "gpu" : "cpu", ring->thread_index,
+                    (double)(event->start_ns - origin_ns) / 1e3, (double)event->duration_ns / 1e3);
+        }
+    }
+    fprintf(out, "\n]}\n");
+    free(events);
+    return fclose(out) == 0;
+}
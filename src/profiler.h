@@ -0,0 +1,55 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Stage timing for the CPU and the GPU. Off until enable_profiler, and every
+// call is a cheap no-op while it is off.
+//
+// CPU stages are zones: begin_profile_zone returns the start, and
+// end_profile_zone records one event in the calling thread's ring. Each
+// thread owns its ring and is its only writer, so recording never locks;
+// readers copy a ring and drop whatever the writer overwrote meanwhile.
+// Rings keep the last PROFILE_RING_CAPACITY events and outlive their threads.
+//
+// GPU stages wrap GL commands in GL_TIME_ELAPSED queries on the current
+// context. They can't nest, and results arrive a few frames late:
+// collect_gpu_profile_zones records those that are ready, placing each at
+// the CPU time it was issued. Only the GL thread may use them.
+//
+// Zone names must be string literals (or otherwise outlive the profiler).
+
+typedef struct {
+    const char *name;
+    uint64_t start_ns;
+} Profile_Zone;
+
+typedef struct {
+    const char *name;
+    bool gpu;
+    uint64_t count;
+    double total_ms;
+    double max_ms;
+} Profile_Stage_Summary;
+
+void enable_profiler();
+bool is_profiler_enabled();
+
+Profile_Zone begin_profile_zone(const char *name);
+void end_profile_zone(Profile_Zone zone);
+
+void begin_gpu_profile_zone(const char *name);
+void end_gpu_profile_zone();
+// With wait, blocks until every issued query has finished.
+void collect_gpu_profile_zones(bool wait);
+void destroy_gpu_profiler();
+
+// One summary per stage name over the events that started at or after
+// since_ns, CPU stages first. Returns how many were filled.
+int summarize_profile(uint64_t since_ns, Profile_Stage_Summary *summaries, int max_summaries);
+// Writes every retained event in the Chrome trace event format, for
+// chrome://tracing or Perfetto. Returns false if the file can't be written.
+bool write_chrome_trace(const char *path);
+
+#endif
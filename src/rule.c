@@ -0,0 +1,249 @@
+#include "rule.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+
+enum {
+    CONWAY_BIRTH = 1 << 3,
+    CONWAY_SURVIVAL = (1 << 2) | (1 << 3)
+};
+
+static bool fail_rule(const char *text, const char *problem) {
+    trace_log("Rule '%s': %s", text, problem);
+    return false;
+}
+
+static void append_digits(char *buffer, size_t size, uint16_t mask) {
+    size_t len = strlen(buffer);
+    for (int n = 0; n <= 8 && len + 1 < size; n++) {
+        if (mask & (1u << n)) {
+            buffer[len++] = (char)('0' + n);
+        }
+    }
+    buffer[len] = '\0';
+}
+
+static void name_rule(Rule *rule) {
+    char *name = rule->name;
+    if (rule->family == RULE_FAMILY_LARGER_THAN_LIFE) {
+        snprintf(name, RULE_NAME_SIZE, "R%d,C%d,M%d,S%d..%d,B%d..%d,NM",
+                 rule->radius, rule->states > 2 ? rule->states : 0, rule->include_center ? 1 : 0,
+                 rule->survival_min, rule->survival_max, rule->birth_min, rule->birth_max);
+        return;
+    }
+
+    snprintf(name, RULE_NAME_SIZE, "B");
+    append_digits(name, RULE_NAME_SIZE, rule->birth);
+    strncat(name, "/S", RULE_NAME_SIZE - strlen(name) - 1);
+    append_digits(name, RULE_NAME_SIZE, rule->survival);
+    if (rule->family == RULE_FAMILY_GENERATIONS) {
+        size_t len = strlen(name);
+        snprintf(name + len, RULE_NAME_SIZE - len, "/C%d", rule->states);
+    }
+}
+
+// Parses neighbour counts 0..8 up to the next '/', letter or the end.
+static bool parse_count_digits(const char **p, uint16_t *mask) {
+    *mask = 0;
+    for (; **p && **p != '/' && !isalpha((unsigned char)**p); (*p)++) {
+        if (**p < '0' || **p > '8') {
+            return false;
+        }
+        *mask |= (uint16_t)(1u << (**p - '0'));
+    }
+    return true;
+}
+
+static bool parse_states(const char *p, int *states) {
+    char *end;
+    long value = strtol(p, &end, 10);
+    if (end == p || (*end && *end != '/' && !isalpha((unsigned char)*end)) ||
+        value < 2 || value > MAX_RULE_STATES) {
+        return false;
+    }
+    *states = (int)value;
+    return true;
+}
+
+// "B3/S23", "B2/S/C3" (letters in any case, parts in any order, the '/'
+// optional), or the older "S/B" and "S/B/C" digit forms.
+static bool parse_outer_totalistic_rule(const char *text, Rule *rule) {
+    bool lettered = strpbrk(text, "BbSs") != NULL;
+    int part = 0;
+    const char *p = text;
+    for (;;) {
+        if (part == 3) {
+            return fail_rule(text, "too many '/'-separated parts");
+        }
+
+        char key;
+        if (lettered) {
+            key = (char)toupper((unsigned char)*p);
+            if (key != 'B' && key != 'S' && key != 'C' && key != 'G') {
+                return fail_rule(text, "expected B, S or C");
+            }
+            p++;
+        } else {
+            key = part == 0 ? 'S' : part == 1 ? 'B' : 'C';
+        }
+
+        bool ok;
+        if (key == 'C' || key == 'G') {
+            ok = parse_states(p, &rule->states);
+            while (isdigit((unsigned char)*p)) {
+                p++;
+            }
+        } else {
+            ok = parse_count_digits(&p, key == 'B' ? &rule->birth : &rule->survival);
+        }
+        if (!ok) {
+            return fail_rule(text, key == 'C' || key == 'G' ? "states must be 2..255"
+                                                            : "neighbour counts must be digits 0..8");
+        }
+
+        part++;
+        if (*p == '\0') {
+            break;
+        }
+        if (*p == '/') {
+            p++;
+        } else if (!lettered) {
+            return fail_rule(text, "expected '/'");
+        }
+    }
+
+    if (!lettered && part < 2) {
+        return fail_rule(text, "expected survival/birth");
+    }
+    rule->family = rule->states > 2 ? RULE_FAMILY_GENERATIONS : RULE_FAMILY_LIFE;
+    return true;
+}
+
+static bool parse_range(const char *value, int *min, int *max) {
+    char *end;
+    *min = (int)strtol(value, &end, 10);
+    if (end == value) {
+        return false;
+    }
+    if (strncmp(end, "..", 2) == 0) {
+        const char *max_begin = end + 2;
+        *max = (int)strtol(max_begin, &end, 10);
+        if (end == max_begin) {
+            return false;
+        }
+    } else {
+        *max = *min;
+    }
+    return *end == '\0';
+}
+
+static bool parse_larger_than_life_rule(const char *text, Rule *rule) {
+    char fields[RULE_NAME_SIZE * 2];
+    if (strlen(text) >= sizeof(fields)) {
+        return fail_rule(text, "too long");
+    }
+    strcpy(fields, text);
+
+    bool has_birth = false;
+    bool has_survival = false;
+    rule->radius = 0;
+    for (char *field = strtok(fields, ","); field; field = strtok(NULL, ",")) {
+        char key = (char)toupper((unsigned char)field[0]);
+        const char *value = field + 1;
+        char *end;
+        bool ok = true;
+        switch (key) {
+        case 'R':
+            rule->radius = (int)strtol(value, &end, 10);
+            ok = end != value && *end == '\0';
+            break;
+        case 'C': {
+            long states = strtol(value, &end, 10);
+            ok = end != value && *end == '\0' && states >= 0 && states <= MAX_RULE_STATES;
+            rule->states = states > 2 ? (int)states : 2;
+            break;
+        }
+        case 'M':
+            ok = (value[0] == '0' || value[0] == '1') && value[1] == '\0';
+            rule->include_center = value[0] == '1';
+            break;
+        case 'S':
+            ok = parse_range(value, &rule->survival_min, &rule->survival_max);
+            has_survival = true;
+            break;
+        case 'B':
+            ok = parse_range(value, &rule->birth_min, &rule->birth_max);
+            has_birth = true;
+            break;
+        case 'N':
+            if (toupper((unsigned char)value[0]) != 'M' || value[1] != '\0') {
+                return fail_rule(text, "only the Moore neighbourhood (NM) is supported");
+            }
+            break;
+        default:
+            ok = false;
+        }
+        if (!ok) {
+            return fail_rule(text, "malformed Larger than Life field");
+        }
+    }
+
+    if (rule->radius < 1 || rule->radius > MAX_RULE_RADIUS) {
+        return fail_rule(text, "radius must be 1..500");
+    }
+    if (!has_birth || !has_survival) {
+        return fail_rule(text, "needs both B and S ranges");
+    }
+    int window = (2 * rule->radius + 1) * (2 * rule->radius + 1);
+    if (rule->birth_min < 0 || rule->birth_min > rule->birth_max || rule->birth_max > window ||
+        rule->survival_min < 0 || rule->survival_min > rule->survival_max || rule->survival_max > window) {
+        return fail_rule(text, "count ranges must be ascending and fit the neighbourhood");
+    }
+    rule->family = RULE_FAMILY_LARGER_THAN_LIFE;
+    return true;
+}
+
+bool parse_rule(const char *text, Rule *rule) {
+    memset(rule, 0, sizeof(*rule));
+    rule->states = 2;
+
+    while (isspace((unsigned char)*text)) {
+        text++;
+    }
+    char trimmed[RULE_NAME_SIZE * 2];
+    size_t len = strlen(text);
+    while (len > 0 && isspace((unsigned char)text[len - 1])) {
+        len--;
+    }
+    if (len == 0 || len >= sizeof(trimmed)) {
+        return fail_rule(text, len == 0 ? "empty" : "too long");
+    }
+    memcpy(trimmed, text, len);
+    trimmed[len] = '\0';
+
+    bool ok = toupper((unsigned char)trimmed[0]) == 'R' && isdigit((unsigned char)trimmed[1])
+        ? parse_larger_than_life_rule(trimmed, rule)
+        : parse_outer_totalistic_rule(trimmed, rule);
+    if (ok) {
+        name_rule(rule);
+    }
+    return ok;
+}
+
+Rule get_conway_rule() {
+    Rule rule = {0};
+    rule.family = RULE_FAMILY_LIFE;
+    rule.states = 2;
+    rule.birth = CONWAY_BIRTH;
+    rule.survival = CONWAY_SURVIVAL;
+    name_rule(&rule);
+    return rule;
+}
+
+bool is_conway_rule(const Rule *rule) {
+    return rule->family == RULE_FAMILY_LIFE && rule->birth == CONWAY_BIRTH && rule->survival == CONWAY_SURVIVAL;
+}
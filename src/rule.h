@@ -0,0 +1,60 @@
+#ifndef RULE_H
+#define RULE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Cellular automaton rules beyond B3/S23, in the three families the engines
+// specialise for:
+//   - Life-like: outer-totalistic on the Moore neighbourhood, "B3/S23" or the
+//     older survival/birth "23/3".
+//   - Generations: Life-like plus dying states, "B2/S/C3" or "/2/3". A live
+//     cell that doesn't survive passes through states 2..states-1 and then
+//     dies; only live (state 1) cells count as neighbours.
+//   - Larger than Life: a Moore neighbourhood of radius r with birth and
+//     survival ranges, in Golly's "R5,C0,M1,S34..58,B34..45,NM" form. C > 2
+//     adds dying states as in Generations.
+
+#define CONWAY_RULE_STRING "B3/S23"
+
+typedef enum {
+    RULE_FAMILY_LIFE,
+    RULE_FAMILY_GENERATIONS,
+    RULE_FAMILY_LARGER_THAN_LIFE
+} Rule_Family;
+
+enum {
+    RULE_NAME_SIZE = 64,
+    MAX_RULE_STATES = 255,
+    MAX_RULE_RADIUS = 500
+};
+
+typedef struct {
+    Rule_Family family;
+    // Cell states counting dead and alive: 2 unless the rule has dying states.
+    int states;
+
+    // Life-like and Generations: bit n set if a dead cell with n live
+    // neighbours is born, or a live one survives.
+    uint16_t birth;
+    uint16_t survival;
+
+    // Larger than Life: inclusive count ranges over the (2r+1)^2 window, which
+    // includes the cell itself when include_center is set.
+    int radius;
+    bool include_center;
+    int birth_min;
+    int birth_max;
+    int survival_min;
+    int survival_max;
+
+    // Canonical spelling, e.g. "B3/S23" for "23/3".
+    char name[RULE_NAME_SIZE];
+} Rule;
+
+// Returns false (and logs) if text isn't a rule in one of the forms above.
+bool parse_rule(const char *text, Rule *rule);
+Rule get_conway_rule();
+bool is_conway_rule(const Rule *rule);
+
+#endif
@@ -0,0 +1,411 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "snapshot.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "common.h"
+
+#define SNAPSHOT_MAGIC "GOLSNAP1"
+#define DEFAULT_RULE "B3/S23"
+
+enum {
+    // Version 2 widened the rule field from 32 bytes.
+    SNAPSHOT_VERSION = 2,
+    SNAPSHOT_HEADER_SIZE = 128,
+    // Shorter runs are cheaper to keep as literals.
+    MIN_RLE_RUN = 3
+};
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t width;
+    uint32_t height;
+    uint64_t generation;
+    char rule[SNAPSHOT_RULE_SIZE];
+    uint32_t encoding;
+    uint32_t words_per_row;
+    uint64_t payload_size;
+    uint64_t checksum;
+    uint8_t reserved[SNAPSHOT_HEADER_SIZE - 56 - SNAPSHOT_RULE_SIZE];
+} Snapshot_Header;
+
+typedef char snapshot_header_size_check[sizeof(Snapshot_Header) == SNAPSHOT_HEADER_SIZE ? 1 : -1];
+
+uint64_t compute_snapshot_checksum(const Bit_Grid *grid) {
+    size_t word_count = (size_t)grid->words_per_row * grid->h;
+    uint64_t hash = 0x243F6A8885A308D3ull ^ ((uint64_t)grid->w << 32 | (uint32_t)grid->h);
+    for (size_t i = 0; i < word_count; i++) {
+        hash ^= grid->words[i];
+        hash = (hash << 29 | hash >> 35) * 0x9E3779B97F4A7C15ull;
+    }
+    return hash ^ (hash >> 32);
+}
+
+static bool write_words(FILE *file, const uint64_t *words, size_t count) {
+    return fwrite(words, sizeof(uint64_t), count, file) == count;
+}
+
+static bool write_rle_chunk(FILE *file, const uint64_t *literals, uint32_t literal_count,
+                            uint32_t run_count, uint64_t run_word, uint64_t *payload_size) {
+    uint32_t counts[2] = { literal_count, run_count };
+    if (fwrite(counts, sizeof(counts), 1, file) != 1 || !write_words(file, literals, literal_count)) {
+        return false;
+    }
+    if (run_count > 0 && !write_words(file, &run_word, 1)) {
+        return false;
+    }
+    *payload_size += sizeof(counts) + ((size_t)literal_count + (run_count > 0)) * sizeof(uint64_t);
+    return true;
+}
+
+static bool write_rle_payload(FILE *file, const Bit_Grid *grid, uint64_t *payload_size) {
+    const uint64_t *words = grid->words;
+    size_t word_count = (size_t)grid->words_per_row * grid->h;
+    size_t literal_begin = 0;
+    size_t i = 0;
+
+    while (i < word_count) {
+        size_t run_end = i + 1;
+        while (run_end < word_count && words[run_end] == words[i] && run_end - i < UINT32_MAX) {
+            run_end++;
+        }
+        if (run_end - i >= MIN_RLE_RUN || i - literal_begin == UINT32_MAX) {
+            bool is_run = run_end - i >= MIN_RLE_RUN;
+            if (!write_rle_chunk(file, words + literal_begin, (uint32_t)(i - literal_begin),
+                                 is_run ? (uint32_t)(run_end - i) : 0, words[i], payload_size)) {
+                return false;
+            }
+            i = is_run ? run_end : i;
+            literal_begin = i;
+        } else {
+            i++;
+        }
+    }
+    if (literal_begin < word_count) {
+        return write_rle_chunk(file, words + literal_begin, (uint32_t)(word_count - literal_begin),
+                               0, 0, payload_size);
+    }
+    return true;
+}
+
+bool save_snapshot(const char *path, const Bit_Grid *grid, uint64_t generation,
+                   const char *rule, Snapshot_Encoding encoding) {
+    if (rule && strlen(rule) >= SNAPSHOT_RULE_SIZE) {
+        trace_log("Rule '%s' is too long for a snapshot header", rule);
+        return false;
+    }
+
+    Snapshot_Header header = {0};
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.header_size = SNAPSHOT_HEADER_SIZE;
+    header.width = (uint32_t)grid->w;
+    header.height = (uint32_t)grid->h;
+    header.generation = generation;
+    snprintf(header.rule, sizeof(header.rule), "%s", rule ? rule : DEFAULT_RULE);
+    header.encoding = encoding;
+    header.words_per_row = (uint32_t)grid->words_per_row;
+    header.checksum = compute_snapshot_checksum(grid);
+
+    size_t temp_path_size = strlen(path) + 5;
+    char *temp_path = xmalloc(temp_path_size);
+    snprintf(temp_path, temp_path_size, "%s.tmp", path);
+
+    FILE *file = fopen(temp_path, "wb");
+    if (!file) {
+        trace_log("Failed to open '%s' for writing: %s", temp_path, strerror(errno));
+        free(temp_path);
+        return false;
+    }
+
+    // The header goes in twice: first to reserve its space, then again once
+    // the payload size is known.
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    if (ok && encoding == SNAPSHOT_ENCODING_RLE) {
+        ok = write_rle_payload(file, grid, &header.payload_size);
+    } else if (ok) {
+        size_t word_count = (size_t)grid->words_per_row * grid->h;
+        ok = write_words(file, grid->words, word_count);
+        header.payload_size = word_count * sizeof(uint64_t);
+    }
+    ok = ok && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    ok = fclose(file) == 0 && ok;
+    ok = ok && rename(temp_path, path) == 0;
+
+    if (!ok) {
+        trace_log("Failed to write snapshot '%s': %s", path, strerror(errno));
+        remove(temp_path);
+    }
+    free(temp_path);
+    return ok;
+}
+
+static bool decode_rle_payload(const uint8_t *payload, size_t payload_size, Bit_Grid *grid) {
+    uint64_t *words = grid->words;
+    size_t word_count = (size_t)grid->words_per_row * grid->h;
+    size_t filled = 0;
+    size_t offset = 0;
+
+    while (offset < payload_size) {
+        uint32_t counts[2];
+        if (payload_size - offset < sizeof(counts)) {
+            return false;
+        }
+        memcpy(counts, payload + offset, sizeof(counts));
+        offset += sizeof(counts);
+
+        size_t literal_bytes = (size_t)counts[0] * sizeof(uint64_t);
+        size_t run_bytes = counts[1] > 0 ? sizeof(uint64_t) : 0;
+        if (payload_size - offset < literal_bytes + run_bytes ||
+            word_count - filled < (size_t)counts[0] + counts[1]) {
+            return false;
+        }
+        memcpy(words + filled, payload + offset, literal_bytes);
+        filled += counts[0];
+        offset += literal_bytes;
+
+        if (counts[1] > 0) {
+            uint64_t run_word;
+            memcpy(&run_word, payload + offset, sizeof(run_word));
+            offset += sizeof(run_word);
+            for (uint32_t i = 0; i < counts[1]; i++) {
+                words[filled++] = run_word;
+            }
+        }
+    }
+    return filled == word_count;
+}
+
+static bool padding_bits_are_clear(const Bit_Grid *grid) {
+    uint64_t tail_mask = get_bit_grid_tail_mask(grid);
+    for (int y = 0; y < grid->h; y++) {
+        if (get_bit_grid_row(grid, y)[grid->words_per_row - 1] & ~tail_mask) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool open_snapshot(const char *path, Snapshot *snapshot) {
+    memset(snapshot, 0, sizeof(*snapshot));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        trace_log("Failed to open snapshot '%s': %s", path, strerror(errno));
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Snapshot_Header)) {
+        trace_log("Snapshot '%s' is too small", path);
+        close(fd);
+        return false;
+    }
+
+    // Raw snapshots are used in place: the grid points into this mapping.
+    size_t mapping_size = (size_t)st.st_size;
+    void *mapping = mmap(NULL, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        trace_log("Failed to map snapshot '%s': %s", path, strerror(errno));
+        return false;
+    }
+    snapshot->mapping = mapping;
+    snapshot->mapping_size = mapping_size;
+
+    Snapshot_Header header;
+    memcpy(&header, mapping, sizeof(header));
+    size_t words_per_row = ((size_t)header.width + 63) / 64;
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) == 0 && header.version != SNAPSHOT_VERSION) {
+        trace_log("Snapshot '%s' is format version %u, expected %d", path, header.version, SNAPSHOT_VERSION);
+        close_snapshot(snapshot);
+        return false;
+    }
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != SNAPSHOT_VERSION || header.header_size != SNAPSHOT_HEADER_SIZE ||
+        header.width == 0 || header.height == 0 || header.width > INT32_MAX || header.height > INT32_MAX ||
+        header.words_per_row != words_per_row || header.encoding > SNAPSHOT_ENCODING_RLE ||
+        header.payload_size > mapping_size - SNAPSHOT_HEADER_SIZE) {
+        trace_log("Snapshot '%s' has an invalid header", path);
+        close_snapshot(snapshot);
+        return false;
+    }
+
+    Snapshot_Info *info = &snapshot->info;
+    info->w = (int)header.width;
+    info->h = (int)header.height;
+    info->generation = header.generation;
+    memcpy(info->rule, header.rule, sizeof(info->rule));
+    info->rule[sizeof(info->rule) - 1] = '\0';
+    info->encoding = (Snapshot_Encoding)header.encoding;
+    info->checksum = header.checksum;
+
+    const uint8_t *payload = (const uint8_t *)mapping + SNAPSHOT_HEADER_SIZE;
+    bool decoded;
+    if (info->encoding == SNAPSHOT_ENCODING_RAW) {
+        decoded = header.payload_size == words_per_row * header.height * sizeof(uint64_t);
+        snapshot->grid.w = info->w;
+        snapshot->grid.h = info->h;
+        snapshot->grid.words_per_row = (int)words_per_row;
+        snapshot->grid.words = (uint64_t *)payload;
+        snapshot->grid_is_mapped = true;
+    } else {
+        snapshot->grid = create_bit_grid(info->w, info->h);
+        decoded = decode_rle_payload(payload, header.payload_size, &snapshot->grid);
+        // The words now live in the grid; drop the file mapping early.
+        munmap(snapshot->mapping, snapshot->mapping_size);
+        snapshot->mapping = NULL;
+        snapshot->mapping_size = 0;
+    }
+
+    if (!decoded || !padding_bits_are_clear(&snapshot->grid) ||
+        compute_snapshot_checksum(&snapshot->grid) != info->checksum) {
+        trace_log("Snapshot '%s' is truncated or corrupt", path);
+        close_snapshot(snapshot);
+        return false;
+    }
+    return true;
+}
+
+void close_snapshot(Snapshot *snapshot) {
+    if (!snapshot->grid_is_mapped) {
+        free_bit_grid(&snapshot->grid);
+    }
+    if (snapshot->mapping) {
+        munmap(snapshot->mapping, snapshot->mapping_size);
+    }
+    memset(snapshot, 0, sizeof(*snapshot));
+}
+
+struct Checkpointer {
+    char *path;
+    char rule[SNAPSHOT_RULE_SIZE];
+    Snapshot_Encoding encoding;
+    Bit_Grid grid;
+    uint64_t generation;
+
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    // Set by the stepping thread once grid holds a capture, cleared by the
+    // writer when it's on disk. The grid belongs to the writer while set.
+    bool busy;
+    bool shutting_down;
+};
+
+static void *checkpoint_writer_main(void *arg) {
+    Checkpointer *checkpointer = arg;
+
+    pthread_mutex_lock(&checkpointer->mutex);
+    for (;;) {
+        while (!checkpointer->busy && !checkpointer->shutting_down) {
+            pthread_cond_wait(&checkpointer->cond, &checkpointer->mutex);
+        }
+        if (!checkpointer->busy) {
+            break;
+        }
+        pthread_mutex_unlock(&checkpointer->mutex);
+
+        uint64_t start_ns = get_time_ns();
+        if (save_snapshot(checkpointer->path, &checkpointer->grid, checkpointer->generation,
+                          checkpointer->rule, checkpointer->encoding)) {
+            trace_log("Checkpoint of generation %llu written to %s in %.1f ms",
+                      (unsigned long long)checkpointer->generation, checkpointer->path,
+                      (double)(get_time_ns() - start_ns) / 1e6);
+        }
+
+        pthread_mutex_lock(&checkpointer->mutex);
+        checkpointer->busy = false;
+        pthread_cond_broadcast(&checkpointer->cond);
+    }
+    pthread_mutex_unlock(&checkpointer->mutex);
+    return NULL;
+}
+
+Checkpointer *create_checkpointer(const char *path, int grid_w, int grid_h, const char *rule,
+                                  Snapshot_Encoding encoding) {
+    if (rule && strlen(rule) >= SNAPSHOT_RULE_SIZE) {
+        trace_log("Rule '%s' is too long for a snapshot header", rule);
+        return NULL;
+    }
+    Checkpointer *checkpointer = xcalloc(1, sizeof(Checkpointer));
+    size_t path_size = strlen(path) + 1;
+    checkpointer->path = xmalloc(path_size);
+    memcpy(checkpointer->path, path, path_size);
+    snprintf(checkpointer->rule, sizeof(checkpointer->rule), "%s", rule ? rule : DEFAULT_RULE);
+    checkpointer->encoding = encoding;
+    checkpointer->grid = create_bit_grid(grid_w, grid_h);
+
+    pthread_mutex_init(&checkpointer->mutex, NULL);
+    pthread_cond_init(&checkpointer->cond, NULL);
+    if (pthread_create(&checkpointer->thread, NULL, checkpoint_writer_main, checkpointer) != 0) {
+        exit_with_error("Failed to create checkpoint writer thread");
+    }
+    return checkpointer;
+}
+
+void destroy_checkpointer(Checkpointer *checkpointer) {
+    if (!checkpointer) {
+        return;
+    }
+
+    pthread_mutex_lock(&checkpointer->mutex);
+    checkpointer->shutting_down = true;
+    pthread_cond_broadcast(&checkpointer->cond);
+    pthread_mutex_unlock(&checkpointer->mutex);
+    pthread_join(checkpointer->thread, NULL);
+
+    pthread_mutex_destroy(&checkpointer->mutex);
+    pthread_cond_destroy(&checkpointer->cond);
+    free_bit_grid(&checkpointer->grid);
+    free(checkpointer->path);
+    free(checkpointer);
+}
+
+static bool is_checkpointer_busy(Checkpointer *checkpointer) {
+    pthread_mutex_lock(&checkpointer->mutex);
+    bool busy = checkpointer->busy;
+    pthread_mutex_unlock(&checkpointer->mutex);
+    return busy;
+}
+
+static void queue_checkpoint(Checkpointer *checkpointer, uint64_t generation) {
+    checkpointer->generation = generation;
+
+    pthread_mutex_lock(&checkpointer->mutex);
+    checkpointer->busy = true;
+    pthread_cond_signal(&checkpointer->cond);
+    pthread_mutex_unlock(&checkpointer->mutex);
+}
+
+bool request_checkpoint(Checkpointer *checkpointer, Gol_Engine *engine) {
+    if (is_checkpointer_busy(checkpointer)) {
+        return false;
+    }
+
+    // The writer is idle and waits for busy, so the grid is ours until then.
+    read_engine_grid(engine, &checkpointer->grid);
+    queue_checkpoint(checkpointer, engine->generation);
+    return true;
+}
+
+bool request_checkpoint_of_grid(Checkpointer *checkpointer, const Bit_Grid *grid, uint64_t generation) {
+    if (is_checkpointer_busy(checkpointer)) {
+        return false;
+    }
+
+    copy_bit_grid(&checkpointer->grid, grid);
+    queue_checkpoint(checkpointer, generation);
+    return true;
+}
@@ -0,0 +1,74 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bit_grid.h"
+#include "engine.h"
+
+// Binary snapshots of a Bit_Grid. A fixed 128-byte header (magic, size, rule,
+// generation, encoding, checksum) is followed by the grid words, either raw,
+// row-major exactly as in memory, or run-length encoded. Raw snapshots load
+// through mmap with the grid pointing straight into the mapping. All fields
+// are little-endian.
+
+typedef enum {
+    SNAPSHOT_ENCODING_RAW = 0,
+    // Chunks of {uint32 literal_count, uint32 run_count, literal words...,
+    // run word if run_count > 0} over the word stream.
+    SNAPSHOT_ENCODING_RLE = 1
+} Snapshot_Encoding;
+
+enum {
+    // Any rule name fits.
+    SNAPSHOT_RULE_SIZE = RULE_NAME_SIZE
+};
+
+typedef struct {
+    int w;
+    int h;
+    uint64_t generation;
+    char rule[SNAPSHOT_RULE_SIZE];
+    Snapshot_Encoding encoding;
+    uint64_t checksum;
+} Snapshot_Info;
+
+typedef struct {
+    Snapshot_Info info;
+    // Read-only when mapped.
+    Bit_Grid grid;
+    void *mapping;
+    size_t mapping_size;
+    bool grid_is_mapped;
+} Snapshot;
+
+uint64_t compute_snapshot_checksum(const Bit_Grid *grid);
+
+// Writes to a temporary file and renames it over path, so a crash never
+// leaves a torn snapshot behind. rule NULL means B3/S23. Returns false (and
+// logs) on I/O errors or a rule name too long for the header.
+bool save_snapshot(const char *path, const Bit_Grid *grid, uint64_t generation,
+                   const char *rule, Snapshot_Encoding encoding);
+// Maps path and verifies its checksum. Returns false (and logs) if the file
+// is missing, truncated or corrupt.
+bool open_snapshot(const char *path, Snapshot *snapshot);
+void close_snapshot(Snapshot *snapshot);
+
+// Writes snapshots of an engine on a background thread. The stepping thread
+// only pays for read_engine_grid; encoding and I/O happen on the writer.
+typedef struct Checkpointer Checkpointer;
+
+// rule is recorded in every snapshot written; NULL means B3/S23. Returns NULL
+// (and logs) if the rule name is too long for the header.
+Checkpointer *create_checkpointer(const char *path, int grid_w, int grid_h, const char *rule,
+                                  Snapshot_Encoding encoding);
+// Waits for an in-flight write to finish.
+void destroy_checkpointer(Checkpointer *checkpointer);
+// Captures the engine's grid and queues it for writing. Returns false without
+// capturing if the previous checkpoint is still being written.
+bool request_checkpoint(Checkpointer *checkpointer, Gol_Engine *engine);
+// Same, for a grid the caller already read back.
+bool request_checkpoint_of_grid(Checkpointer *checkpointer, const Bit_Grid *grid, uint64_t generation);
+
+#endif
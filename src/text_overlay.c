@@ -0,0 +1,173 @@
+#include "text_overlay.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glad/glad.h>
+
+#include "common.h"
+#include "gl_util.h"
+
+#define TEXT_OVERLAY_VERT_SHADER "res/shaders/text_overlay.vert.glsl"
+#define TEXT_OVERLAY_FRAG_SHADER "res/shaders/text_overlay.frag.glsl"
+
+enum {
+    GLYPH_W = 5,
+    GLYPH_H = 7,
+    // Glyph plus one texel of spacing, and a margin round the panel.
+    CELL_W = GLYPH_W + 1,
+    CELL_H = GLYPH_H + 2,
+    MARGIN = 3,
+    // Texels per pixel on screen.
+    TEXT_SCALE = 2,
+    OVERLAY_COLUMNS = 48,
+    OVERLAY_ROWS = 16,
+    FIRST_GLYPH = ' ',
+    GLYPH_COUNT = '~' - ' ' + 1
+};
+
+// Rows top to bottom, bit 4 the leftmost column. Missing glyphs are blank.
+static const uint8_t g_font[GLYPH_COUNT][GLYPH_H] = {
+    ['0' - FIRST_GLYPH] = { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E },
+    ['1' - FIRST_GLYPH] = { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E },
+    ['2' - FIRST_GLYPH] = { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F },
+    ['3' - FIRST_GLYPH] = { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E },
+    ['4' - FIRST_GLYPH] = { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 },
+    ['5' - FIRST_GLYPH] = { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E },
+    ['6' - FIRST_GLYPH] = { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E },
+    ['7' - FIRST_GLYPH] = { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 },
+    ['8' - FIRST_GLYPH] = { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E },
+    ['9' - FIRST_GLYPH] = { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C },
+    ['a' - FIRST_GLYPH] = { 0x00, 0x00, 0x0E, 0x01, 0x0F, 0x11, 0x0F },
+    ['b' - FIRST_GLYPH] = { 0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x1E },
+    ['c' - FIRST_GLYPH] = { 0x00, 0x00, 0x0E, 0x10, 0x10, 0x11, 0x0E },
+    ['d' - FIRST_GLYPH] = { 0x01, 0x01, 0x0D, 0x13, 0x11, 0x11, 0x0F },
+    ['e' - FIRST_GLYPH] = { 0x00, 0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E },
+    ['f' - FIRST_GLYPH] = { 0x06, 0x09, 0x08, 0x1C, 0x08, 0x08, 0x08 },
+    ['g' - FIRST_GLYPH] = { 0x00, 0x0F, 0x11, 0x11, 0x0F, 0x01, 0x0E },
+    ['h' - FIRST_GLYPH] = { 0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x11 },
+    ['i' - FIRST_GLYPH] = { 0x04, 0x00, 0x0C, 0x04, 0x04, 0x04, 0x0E },
+    ['j' - FIRST_GLYPH] = { 0x02, 0x00, 0x06, 0x02, 0x02, 0x12, 0x0C },
+    ['k' - FIRST_GLYPH] = { 0x10, 0x10, 0x12, 0x14, 0x18, 0x14, 0x12 },
+    ['l' - FIRST_GLYPH] = { 0x0C, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E },
+    ['m' - FIRST_GLYPH] = { 0x00, 0x00, 0x1A, 0x15, 0x15, 0x11, 0x11 },
+    ['n' - FIRST_GLYPH] = { 0x00, 0x00, 0x16, 0x19, 0x11, 0x11, 0x11 },
+    ['o' - FIRST_GLYPH] = { 0x00, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x0E },
+    ['p' - FIRST_GLYPH] = { 0x00, 0x00, 0x1E, 0x11, 0x1E, 0x10, 0x10 },
+    ['q' - FIRST_GLYPH] = { 0x00, 0x00, 0x0D, 0x13, 0x0F, 0x01, 0x01 },
+    ['r' - FIRST_GLYPH] = { 0x00, 0x00, 0x16, 0x19, 0x10, 0x10, 0x10 },
+    ['s' - FIRST_GLYPH] = { 0x00, 0x00, 0x0E, 0x10, 0x0E, 0x01, 0x1E },
+    ['t' - FIRST_GLYPH] = { 0x08, 0x08, 0x1C, 0x08, 0x08, 0x09, 0x06 },
+    ['u' - FIRST_GLYPH] = { 0x00, 0x00, 0x11, 0x11, 0x11, 0x13, 0x0D },
+    ['v' - FIRST_GLYPH] = { 0x00, 0x00, 0x11, 0x11, 0x11, 0x0A, 0x04 },
+    ['w' - FIRST_GLYPH] = { 0x00, 0x00, 0x11, 0x11, 0x15, 0x15, 0x0A },
+    ['x' - FIRST_GLYPH] = { 0x00, 0x00, 0x11, 0x0A, 0x04, 0x0A, 0x11 },
+    ['y' - FIRST_GLYPH] = { 0x00, 0x00, 0x11, 0x11, 0x0F, 0x01, 0x0E },
+    ['z' - FIRST_GLYPH] = { 0x00, 0x00, 0x1F, 0x02, 0x04, 0x08, 0x1F },
+    ['.' - FIRST_GLYPH] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C },
+    [',' - FIRST_GLYPH] = { 0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08 },
+    [':' - FIRST_GLYPH] = { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 },
+    ['/' - FIRST_GLYPH] = { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 },
+    ['-' - FIRST_GLYPH] = { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 },
+    ['_' - FIRST_GLYPH] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F },
+    ['%' - FIRST_GLYPH] = { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 },
+    ['(' - FIRST_GLYPH] = { 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 },
+    [')' - FIRST_GLYPH] = { 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 },
+};
+
+static int get_overlay_texture_w(const Text_Overlay *overlay) {
+    return overlay->columns * CELL_W + 2 * MARGIN;
+}
+
+static int get_overlay_texture_h(const Text_Overlay *overlay) {
+    return overlay->rows * CELL_H + 2 * MARGIN;
+}
+
+Text_Overlay create_text_overlay() {
+    Text_Overlay overlay = {0};
+    overlay.columns = OVERLAY_COLUMNS;
+    overlay.rows = OVERLAY_ROWS;
+    overlay.shader = build_shaders(TEXT_OVERLAY_VERT_SHADER, TEXT_OVERLAY_FRAG_SHADER);
+    // The quad comes from gl_VertexID, but the core profile still wants a
+    // vertex array bound to draw.
+    glGenVertexArrays(1, &overlay.vao);
+
+    int w = get_overlay_texture_w(&overlay);
+    int h = get_overlay_texture_h(&overlay);
+    overlay.pixels = xcalloc((size_t)w * h, 1);
+    glGenTextures(1, &overlay.texture);
+    glBindTexture(GL_TEXTURE_2D, overlay.texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, w, h, 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    set_text_overlay_text(&overlay, "");
+    return overlay;
+}
+
+void destroy_text_overlay(Text_Overlay *overlay) {
+    glDeleteProgram(overlay->shader);
+    glDeleteTextures(1, &overlay->texture);
+    glDeleteVertexArrays(1, &overlay->vao);
+    free(overlay->pixels);
+    memset(overlay, 0, sizeof(*overlay));
+}
+
+void set_text_overlay_text(Text_Overlay *overlay, const char *text) {
+    int w = get_overlay_texture_w(overlay);
+    int h = get_overlay_texture_h(overlay);
+    memset(overlay->pixels, 0, (size_t)w * h);
+
+    int column = 0;
+    int row = 0;
+    for (const char *c = text; *c && row < overlay->rows; c++) {
+        if (*c == '\n') {
+            column = 0;
+            row++;
+            continue;
+        }
+        int glyph = tolower((unsigned char)*c) - FIRST_GLYPH;
+        if (column < overlay->columns && glyph >= 0 && glyph < GLYPH_COUNT) {
+            int x0 = MARGIN + column * CELL_W;
+            int y0 = MARGIN + row * CELL_H;
+            for (int y = 0; y < GLYPH_H; y++) {
+                for (int x = 0; x < GLYPH_W; x++) {
+                    if ((g_font[glyph][y] >> (GLYPH_W - 1 - x)) & 1) {
+                        overlay->pixels[(size_t)(y0 + y) * w + x0 + x] = 255;
+                    }
+                }
+            }
+        }
+        column++;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, overlay->texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w, h, GL_RED, GL_UNSIGNED_BYTE, overlay->pixels);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void draw_text_overlay(const Text_Overlay *overlay, int window_w, int window_h) {
+    if (window_w <= 0 || window_h <= 0) {
+        return;
+    }
+    // Pinned to the top-left corner at a whole number of pixels per texel.
+    float w = 2.0f * get_overlay_texture_w(overlay) * TEXT_SCALE / window_w;
+    float h = 2.0f * get_overlay_texture_h(overlay) * TEXT_SCALE / window_h;
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glUseProgram(overlay->shader);
+    glUniform4f(glGetUniformLocation(overlay->shader, "rect"), -1.0f, 1.0f - h, w, h);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, overlay->texture);
+    glBindVertexArray(overlay->vao);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glUseProgram(0);
+    glDisable(GL_BLEND);
+}
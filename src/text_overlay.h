@@ -0,0 +1,26 @@
+#ifndef TEXT_OVERLAY_H
+#define TEXT_OVERLAY_H
+
+#include <stdint.h>
+
+// A few lines of text drawn over the top-left corner of the window, from a
+// built-in 5x7 bitmap font (digits, letters, which draw lowercase, and a
+// little punctuation). The text is rasterised on the CPU into a small R8
+// texture only when it changes, so drawing it is a single quad.
+
+typedef struct {
+    uint32_t shader;
+    uint32_t texture;
+    uint32_t vao;
+    uint8_t *pixels;
+    int columns;
+    int rows;
+} Text_Overlay;
+
+Text_Overlay create_text_overlay();
+void destroy_text_overlay(Text_Overlay *overlay);
+// Lines are separated by '\n'; text past the overlay's columns or rows is cut.
+void set_text_overlay_text(Text_Overlay *overlay, const char *text);
+void draw_text_overlay(const Text_Overlay *overlay, int window_w, int window_h);
+
+#endif
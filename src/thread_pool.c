@@ -0,0 +1,237 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "thread_pool.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "common.h"
+#include "profiler.h"
+
+enum {
+    CACHE_LINE_SIZE = 64,
+    // Polls of the job epoch before a worker parks on the condition variable.
+    WORKER_SPIN_LIMIT = 4096
+};
+
+// A worker's remaining task slice, begin in the low half and end in the high
+// half, so owner pops and thief splits both go through one CAS.
+typedef struct {
+    uint64_t range;
+    char padding[CACHE_LINE_SIZE - sizeof(uint64_t)];
+} Worker_Queue;
+
+typedef struct {
+    Thread_Pool *pool;
+    int worker_index;
+} Worker_Start;
+
+struct Thread_Pool {
+    int thread_count;
+    pthread_t *threads;
+    Worker_Start *starts;
+    Worker_Queue *queues;
+
+    Thread_Pool_Task task;
+    void *task_ctx;
+
+    uint32_t job_epoch;
+    int32_t workers_busy;
+    int32_t sleepers;
+    bool shutting_down;
+
+    pthread_mutex_t sleep_mutex;
+    pthread_cond_t wake_cond;
+};
+
+static inline uint64_t pack_range(uint32_t begin, uint32_t end) {
+    return (uint64_t)begin | ((uint64_t)end << 32);
+}
+
+static int pop_own_task(Worker_Queue *queue) {
+    uint64_t range = __atomic_load_n(&queue->range, __ATOMIC_ACQUIRE);
+    for (;;) {
+        uint32_t begin = (uint32_t)range;
+        uint32_t end = (uint32_t)(range >> 32);
+        if (begin >= end) {
+            return -1;
+        }
+        if (__atomic_compare_exchange_n(&queue->range, &range, pack_range(begin + 1, end),
+                                        true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            return (int)begin;
+        }
+    }
+}
+
+// Moves the back half of some other worker's slice into this worker's queue.
+static bool steal_tasks(Thread_Pool *pool, int thief) {
+    for (int offset = 1; offset < pool->thread_count; offset++) {
+        Worker_Queue *victim = &pool->queues[(thief + offset) % pool->thread_count];
+        uint64_t range = __atomic_load_n(&victim->range, __ATOMIC_ACQUIRE);
+        for (;;) {
+            uint32_t begin = (uint32_t)range;
+            uint32_t end = (uint32_t)(range >> 32);
+            if (begin >= end) {
+                break;
+            }
+            uint32_t take = (end - begin + 1) / 2;
+            if (__atomic_compare_exchange_n(&victim->range, &range, pack_range(begin, end - take),
+                                            true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                __atomic_store_n(&pool->queues[thief].range, pack_range(end - take, end), __ATOMIC_RELEASE);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static void run_worker_tasks(Thread_Pool *pool, int worker_index) {
+    Worker_Queue *own = &pool->queues[worker_index];
+    for (;;) {
+        int task_index = pop_own_task(own);
+        if (task_index >= 0) {
+            pool->task(pool->task_ctx, task_index, worker_index);
+        } else if (!steal_tasks(pool, worker_index)) {
+            return;
+        }
+    }
+}
+
+static uint32_t wait_for_new_job(Thread_Pool *pool, uint32_t seen_epoch) {
+    for (int spin = 0; spin < WORKER_SPIN_LIMIT; spin++) {
+        uint32_t epoch = __atomic_load_n(&pool->job_epoch, __ATOMIC_ACQUIRE);
+        if (epoch != seen_epoch) {
+            return epoch;
+        }
+        sched_yield();
+    }
+
+    pthread_mutex_lock(&pool->sleep_mutex);
+    __atomic_add_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+    uint32_t epoch;
+    while ((epoch = __atomic_load_n(&pool->job_epoch, __ATOMIC_SEQ_CST)) == seen_epoch) {
+        pthread_cond_wait(&pool->wake_cond, &pool->sleep_mutex);
+    }
+    __atomic_sub_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&pool->sleep_mutex);
+    return epoch;
+}
+
+static void *worker_main(void *arg) {
+    Worker_Start *start = arg;
+    Thread_Pool *pool = start->pool;
+    uint32_t seen_epoch = 0;
+
+    for (;;) {
+        seen_epoch = wait_for_new_job(pool, seen_epoch);
+        if (__atomic_load_n(&pool->shutting_down, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+        Profile_Zone zone = begin_profile_zone("pool_tasks");
+        run_worker_tasks(pool, start->worker_index);
+        end_profile_zone(zone);
+        __atomic_sub_fetch(&pool->workers_busy, 1, __ATOMIC_ACQ_REL);
+    }
+    return NULL;
+}
+
+static void publish_job(Thread_Pool *pool) {
+    __atomic_add_fetch(&pool->job_epoch, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&pool->sleepers, __ATOMIC_SEQ_CST) > 0) {
+        pthread_mutex_lock(&pool->sleep_mutex);
+        pthread_cond_broadcast(&pool->wake_cond);
+        pthread_mutex_unlock(&pool->sleep_mutex);
+    }
+}
+
+int get_online_cpu_count() {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+}
+
+Thread_Pool *create_thread_pool(int thread_count) {
+    if (thread_count <= 0) {
+        thread_count = get_online_cpu_count();
+    }
+
+    Thread_Pool *pool = xcalloc(1, sizeof(Thread_Pool));
+    pool->thread_count = thread_count;
+
+    void *queues = NULL;
+    if (posix_memalign(&queues, CACHE_LINE_SIZE, thread_count * sizeof(Worker_Queue)) != 0) {
+        exit_with_error("Failed to allocate thread pool queues");
+    }
+    pool->queues = queues;
+    for (int i = 0; i < thread_count; i++) {
+        pool->queues[i].range = 0;
+    }
+
+    pthread_mutex_init(&pool->sleep_mutex, NULL);
+    pthread_cond_init(&pool->wake_cond, NULL);
+
+    pool->threads = xcalloc(thread_count, sizeof(pthread_t));
+    pool->starts = xcalloc(thread_count, sizeof(Worker_Start));
+    for (int i = 1; i < thread_count; i++) {
+        pool->starts[i].pool = pool;
+        pool->starts[i].worker_index = i;
+        if (pthread_create(&pool->threads[i], NULL, worker_main, &pool->starts[i]) != 0) {
+            exit_with_error("Failed to create worker thread %d", i);
+        }
+    }
+
+    return pool;
+}
+
+void destroy_thread_pool(Thread_Pool *pool) {
+    if (!pool) {
+        return;
+    }
+
+    __atomic_store_n(&pool->shutting_down, true, __ATOMIC_RELEASE);
+    publish_job(pool);
+    for (int i = 1; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool->wake_cond);
+    pthread_mutex_destroy(&pool->sleep_mutex);
+    free(pool->threads);
+    free(pool->starts);
+    free(pool->queues);
+    free(pool);
+}
+
+int get_thread_pool_size(const Thread_Pool *pool) {
+    return pool->thread_count;
+}
+
+void run_thread_pool_tasks(Thread_Pool *pool, Thread_Pool_Task task, void *ctx, int task_count) {
+    if (task_count <= 0) {
+        return;
+    }
+
+    pool->task = task;
+    pool->task_ctx = ctx;
+
+    for (int i = 0; i < pool->thread_count; i++) {
+        uint32_t begin = (uint32_t)((int64_t)task_count * i / pool->thread_count);
+        uint32_t end = (uint32_t)((int64_t)task_count * (i + 1) / pool->thread_count);
+        __atomic_store_n(&pool->queues[i].range, pack_range(begin, end), __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&pool->workers_busy, pool->thread_count - 1, __ATOMIC_RELAXED);
+
+    publish_job(pool);
+    Profile_Zone zone = begin_profile_zone("pool_tasks");
+    run_worker_tasks(pool, 0);
+    end_profile_zone(zone);
+
+    zone = begin_profile_zone("pool_wait");
+    while (__atomic_load_n(&pool->workers_busy, __ATOMIC_ACQUIRE) > 0) {
+        sched_yield();
+    }
+    end_profile_zone(zone);
+}
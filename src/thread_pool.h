@@ -0,0 +1,23 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+// Persistent worker threads for data-parallel jobs. A job is a range of task
+// indices; each worker starts on its own contiguous slice and, once that runs
+// dry, steals half of the remaining slice of another worker. Claiming a task is
+// a single CAS, so there are no locks on the per-task path. The calling thread
+// takes part as worker 0, and run_thread_pool_tasks returns only once every
+// task has finished, which makes each call a barrier.
+
+typedef struct Thread_Pool Thread_Pool;
+
+typedef void (*Thread_Pool_Task)(void *ctx, int task_index, int worker_index);
+
+// thread_count <= 0 picks one worker per online CPU.
+Thread_Pool *create_thread_pool(int thread_count);
+void destroy_thread_pool(Thread_Pool *pool);
+int get_thread_pool_size(const Thread_Pool *pool);
+void run_thread_pool_tasks(Thread_Pool *pool, Thread_Pool_Task task, void *ctx, int task_count);
+
+int get_online_cpu_count();
+
+#endif